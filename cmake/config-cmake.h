@@ -87,6 +87,9 @@
 /* Define to 1 if you have the 'flock' function. */
 #cmakedefine HAVE_FLOCK 1
 
+/* Define to 1 if you have the 'mmap' function. */
+#cmakedefine HAVE_MMAP 1
+
 /* Define to 1 if you have the 'strlcpy' function. */
 #cmakedefine HAVE_LIBC_STRLCPY 1
 
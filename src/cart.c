@@ -99,7 +99,7 @@ bool Cart_UseBuiltinCartridge(void)
 #define NEEDS_CART (TRACE_OS_GEMDOS | TRACE_OS_BASE | TRACE_OS_VDI | TRACE_OS_AES)
 	return (bUseVDIRes || INF_Overriding(AUTOSTART_INTERCEPT) ||
 	        ConfigureParams.HardDisk.bUseHardDiskDirectories ||
-	        LOG_TRACE_LEVEL(NEEDS_CART))
+	        (LogTraceFlags & NEEDS_CART))
 	       && (TosVersion >= 0x100 || !bUseTos);
 }
 
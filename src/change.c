@@ -52,6 +52,18 @@ const char Change_fileid[] = "Hatari change.c";
 #define Dprintf(...)
 #endif
 
+/*-----------------------------------------------------------------------*/
+/**
+ * Return true if disk image overlay settings were changed,
+ * which requires re-opening all hard disk images.
+ */
+static bool Change_DidOverlaysChange(CNF_PARAMS *current, CNF_PARAMS *changed)
+{
+	return changed->HardDisk.bUseImageOverlays != current->HardDisk.bUseImageOverlays
+	    || (strcmp(changed->HardDisk.szImageOverlayDir, current->HardDisk.szImageOverlayDir)
+	        && changed->HardDisk.bUseImageOverlays);
+}
+
 /*-----------------------------------------------------------------------*/
 /**
  * Check if user needs to be warned that changes will take place after reset.
@@ -83,6 +95,10 @@ bool Change_DoNeedReset(CNF_PARAMS *current, CNF_PARAMS *changed)
 	if (strcmp(changed->Rom.szTosImageFileName, current->Rom.szTosImageFileName))
 		return true;
 
+	/* Did change disk image overlays? */
+	if (Change_DidOverlaysChange(current, changed))
+		return true;
+
 	/* Did change ACSI hard disk image? */
 	for (i = 0; i < MAX_ACSI_DEVS; i++)
 	{
@@ -292,6 +308,13 @@ void Change_CopyChangedParamsToConfiguration(CNF_PARAMS *current, CNF_PARAMS *ch
 		bReInitGemdosDrive = true;
 	}
 
+	/* Did change disk image overlays? */
+	if (Change_DidOverlaysChange(current, changed))
+	{
+		Dprintf("- disk image overlays>\n");
+		bReInitHdcEmu = bReInitScsiEmu = bReInitIDEEmu = true;
+	}
+
 	/* Did change ACSI images? */
 	for (i = 0; i < MAX_ACSI_DEVS; i++)
 	{
@@ -49,6 +49,7 @@ static const struct Config_Tag configs_Log[] =
 {
 	{ "sLogFileName", String_Tag, ConfigureParams.Log.sLogFileName },
 	{ "sTraceFileName", String_Tag, ConfigureParams.Log.sTraceFileName },
+	{ "sTraceBinFileName", String_Tag, ConfigureParams.Log.sTraceBinFileName },
 	{ "nTextLogLevel", Int_Tag, &ConfigureParams.Log.nTextLogLevel },
 	{ "nAlertDlgLogLevel", Int_Tag, &ConfigureParams.Log.nAlertDlgLogLevel },
 	{ "bConfirmQuit", Bool_Tag, &ConfigureParams.Log.bConfirmQuit },
@@ -317,6 +318,8 @@ static const struct Config_Tag configs_HardDisk[] =
 	{ "nWriteProtection", Int_Tag, &ConfigureParams.HardDisk.nWriteProtection },
 	{ "bFilenameConversion", Bool_Tag, &ConfigureParams.HardDisk.bFilenameConversion },
 	{ "bGemdosHostTime", Bool_Tag, &ConfigureParams.HardDisk.bGemdosHostTime },
+	{ "bUseImageOverlays", Bool_Tag, &ConfigureParams.HardDisk.bUseImageOverlays },
+	{ "szImageOverlayDir", String_Tag, ConfigureParams.HardDisk.szImageOverlayDir },
 	{ NULL , Error_Tag, NULL }
 };
 
@@ -483,6 +486,7 @@ static const struct Config_Tag configs_System[] =
 	{ "bPatchTimerD", Bool_Tag, &ConfigureParams.System.bPatchTimerD },
 	{ "bFastBoot", Bool_Tag, &ConfigureParams.System.bFastBoot },
 	{ "bFastForward", Bool_Tag, &ConfigureParams.System.bFastForward },
+	{ "bSkipSpinLoops", Bool_Tag, &ConfigureParams.System.bSkipSpinLoops },
 	{ "bAddressSpace24", Bool_Tag, &ConfigureParams.System.bAddressSpace24 },
 	{ "bCycleExactCpu", Bool_Tag, &ConfigureParams.System.bCycleExactCpu },
 	{ "n_FPUType", Int_Tag, &ConfigureParams.System.n_FPUType },
@@ -574,6 +578,8 @@ void Configuration_SetDefault(void)
 	ConfigureParams.HardDisk.nWriteProtection = WRITEPROT_OFF;
 	ConfigureParams.HardDisk.nGemdosDrive = DRIVE_C;
 	ConfigureParams.HardDisk.bUseHardDiskDirectories = false;
+	ConfigureParams.HardDisk.bUseImageOverlays = false;
+	ConfigureParams.HardDisk.szImageOverlayDir[0] = '\0';
 	for (i = 0; i < MAX_HARDDRIVES; i++)
 	{
 		strcpy(ConfigureParams.HardDisk.szHardDiskDirectories[i], psWorkingDir);
@@ -775,6 +781,7 @@ void Configuration_SetDefault(void)
 	ConfigureParams.System.bPatchTimerD = false;
 	ConfigureParams.System.bFastBoot = false;
 	ConfigureParams.System.bFastForward = false;
+	ConfigureParams.System.bSkipSpinLoops = false;
 
 	/* Set defaults for Video */
 #if HAVE_LIBPNG
@@ -915,6 +922,8 @@ void Configuration_Apply(bool bReset)
 	/* make path names absolute, but handle special file names */
 	File_MakeAbsoluteSpecialName(ConfigureParams.Log.sLogFileName);
 	File_MakeAbsoluteSpecialName(ConfigureParams.Log.sTraceFileName);
+	if (ConfigureParams.Log.sTraceBinFileName[0])
+		File_MakeAbsoluteName(ConfigureParams.Log.sTraceBinFileName);
 	File_MakeAbsoluteSpecialName(ConfigureParams.RS232.szInFileName);
 	File_MakeAbsoluteSpecialName(ConfigureParams.RS232.szOutFileName);
 //	File_MakeAbsoluteSpecialName(ConfigureParams.RS232.sSccBInFileName);
@@ -76,24 +76,39 @@ static void Line_ConvertLowRes_640x16Bit_Spec(Uint32 *edi, Uint32 *ebp, Uint32 *
 		/* And plot, the Spec512 is offset by 1 pixel and works on 'chunks' of 4 pixels */
 		/* So, we plot 1_4_4_4_3 to give 16 pixels, changing palette between */
 		/* (last one is used for first of next 16-pixels) */
-		ecx = pixelspace[0];
-		PLOT_SPEC512_LEFT_LOW_640_16BIT(0);
-		Spec512_UpdatePaletteSpan();
-
-		ecx = GET_SPEC512_OFFSET_PIXELS(pixelspace, 1);
-		PLOT_SPEC512_MID_640_16BIT(1);
-		Spec512_UpdatePaletteSpan();
-
-		ecx = GET_SPEC512_OFFSET_PIXELS(pixelspace, 5);
-		PLOT_SPEC512_MID_640_16BIT(5);
-		Spec512_UpdatePaletteSpan();
-
-		ecx = GET_SPEC512_OFFSET_PIXELS(pixelspace, 9);
-		PLOT_SPEC512_MID_640_16BIT(9);
-		Spec512_UpdatePaletteSpan();
-
-		ecx = GET_SPEC512_OFFSET_FINAL_PIXELS(pixelspace);
-		PLOT_SPEC512_END_LOW_640_16BIT(13);
+		if (Spec512_SkipPaletteSpans(4))
+		{
+			/* No palette change during these 16 pixels, plot them in one go */
+			ecx = pixelspace[0];
+			PLOT_SPEC512_MID_640_16BIT(0);
+			ecx = pixelspace[1];
+			PLOT_SPEC512_MID_640_16BIT(4);
+			ecx = pixelspace[2];
+			PLOT_SPEC512_MID_640_16BIT(8);
+			ecx = pixelspace[3];
+			PLOT_SPEC512_MID_640_16BIT(12);
+		}
+		else
+		{
+			ecx = pixelspace[0];
+			PLOT_SPEC512_LEFT_LOW_640_16BIT(0);
+			Spec512_UpdatePaletteSpan();
+
+			ecx = GET_SPEC512_OFFSET_PIXELS(pixelspace, 1);
+			PLOT_SPEC512_MID_640_16BIT(1);
+			Spec512_UpdatePaletteSpan();
+
+			ecx = GET_SPEC512_OFFSET_PIXELS(pixelspace, 5);
+			PLOT_SPEC512_MID_640_16BIT(5);
+			Spec512_UpdatePaletteSpan();
+
+			ecx = GET_SPEC512_OFFSET_PIXELS(pixelspace, 9);
+			PLOT_SPEC512_MID_640_16BIT(9);
+			Spec512_UpdatePaletteSpan();
+
+			ecx = GET_SPEC512_OFFSET_FINAL_PIXELS(pixelspace);
+			PLOT_SPEC512_END_LOW_640_16BIT(13);
+		}
 
 		esi += 16;                  /* Next PC pixels */
 		edi += 2;                   /* Next ST pixels */
@@ -76,24 +76,39 @@ static void Line_ConvertLowRes_640x32Bit_Spec(Uint32 *edi, Uint32 *ebp, Uint32 *
 		/* And plot, the Spec512 is offset by 1 pixel and works on 'chunks' of 4 pixels */
 		/* So, we plot 1_4_4_4_3 to give 16 pixels, changing palette between */
 		/* (last one is used for first of next 16-pixels) */
-		ecx = pixelspace[0];
-		PLOT_SPEC512_LEFT_LOW_640_32BIT(0);
-		Spec512_UpdatePaletteSpan();
-
-		ecx = GET_SPEC512_OFFSET_PIXELS(pixelspace, 1);
-		PLOT_SPEC512_MID_640_32BIT(2);
-		Spec512_UpdatePaletteSpan();
-
-		ecx = GET_SPEC512_OFFSET_PIXELS(pixelspace, 5);
-		PLOT_SPEC512_MID_640_32BIT(10);
-		Spec512_UpdatePaletteSpan();
-
-		ecx = GET_SPEC512_OFFSET_PIXELS(pixelspace, 9);
-		PLOT_SPEC512_MID_640_32BIT(18);
-		Spec512_UpdatePaletteSpan();
-
-		ecx = GET_SPEC512_OFFSET_FINAL_PIXELS(pixelspace);
-		PLOT_SPEC512_END_LOW_640_32BIT(26);
+		if (Spec512_SkipPaletteSpans(4))
+		{
+			/* No palette change during these 16 pixels, plot them in one go */
+			ecx = pixelspace[0];
+			PLOT_SPEC512_MID_640_32BIT(0);
+			ecx = pixelspace[1];
+			PLOT_SPEC512_MID_640_32BIT(8);
+			ecx = pixelspace[2];
+			PLOT_SPEC512_MID_640_32BIT(16);
+			ecx = pixelspace[3];
+			PLOT_SPEC512_MID_640_32BIT(24);
+		}
+		else
+		{
+			ecx = pixelspace[0];
+			PLOT_SPEC512_LEFT_LOW_640_32BIT(0);
+			Spec512_UpdatePaletteSpan();
+
+			ecx = GET_SPEC512_OFFSET_PIXELS(pixelspace, 1);
+			PLOT_SPEC512_MID_640_32BIT(2);
+			Spec512_UpdatePaletteSpan();
+
+			ecx = GET_SPEC512_OFFSET_PIXELS(pixelspace, 5);
+			PLOT_SPEC512_MID_640_32BIT(10);
+			Spec512_UpdatePaletteSpan();
+
+			ecx = GET_SPEC512_OFFSET_PIXELS(pixelspace, 9);
+			PLOT_SPEC512_MID_640_32BIT(18);
+			Spec512_UpdatePaletteSpan();
+
+			ecx = GET_SPEC512_OFFSET_FINAL_PIXELS(pixelspace);
+			PLOT_SPEC512_END_LOW_640_32BIT(26);
+		}
 
 		esi += 32;                  /* Next PC pixels */
 		edi += 2;                   /* Next ST pixels */
@@ -82,24 +82,39 @@ static void Line_ConvertMediumRes_640x32Bit_Spec(Uint32 *edi, Uint32 *ebp, Uint3
 		/* (last one is used for first of next 16-pixels) */
 		/* NOTE : In med res, we display 16 pixels in 8 cycles, so palette should be */
 		/* updated every 8 pixels, not every 4 pixels (as in low res) */
-		ecx = pixelspace[0];
-		PLOT_SPEC512_LEFT_MED_640_32BIT(0);
-//		Spec512_UpdatePaletteSpan();
-
-		ecx = GET_SPEC512_OFFSET_PIXELS(pixelspace, 1);
-		PLOT_SPEC512_MID_MED_640_32BIT(1);
-		Spec512_UpdatePaletteSpan();
-
-		ecx = GET_SPEC512_OFFSET_PIXELS(pixelspace, 5);
-		PLOT_SPEC512_MID_MED_640_32BIT(5);
-//		Spec512_UpdatePaletteSpan();
-
-		ecx = GET_SPEC512_OFFSET_PIXELS(pixelspace, 9);
-		PLOT_SPEC512_MID_MED_640_32BIT(9);
-		Spec512_UpdatePaletteSpan();
-
-		ecx = GET_SPEC512_OFFSET_FINAL_PIXELS(pixelspace);
-		PLOT_SPEC512_END_MED_640_32BIT(13);
+		if (Spec512_SkipPaletteSpans(2))
+		{
+			/* No palette change during these 16 pixels, plot them in one go */
+			ecx = pixelspace[0];
+			PLOT_SPEC512_MID_MED_640_32BIT(0);
+			ecx = pixelspace[1];
+			PLOT_SPEC512_MID_MED_640_32BIT(4);
+			ecx = pixelspace[2];
+			PLOT_SPEC512_MID_MED_640_32BIT(8);
+			ecx = pixelspace[3];
+			PLOT_SPEC512_MID_MED_640_32BIT(12);
+		}
+		else
+		{
+			ecx = pixelspace[0];
+			PLOT_SPEC512_LEFT_MED_640_32BIT(0);
+//			Spec512_UpdatePaletteSpan();
+
+			ecx = GET_SPEC512_OFFSET_PIXELS(pixelspace, 1);
+			PLOT_SPEC512_MID_MED_640_32BIT(1);
+			Spec512_UpdatePaletteSpan();
+
+			ecx = GET_SPEC512_OFFSET_PIXELS(pixelspace, 5);
+			PLOT_SPEC512_MID_MED_640_32BIT(5);
+//			Spec512_UpdatePaletteSpan();
+
+			ecx = GET_SPEC512_OFFSET_PIXELS(pixelspace, 9);
+			PLOT_SPEC512_MID_MED_640_32BIT(9);
+			Spec512_UpdatePaletteSpan();
+
+			ecx = GET_SPEC512_OFFSET_FINAL_PIXELS(pixelspace);
+			PLOT_SPEC512_END_MED_640_32BIT(13);
+		}
 
 		esi += 16;                      /* Next PC pixels */
 		edi += 1;                       /* Next ST pixels */
@@ -32,6 +32,7 @@
 #include "sysdeps.h"
 
 #ifdef WINUAE_FOR_HATARI
+#include <inttypes.h>
 #include "main.h"
 #include "hatari-glue.h"
 #include "log.h"
@@ -91,17 +92,33 @@ static uae_u32 mmu030_table_search(uaecptr addr, uae_u32 fc, bool write, int lev
 static TT_info mmu030_decode_tt(uae_u32 TT);
 
 #if MMU_DPAGECACHE030
-#define MMUFASTCACHE_ENTRIES030 256
+/* Translation cache in front of the (much smaller) emulated ATC.
+ * 4-way set associative, keyed by logical page and function code.
+ * Ways of each set are kept in most recently used order.
+ */
+#define MMUFASTCACHE_SETS030 256
+#define MMUFASTCACHE_WAYS030 4
 struct mmufastcache030
 {
 	uae_u32 log;
 	uae_u32 phys;
+	uae_u8 *host;	/* host pointer to the page for direct RAM/ROM access, or NULL */
+	addrbank *bank;	/* bank the host pointer was taken from */
 	uae_u8 cs;
 };
-static struct mmufastcache030 atc_data_cache_read[MMUFASTCACHE_ENTRIES030];
-static struct mmufastcache030 atc_data_cache_write[MMUFASTCACHE_ENTRIES030];
+static struct mmufastcache030 atc_data_cache_read[MMUFASTCACHE_SETS030][MMUFASTCACHE_WAYS030];
+static struct mmufastcache030 atc_data_cache_write[MMUFASTCACHE_SETS030][MMUFASTCACHE_WAYS030];
 #endif
 
+/* ATC hit-rate statistics, shown by the debugger */
+static struct {
+	uae_u64 fast_hits;
+	uae_u64 fast_misses;
+	uae_u64 atc_lookups;
+	uae_u64 atc_hits;
+	uae_u64 table_searches;
+} mmu030_stats;
+
 /* for debugging messages */
 static char table_letter[4] = {'A','B','C','D'};
 
@@ -219,6 +236,87 @@ static struct {
 #define MMUSR_TRANSP_ACCESS     0x0040
 #define MMUSR_NUM_LEVELS_MASK   0x0007
 
+/* -- Translation fast cache -- */
+
+#if MMU_DPAGECACHE030
+/* Fast cache key: logical page number in upper bits, function code in lowest 3 bits */
+STATIC_INLINE uae_u32 mmu030_fastcache_key(uaecptr addr, uae_u32 fc)
+{
+	return ((addr & mmu030.translation.page.imask) >> mmu030.translation.page.size3m) | fc;
+}
+
+/* Set for given key, selected by page number only, so that all
+ * function codes for a page are in the same set */
+STATIC_INLINE struct mmufastcache030 *mmu030_fastcache_set(struct mmufastcache030 cache[][MMUFASTCACHE_WAYS030], uae_u32 key)
+{
+	return cache[((key >> 3) ^ (key >> 11)) & (MMUFASTCACHE_SETS030 - 1)];
+}
+
+/* Return fast cache entry for given logical address and function code,
+ * or NULL if there's none.  Hit entry is moved to the front of its set.
+ */
+STATIC_INLINE struct mmufastcache030 *mmu030_fastcache_find(struct mmufastcache030 cache[][MMUFASTCACHE_WAYS030], uaecptr addr, uae_u32 fc)
+{
+	uae_u32 key = mmu030_fastcache_key(addr, fc);
+	struct mmufastcache030 *set = mmu030_fastcache_set(cache, key);
+
+	if (set[0].log == key) {
+		mmu030_stats.fast_hits++;
+		return &set[0];
+	}
+	for (int i = 1; i < MMUFASTCACHE_WAYS030; i++) {
+		if (set[i].log == key) {
+			struct mmufastcache030 hit = set[i];
+			memmove(&set[1], &set[0], i * sizeof(*set));
+			set[0] = hit;
+			mmu030_stats.fast_hits++;
+			return &set[0];
+		}
+	}
+	mmu030_stats.fast_misses++;
+	return NULL;
+}
+
+/* Add translation to the front of its set, replacing either an
+ * existing entry for the same key, or the least recently used one.
+ */
+static void mmu030_fastcache_add(struct mmufastcache030 cache[][MMUFASTCACHE_WAYS030], uaecptr addr, uaecptr phys, uae_u32 fc, bool write)
+{
+	uae_u32 key = mmu030_fastcache_key(addr, fc);
+	struct mmufastcache030 *set = mmu030_fastcache_set(cache, key);
+	addrbank *ab = &get_mem_bank(phys);
+	uae_u8 *base = write ? ab->baseaddr_direct_w : ab->baseaddr_direct_r;
+	int i;
+
+	for (i = 0; i < MMUFASTCACHE_WAYS030 - 1; i++) {
+		if (set[i].log == key)
+			break;
+	}
+	memmove(&set[1], &set[0], i * sizeof(*set));
+
+	set[0].log = key;
+	set[0].phys = phys;
+	set[0].cs = mmu030_cache_state;
+	set[0].bank = ab;
+	/* memory timings in cycle exact mode need the x_phys_* accessors */
+	if (base && !currprefs.cpu_memory_cycle_exact)
+		set[0].host = base + ((phys - ab->startaccessmask) & ab->mask);
+	else
+		set[0].host = NULL;
+}
+
+/* Host pointer for physical address on given fast cache entry page,
+ * or NULL if the page isn't directly accessible, or its bank has been
+ * remapped after the entry was added (e.g. by debugger memory hooks).
+ */
+STATIC_INLINE uae_u8 *mmu030_fastcache_host(const struct mmufastcache030 *e, uaecptr phys)
+{
+	if (e->host && &get_mem_bank(phys) == e->bank)
+		return e->host + (phys & mmu030.translation.page.mask);
+	return NULL;
+}
+#endif
+
 /* -- ATC flushing functions -- */
 
 static void mmu030_flush_cache(uaecptr addr)
@@ -231,12 +329,14 @@ static void mmu030_flush_cache(uaecptr addr)
 		memset(&atc_data_cache_read, 0xff, sizeof atc_data_cache_read);
 		memset(&atc_data_cache_write, 0xff, sizeof atc_data_cache_write);
 	} else {
-		uae_u32 idx = ((addr & mmu030.translation.page.imask) >> mmu030.translation.page.size3m) | 7;
-		for (int i = 0; i < MMUFASTCACHE_ENTRIES030; i++) {
-			if ((atc_data_cache_read[i].log | 7) == idx)
-				atc_data_cache_read[i].log = 0xffffffff;
-			if ((atc_data_cache_write[i].log | 7) == idx)
-				atc_data_cache_write[i].log = 0xffffffff;
+		uae_u32 key = mmu030_fastcache_key(addr, 7);
+		struct mmufastcache030 *rset = mmu030_fastcache_set(atc_data_cache_read, key);
+		struct mmufastcache030 *wset = mmu030_fastcache_set(atc_data_cache_write, key);
+		for (int i = 0; i < MMUFASTCACHE_WAYS030; i++) {
+			if ((rset[i].log | 7) == key)
+				rset[i].log = 0xffffffff;
+			if ((wset[i].log | 7) == key)
+				wset[i].log = 0xffffffff;
 		}
 	}
 #endif
@@ -456,6 +556,10 @@ bool mmu_op30_pmove (uaecptr pc, uae_u32 opcode, uae_u16 next, uaecptr extra)
     
     if (!fd && !rw && preg != 0x18) {
         mmu030_flush_atc_all();
+    } else if (!rw && preg != 0x18) {
+        /* FD keeps the ATC, but the translation fast cache
+         * is not architecturally visible and keyed by page size */
+        mmu030_flush_cache(0xffffffff);
     }
 	tt_enabled = (tt0_030 & TT_ENABLE) || (tt1_030 & TT_ENABLE);
 	return false;
@@ -1227,6 +1331,7 @@ static void desc_get_quad(uaecptr addr, uae_u32 *descr)
  * for PTEST (levels 1 to 7). Using level 0 creates an ATC entry. */
 
 static uae_u32 mmu030_table_search(uaecptr addr, uae_u32 fc, bool write, int level) {
+    mmu030_stats.table_searches++;
     /* During table walk up to 7 different descriptors are used:
      * root pointer, descriptors fetched from function code lookup table,
      * tables A, B, C and D and one indirect descriptor */
@@ -1906,26 +2011,14 @@ bool mmu030_is_super_access(bool read)
 static void mmu030_add_data_read_cache(uaecptr addr, uaecptr phys, uae_u32 fc)
 {
 #if MMU_DPAGECACHE030
-	uae_u32 idx1 = ((addr & mmu030.translation.page.imask) >>  mmu030.translation.page.size3m) | fc;
-	uae_u32 idx2 = idx1 & (MMUFASTCACHE_ENTRIES030 - 1);
-	if (idx2 < MMUFASTCACHE_ENTRIES030 - 1) {
-		atc_data_cache_read[idx2].log = idx1;
-		atc_data_cache_read[idx2].phys = phys;
-		atc_data_cache_read[idx2].cs = mmu030_cache_state;
-	}
+	mmu030_fastcache_add(atc_data_cache_read, addr, phys, fc, false);
 #endif
 }
 
 static void mmu030_add_data_write_cache(uaecptr addr, uaecptr phys, uae_u32 fc)
 {
 #if MMU_DPAGECACHE030
-	uae_u32 idx1 = ((addr & mmu030.translation.page.imask) >>  mmu030.translation.page.size3m) | fc;
-	uae_u32 idx2 = idx1 & (MMUFASTCACHE_ENTRIES030 - 1);
-	if (idx2 < MMUFASTCACHE_ENTRIES030 - 1) {
-		atc_data_cache_write[idx2].log = idx1;
-		atc_data_cache_write[idx2].phys = phys;
-		atc_data_cache_write[idx2].cs = mmu030_cache_state;
-	}
+	mmu030_fastcache_add(atc_data_cache_write, addr, phys, fc, true);
 #endif
 }
 
@@ -1973,6 +2066,20 @@ static uaecptr mmu030_get_atc(uaecptr addr, int l, uae_u32 fc, uae_u32 size) {
 	return physical_addr + page_index;
 }
 
+/* Set last instruction page from given translation and mmu030_cache_state */
+static void mmu030_set_i_page(uaecptr addr, uaecptr physical_addr, uae_u32 fc)
+{
+#if MMU_IPAGECACHE030
+	mmu030.mmu030_cache_state = mmu030_cache_state;
+#if MMU_DIRECT_ACCESS
+	mmu030.mmu030_last_physical_address_real = get_real_address(physical_addr);
+#else
+	mmu030.mmu030_last_physical_address = physical_addr;
+#endif
+	mmu030.mmu030_last_logical_address = (addr & mmu030.translation.page.imask) | fc;
+#endif
+}
+
 static uaecptr mmu030_get_i_atc(uaecptr addr, int l, uae_u32 fc, uae_u32 size) {
 	uae_u32 page_index = addr & mmu030.translation.page.mask;
 	uae_u32 addr_mask = mmu030.translation.page.imask;
@@ -1988,18 +2095,11 @@ static uaecptr mmu030_get_i_atc(uaecptr addr, int l, uae_u32 fc, uae_u32 size) {
 		return 0;
 	}
 
-#if MMU_IPAGECACHE030
-	mmu030.mmu030_cache_state = mmu030.atc[l].physical.cache_inhibit;
-#if MMU_DIRECT_ACCESS
-	mmu030.mmu030_last_physical_address_real = get_real_address(physical_addr);
-#else
-	mmu030.mmu030_last_physical_address = physical_addr;
-#endif
-	mmu030.mmu030_last_logical_address = (addr & mmu030.translation.page.imask) | fc;
-#endif
-
 	mmu030_cache_state = mmu030.atc[l].physical.cache_inhibit;
 
+	mmu030_set_i_page(addr, physical_addr, fc);
+	mmu030_add_data_read_cache(addr, physical_addr, fc);
+
 	return physical_addr + page_index;
 }
 
@@ -2056,6 +2156,7 @@ static int mmu030_logical_is_in_atc(uaecptr addr, uae_u32 fc, bool write) {
     int offset = (maddr >> mmu030.translation.page.size) & 0x1f;
 
     int i, index;
+	mmu030_stats.atc_lookups++;
 	index = atcindextable[offset];
     for (i=0; i<ATC030_NUM_ENTRIES; i++) {
         logical_addr = mmu030.atc[index].logical.addr;
@@ -2071,6 +2172,7 @@ static int mmu030_logical_is_in_atc(uaecptr addr, uae_u32 fc, bool write) {
                 /* Maintain history bit */
 					mmu030_atc_handle_history_bit(index);
 					atcindextable[offset] = index;
+					mmu030_stats.atc_hits++;
 					return index;
 				} else {
 					mmu030.atc[index].logical.valid = false;
@@ -2103,11 +2205,16 @@ void mmu030_put_long(uaecptr addr, uae_u32 val, uae_u32 fc)
  	mmu030_cache_state = CACHE_ENABLE_ALL;
 	if (fc != 7 && (!tt_enabled || !mmu030_match_ttr_access(addr,fc,true)) && mmu030.enabled) {
 #if MMU_DPAGECACHE030
-		uae_u32 idx1 = ((addr & mmu030.translation.page.imask) >> mmu030.translation.page.size3m) | fc;
-		uae_u32 idx2 = idx1 & (MMUFASTCACHE_ENTRIES030 - 1);
-		if (atc_data_cache_write[idx2].log == idx1) {
-			addr = atc_data_cache_write[idx2].phys | (addr & mmu030.translation.page.mask);
-			mmu030_cache_state = atc_data_cache_write[idx2].cs;
+		struct mmufastcache030 *e = mmu030_fastcache_find(atc_data_cache_write, addr, fc);
+		if (e) {
+			addr = e->phys | (addr & mmu030.translation.page.mask);
+			mmu030_cache_state = e->cs;
+			uae_u8 *p = mmu030_fastcache_host(e, addr);
+			if (p) {
+				cacheablecheck(addr);
+				do_put_mem_long((uae_u32 *)p, val);
+				return;
+			}
 		} else
 #endif
 		{
@@ -2129,11 +2236,16 @@ void mmu030_put_word(uaecptr addr, uae_u16 val, uae_u32 fc)
  	mmu030_cache_state = CACHE_ENABLE_ALL;
 	if (fc != 7 && (!tt_enabled || !mmu030_match_ttr_access(addr,fc,true)) && mmu030.enabled) {
 #if MMU_DPAGECACHE030
-		uae_u32 idx1 = ((addr & mmu030.translation.page.imask) >> mmu030.translation.page.size3m) | fc;
-		uae_u32 idx2 = idx1 & (MMUFASTCACHE_ENTRIES030 - 1);
-		if (atc_data_cache_write[idx2].log == idx1) {
-			addr = atc_data_cache_write[idx2].phys | (addr & mmu030.translation.page.mask);
-			mmu030_cache_state = atc_data_cache_write[idx2].cs;
+		struct mmufastcache030 *e = mmu030_fastcache_find(atc_data_cache_write, addr, fc);
+		if (e) {
+			addr = e->phys | (addr & mmu030.translation.page.mask);
+			mmu030_cache_state = e->cs;
+			uae_u8 *p = mmu030_fastcache_host(e, addr);
+			if (p) {
+				cacheablecheck(addr);
+				do_put_mem_word((uae_u16 *)p, val);
+				return;
+			}
 		} else
 #endif
 		{
@@ -2155,11 +2267,16 @@ void mmu030_put_byte(uaecptr addr, uae_u8 val, uae_u32 fc)
  	mmu030_cache_state = CACHE_ENABLE_ALL;
 	if (fc != 7 && (!tt_enabled || !mmu030_match_ttr_access(addr,fc,true)) && mmu030.enabled) {
 #if MMU_DPAGECACHE030
-		uae_u32 idx1 = ((addr & mmu030.translation.page.imask) >> mmu030.translation.page.size3m) | fc;
-		uae_u32 idx2 = idx1 & (MMUFASTCACHE_ENTRIES030 - 1);
-		if (atc_data_cache_write[idx2].log == idx1) {
-			addr = atc_data_cache_write[idx2].phys | (addr & mmu030.translation.page.mask);
-			mmu030_cache_state = atc_data_cache_write[idx2].cs;
+		struct mmufastcache030 *e = mmu030_fastcache_find(atc_data_cache_write, addr, fc);
+		if (e) {
+			addr = e->phys | (addr & mmu030.translation.page.mask);
+			mmu030_cache_state = e->cs;
+			uae_u8 *p = mmu030_fastcache_host(e, addr);
+			if (p) {
+				cacheablecheck(addr);
+				do_put_mem_byte(p, val);
+				return;
+			}
 		} else
 #endif
 		{
@@ -2182,11 +2299,15 @@ uae_u32 mmu030_get_long(uaecptr addr, uae_u32 fc)
  	mmu030_cache_state = CACHE_ENABLE_ALL;
 	if (fc != 7 && (!tt_enabled || !mmu030_match_ttr_access(addr,fc,false)) && mmu030.enabled) {
 #if MMU_DPAGECACHE030
-		uae_u32 idx1 = ((addr & mmu030.translation.page.imask) >> mmu030.translation.page.size3m) | fc;
-		uae_u32 idx2 = idx1 & (MMUFASTCACHE_ENTRIES030 - 1);
-		if (atc_data_cache_read[idx2].log == idx1) {
-			addr = atc_data_cache_read[idx2].phys | (addr & mmu030.translation.page.mask);
-			mmu030_cache_state = atc_data_cache_read[idx2].cs;
+		struct mmufastcache030 *e = mmu030_fastcache_find(atc_data_cache_read, addr, fc);
+		if (e) {
+			addr = e->phys | (addr & mmu030.translation.page.mask);
+			mmu030_cache_state = e->cs;
+			uae_u8 *p = mmu030_fastcache_host(e, addr);
+			if (p) {
+				cacheablecheck(addr);
+				return do_get_mem_long((uae_u32 *)p);
+			}
 		} else
 #endif
 		{
@@ -2209,11 +2330,15 @@ uae_u16 mmu030_get_word(uaecptr addr, uae_u32 fc)
  	mmu030_cache_state = CACHE_ENABLE_ALL;
 	if (fc != 7 && (!tt_enabled || !mmu030_match_ttr_access(addr,fc,false)) && mmu030.enabled) {
 #if MMU_DPAGECACHE030
-		uae_u32 idx1 = ((addr & mmu030.translation.page.imask) >> mmu030.translation.page.size3m) | fc;
-		uae_u32 idx2 = idx1 & (MMUFASTCACHE_ENTRIES030 - 1);
-		if (atc_data_cache_read[idx2].log == idx1) {
-			addr = atc_data_cache_read[idx2].phys | (addr & mmu030.translation.page.mask);
-			mmu030_cache_state = atc_data_cache_read[idx2].cs;
+		struct mmufastcache030 *e = mmu030_fastcache_find(atc_data_cache_read, addr, fc);
+		if (e) {
+			addr = e->phys | (addr & mmu030.translation.page.mask);
+			mmu030_cache_state = e->cs;
+			uae_u8 *p = mmu030_fastcache_host(e, addr);
+			if (p) {
+				cacheablecheck(addr);
+				return do_get_mem_word((uae_u16 *)p);
+			}
 		} else
 #endif
 		{
@@ -2236,11 +2361,15 @@ uae_u8 mmu030_get_byte(uaecptr addr, uae_u32 fc)
  	mmu030_cache_state = CACHE_ENABLE_ALL;
 	if (fc != 7 && (!tt_enabled || !mmu030_match_ttr_access(addr,fc,false)) && mmu030.enabled) {
 #if MMU_DPAGECACHE030
-		uae_u32 idx1 = ((addr & mmu030.translation.page.imask) >> mmu030.translation.page.size3m) | fc;
-		uae_u32 idx2 = idx1 & (MMUFASTCACHE_ENTRIES030 - 1);
-		if (atc_data_cache_read[idx2].log == idx1) {
-			addr = atc_data_cache_read[idx2].phys | (addr & mmu030.translation.page.mask);
-			mmu030_cache_state = atc_data_cache_read[idx2].cs;
+		struct mmufastcache030 *e = mmu030_fastcache_find(atc_data_cache_read, addr, fc);
+		if (e) {
+			addr = e->phys | (addr & mmu030.translation.page.mask);
+			mmu030_cache_state = e->cs;
+			uae_u8 *p = mmu030_fastcache_host(e, addr);
+			if (p) {
+				cacheablecheck(addr);
+				return do_get_mem_byte(p);
+			}
 		} else
 #endif
 		{
@@ -2278,12 +2407,22 @@ uae_u32 mmu030_get_ilong(uaecptr addr, uae_u32 fc)
 
 	mmu030_cache_state = CACHE_ENABLE_ALL;
 	if (fc != 7 && (!tt_enabled || !mmu030_match_ttr_access(addr, fc, false)) && mmu030.enabled) {
-		int atc_line_num = mmu030_logical_is_in_atc(addr, fc, false);
-		if (atc_line_num >= 0) {
-			addr = mmu030_get_i_atc(addr, atc_line_num, fc, MMU030_SSW_SIZE_L);
-		} else {
-			mmu030_table_search(addr, fc, false, 0);
-			addr = mmu030_get_i_atc(addr, mmu030_logical_is_in_atc(addr, fc, false), fc, MMU030_SSW_SIZE_L);
+#if MMU_DPAGECACHE030
+		struct mmufastcache030 *e = mmu030_fastcache_find(atc_data_cache_read, addr, fc);
+		if (e) {
+			mmu030_cache_state = e->cs;
+			mmu030_set_i_page(addr, e->phys, fc);
+			addr = e->phys | (addr & mmu030.translation.page.mask);
+		} else
+#endif
+		{
+			int atc_line_num = mmu030_logical_is_in_atc(addr, fc, false);
+			if (atc_line_num >= 0) {
+				addr = mmu030_get_i_atc(addr, atc_line_num, fc, MMU030_SSW_SIZE_L);
+			} else {
+				mmu030_table_search(addr, fc, false, 0);
+				addr = mmu030_get_i_atc(addr, mmu030_logical_is_in_atc(addr, fc, false), fc, MMU030_SSW_SIZE_L);
+			}
 		}
 	}
 	cacheablecheck(addr);
@@ -2310,12 +2449,22 @@ uae_u16 mmu030_get_iword(uaecptr addr, uae_u32 fc)
 
 	mmu030_cache_state = CACHE_ENABLE_ALL;
 	if (fc != 7 && (!tt_enabled || !mmu030_match_ttr_access(addr, fc, false)) && mmu030.enabled) {
-		int atc_line_num = mmu030_logical_is_in_atc(addr, fc, false);
-		if (atc_line_num >= 0) {
-			addr = mmu030_get_i_atc(addr, atc_line_num, fc, MMU030_SSW_SIZE_W);
-		} else {
-			mmu030_table_search(addr, fc, false, 0);
-			addr = mmu030_get_i_atc(addr, mmu030_logical_is_in_atc(addr, fc, false), fc, MMU030_SSW_SIZE_W);
+#if MMU_DPAGECACHE030
+		struct mmufastcache030 *e = mmu030_fastcache_find(atc_data_cache_read, addr, fc);
+		if (e) {
+			mmu030_cache_state = e->cs;
+			mmu030_set_i_page(addr, e->phys, fc);
+			addr = e->phys | (addr & mmu030.translation.page.mask);
+		} else
+#endif
+		{
+			int atc_line_num = mmu030_logical_is_in_atc(addr, fc, false);
+			if (atc_line_num >= 0) {
+				addr = mmu030_get_i_atc(addr, atc_line_num, fc, MMU030_SSW_SIZE_W);
+			} else {
+				mmu030_table_search(addr, fc, false, 0);
+				addr = mmu030_get_i_atc(addr, mmu030_logical_is_in_atc(addr, fc, false), fc, MMU030_SSW_SIZE_W);
+			}
 		}
 	}
 	cacheablecheck(addr);
@@ -2655,10 +2804,29 @@ void mmu030_reset(int hardreset)
 		tt0_030 = tt1_030 = tc_030 = 0;
         mmusr_030 = 0;
         mmu030_flush_atc_all();
+		memset(&mmu030_stats, 0, sizeof(mmu030_stats));
 	}
 	mmu030_set_funcs();
 }
 
+#ifdef WINUAE_FOR_HATARI
+static void mmu030_show_rate(FILE *fp, const char *name, uae_u64 hits, uae_u64 lookups)
+{
+	fprintf(fp, "%s:\t%" PRIu64 " / %" PRIu64 " hits (%.1f%%)\n", name,
+		(uint64_t)hits, (uint64_t)lookups,
+		lookups ? 100.0 * hits / lookups : 0.0);
+}
+
+/* Show ATC hit-rate statistics since last reset */
+void mmu030_show_atc_stats(FILE *fp)
+{
+	mmu030_show_rate(fp, "Fast ATC", mmu030_stats.fast_hits,
+			 mmu030_stats.fast_hits + mmu030_stats.fast_misses);
+	mmu030_show_rate(fp, "ATC", mmu030_stats.atc_hits, mmu030_stats.atc_lookups);
+	fprintf(fp, "Table searches:\t%" PRIu64 "\n", (uint64_t)mmu030_stats.table_searches);
+}
+#endif
+
 void mmu030_set_funcs(void)
 {
 	if (currprefs.mmu_model != 68030)
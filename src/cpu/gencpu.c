@@ -286,42 +286,55 @@ NORETURN static void term_err (const char *err)
 	term();
 }
 
+static int compare_counts (const void *a, const void *b)
+{
+	int op1 = *(const int *)a, op2 = *(const int *)b;
+	if (counts[op1] != counts[op2])
+		return counts[op1] < counts[op2] ? 1 : -1;
+	return op1 - op2;
+}
+
+/* Order the generated opcode handlers by their execution frequency,
+ * most frequently executed first, so that the hot handlers end up next
+ * to each other in the generated code.  The "frequent.68k" file is
+ * written by the emulator when it's built with COUNT_INSTRS == 2.
+ * It lists counts for individual opcodes, so they are accumulated to
+ * the opcode that actually handles them.  Without the file, handlers
+ * are generated in opcode order.
+ */
 static void read_counts (void)
 {
 	FILE *file;
-	unsigned int opcode, count, total;
+	unsigned int opcode, handler;
+	unsigned long count, total;
 	char name[20];
 	int nr = 0;
 	memset (counts, 0, 65536 * sizeof *counts);
 
-	count = 0;
 	file = fopen ("frequent.68k", "r");
 	if (file) {
-		if (fscanf (file, "Total: %u\n", &total) == 0) {
-			abort();
+		if (fscanf (file, "Total: %lu\n", &total) != 1) {
+			term_err ("Invalid frequent.68k file header!");
 		}
-		while (fscanf (file, "%x: %u %s\n", &opcode, &count, name) == 3) {
-			opcode_next_clev[nr] = 5;
-			opcode_last_postfix[nr] = -1;
-			opcode_map[nr++] = opcode;
-			counts[opcode] = count;
+		while (fscanf (file, "%x: %lu %19s\n", &opcode, &count, name) == 3) {
+			if (opcode > 0xffff)
+				continue;
+			handler = table68k[opcode].handler == -1 ? opcode : table68k[opcode].handler;
+			counts[handler] += count;
 		}
 		fclose (file);
 	}
-	if (nr == nr_cpuop_funcs)
-		return;
 	for (opcode = 0; opcode < 0x10000; opcode++) {
-		if (table68k[opcode].handler == -1 && table68k[opcode].mnemo != i_ILLG
-			&& counts[opcode] == 0)
+		if (table68k[opcode].handler == -1 && table68k[opcode].mnemo != i_ILLG)
 		{
 			opcode_next_clev[nr] = 5;
 			opcode_last_postfix[nr] = -1;
 			opcode_map[nr++] = opcode;
-			counts[opcode] = count;
 		}
 	}
 	if (nr != nr_cpuop_funcs)
 		term();
+	qsort (opcode_map, nr, sizeof *opcode_map, compare_counts);
 }
 
 static int genamode_cnt, genamode8r_offset[2];
@@ -1887,11 +1900,17 @@ static void genflags_normal(flagtypes type, wordsizes size, const char *value, c
 		break;
 	}
 
+	/* Flag types that set all of CZNV store them with a single
+	 * SET_CZNV(), instead of separate read-modify-write of each flag.
+	 *
+	 * Lazy flags (recording the operation and computing flags only
+	 * when Bcc/Scc/DBcc/SR read needs them) are not worth their extra
+	 * checks: a test core computing CZNV twice for every instruction
+	 * was not measurably slower than this one in 68000 CE mode.
+	 */
 	switch (type) {
 	case flag_logical:
-		out("CLEAR_CZNV();\n");
-		out("SET_ZFLG(%s == 0);\n", vstr);
-		out("SET_NFLG(%s < 0);\n", vstr);
+		out("SET_CZNV((%s == 0 ? FLAGVAL_Z : 0) | (%s < 0 ? FLAGVAL_N : 0));\n", vstr, vstr);
 		break;
 	case flag_logical_noclobber:
 		out("SET_ZFLG(%s == 0);\n", vstr);
@@ -1911,18 +1930,14 @@ static void genflags_normal(flagtypes type, wordsizes size, const char *value, c
 		out("SET_NFLG(%s < 0);\n", vstr);
 		break;
 	case flag_add:
-		out("SET_ZFLG(%s == 0);\n", vstr);
-		out("SET_VFLG((flgs ^ flgn) & (flgo ^ flgn));\n");
-		out("SET_CFLG(%s < %s);\n", undstr, usstr);
+		out("SET_CZNV((%s == 0 ? FLAGVAL_Z : 0) | ((flgs ^ flgn) & (flgo ^ flgn) ? FLAGVAL_V : 0) | "
+			"(%s < %s ? FLAGVAL_C : 0) | (flgn ? FLAGVAL_N : 0));\n", vstr, undstr, usstr);
 		duplicate_carry();
-		out("SET_NFLG(flgn != 0);\n");
 		break;
 	case flag_sub:
-		out("SET_ZFLG(%s == 0);\n", vstr);
-		out("SET_VFLG((flgs ^ flgo) & (flgn ^ flgo));\n");
-		out("SET_CFLG(%s > %s);\n", usstr, udstr);
+		out("SET_CZNV((%s == 0 ? FLAGVAL_Z : 0) | ((flgs ^ flgo) & (flgn ^ flgo) ? FLAGVAL_V : 0) | "
+			"(%s > %s ? FLAGVAL_C : 0) | (flgn ? FLAGVAL_N : 0));\n", vstr, usstr, udstr);
 		duplicate_carry();
-		out("SET_NFLG(flgn != 0);\n");
 		break;
 	case flag_addx:
 		out("SET_VFLG((flgs ^ flgn) & (flgo ^ flgn));\n"); /* minterm SON: 0x42 */
@@ -1935,10 +1950,8 @@ static void genflags_normal(flagtypes type, wordsizes size, const char *value, c
 		duplicate_carry();
 		break;
 	case flag_cmp:
-		out("SET_ZFLG(%s == 0);\n", vstr);
-		out("SET_VFLG((flgs != flgo) && (flgn != flgo));\n");
-		out("SET_CFLG(%s > %s);\n", usstr, udstr);
-		out("SET_NFLG(flgn != 0);\n");
+		out("SET_CZNV((%s == 0 ? FLAGVAL_Z : 0) | ((flgs != flgo) && (flgn != flgo) ? FLAGVAL_V : 0) | "
+			"(%s > %s ? FLAGVAL_C : 0) | (flgn ? FLAGVAL_N : 0));\n", vstr, usstr, udstr);
 		break;
 	}
 }
@@ -7612,6 +7625,12 @@ static void gen_opcode (unsigned int opcode)
 			out("}\n");
 		}
 		push_ins_cnt();
+#ifdef WINUAE_FOR_HATARI
+		/* Hatari : check short backwards loops for idle polling */
+		out("if ((uae_s32)src < 0 && (uae_s32)src >= -SPINLOOP_MAX_SIZE) {\n");
+		out("SpinLoop_Check(oldpc, oldpc + (uae_s32)src + 2);\n");
+		out("}\n");
+#endif
 		if (using_prefetch) {
 			incpc ("(uae_s32)src + 2");
 			fill_prefetch_full_000_special(2, NULL);
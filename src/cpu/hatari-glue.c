@@ -11,6 +11,7 @@ const char HatariGlue_fileid[] = "Hatari hatari-glue.c";
 
 
 #include <stdio.h>
+#include <inttypes.h>
 
 #include "main.h"
 #include "configuration.h"
@@ -29,6 +30,9 @@ const char HatariGlue_fileid[] = "Hatari hatari-glue.c";
 #include "mfp.h"
 #include "fdc.h"
 #include "memorySnapShot.h"
+#include "blitter.h"
+#include "dsp.h"
+#include "log.h"
 
 #include "sysdeps.h"
 #include "options_cpu.h"
@@ -170,6 +174,7 @@ int Init680x0(void)
  */
 void Exit680x0(void)
 {
+	dump_counts();
 	memory_uninit();
 
 	free(table68k);
@@ -177,6 +182,207 @@ void Exit680x0(void)
 }
 
 
+/* State of the last short backwards loop that the CPU branched to */
+static struct {
+	uaecptr branchpc;	/* address of the loop branch instruction */
+	uaecptr targetpc;	/* loop start address */
+	uae_u32 regs[16];	/* D0-D7/A0-A7 at previous loop branch */
+	uae_u16 sr;		/* SR at previous loop branch */
+	Uint64 clock;		/* CyclesGlobalClockCounter at previous loop branch */
+	Uint64 cycles;		/* cycles spent on previous loop iteration */
+	bool rejected;		/* loop body was checked and can not be skipped */
+} SpinLoop;
+
+/**
+ * Skip extension words of given instruction operand in 'pc', and check
+ * that the memory it reads is RAM, which contents can change only in
+ * CycInt event handlers (or in the interrupts they cause), not due to
+ * just passing of time like IO registers.
+ * Return false if operand address can not be checked or it's not in RAM.
+ */
+static bool SpinLoop_CheckOperand(amodes mode, int reg, wordsizes size,
+                                  uaecptr *pc, uaecptr end)
+{
+	int len = size == sz_byte ? 1 : (size == sz_word ? 2 : 4);
+	int extlen;
+	uaecptr addr;
+
+	switch (mode)
+	{
+	case Dreg:
+	case Areg:
+	case immi:
+		return true;
+	case imm:
+		extlen = (size == sz_long ? 4 : 2);
+		break;
+	case imm2:
+	case absl:
+		extlen = 4;
+		break;
+	case imm0:
+	case imm1:
+	case Ad16:
+	case PC16:
+	case absw:
+		extlen = 2;
+		break;
+	case Aind:
+		extlen = 0;
+		break;
+	default:
+		/* address register updates and indexed modes */
+		return false;
+	}
+	if (*pc + extlen > end)
+		return false;
+
+	switch (mode)
+	{
+	case Aind:
+		addr = m68k_areg(regs, reg);
+		break;
+	case Ad16:
+		addr = m68k_areg(regs, reg) + (uae_s16)STMemory_ReadWord(*pc);
+		break;
+	case PC16:
+		addr = *pc + (uae_s16)STMemory_ReadWord(*pc);
+		break;
+	case absw:
+		addr = (uae_s16)STMemory_ReadWord(*pc);
+		break;
+	case absl:
+		addr = STMemory_ReadLong(*pc);
+		break;
+	default:
+		/* immediate value */
+		*pc += extlen;
+		return true;
+	}
+	*pc += extlen;
+	return STMemory_CheckAreaType(addr, len, ABFLAG_RAM);
+}
+
+/**
+ * Check that all instructions from 'pc' to the loop branch at 'end'
+ * only read RAM and change nothing else than CPU registers.
+ */
+static bool SpinLoop_CheckBody(uaecptr pc, uaecptr end)
+{
+	int cpu_level = currprefs.cpu_model == 68060 ? 5 : (currprefs.cpu_model - 68000) / 10;
+	struct instr *dp;
+
+	if (!STMemory_CheckAreaType(pc, end + 2 - pc, ABFLAG_RAM | ABFLAG_ROM))
+		return false;
+
+	while (pc < end)
+	{
+		dp = &table68k[STMemory_ReadWord(pc)];
+		if (dp->clev > cpu_level)
+			return false;
+		pc += 2;
+
+		switch (dp->mnemo)
+		{
+		case i_NOP:
+		case i_Bcc:
+		case i_TST:
+		case i_CMP:
+		case i_CMPA:
+		case i_BTST:
+			break;
+		case i_MOVE:
+		case i_MOVEA:
+		case i_AND:
+		case i_OR:
+			if (dp->dmode != Dreg && dp->dmode != Areg)
+				return false;
+			break;
+		default:
+			return false;
+		}
+		if (dp->suse && !SpinLoop_CheckOperand(dp->smode, dp->sreg, dp->size, &pc, end))
+			return false;
+		if (dp->duse && !SpinLoop_CheckOperand(dp->dmode, dp->dreg, dp->size, &pc, end))
+			return false;
+	}
+	return pc == end;
+}
+
+/**
+ * Called by the CPU core on taken short backwards branches.
+ *
+ * When CPU registers are identical at the loop branch for several
+ * iterations, all of which took the same number of cycles, and the
+ * loop does nothing else than read RAM, the CPU is just waiting for
+ * an interrupt (or DMA) to change that RAM.  Then the whole loop
+ * iterations until the next CycInt event are skipped, so that the
+ * event still happens at the same point of the loop as without skipping.
+ */
+void SpinLoop_Check(uaecptr branchpc, uaecptr targetpc)
+{
+	Uint64 cycles, skip;
+
+	/* MMU addresses are logical, DSP runs in step with CPU cycles */
+	if (!ConfigureParams.System.bSkipSpinLoops || currprefs.mmu_model || bDspEnabled)
+		return;
+
+	/* pending interrupts / exceptions, debugger, tracing, blitter, and
+	 * other things which do not follow the CycInt events or the CPU clock.
+	 * SPCFLAG_CHECK is set on CPU reset, but only cleared by WinUAE code
+	 */
+	if ((regs.spcflags & ~SPCFLAG_CHECK) || regs.t1 || regs.t0 || BlitterPhase ||
+	    (LogTraceFlags & TRACE_CPU_DISASM))
+	{
+		/* restart iteration timing after them */
+		SpinLoop.cycles = 0;
+		return;
+	}
+
+	MakeSR();
+	if (branchpc != SpinLoop.branchpc || targetpc != SpinLoop.targetpc ||
+	    regs.sr != SpinLoop.sr || memcmp(regs.regs, SpinLoop.regs, sizeof(SpinLoop.regs)))
+	{
+		SpinLoop.branchpc = branchpc;
+		SpinLoop.targetpc = targetpc;
+		SpinLoop.sr = regs.sr;
+		memcpy(SpinLoop.regs, regs.regs, sizeof(SpinLoop.regs));
+		SpinLoop.clock = CyclesGlobalClockCounter;
+		SpinLoop.cycles = 0;
+		SpinLoop.rejected = false;
+		return;
+	}
+	if (SpinLoop.rejected)
+		return;
+	cycles = CyclesGlobalClockCounter - SpinLoop.clock;
+	SpinLoop.clock = CyclesGlobalClockCounter;
+	if (cycles != SpinLoop.cycles || cycles == 0)
+	{
+		SpinLoop.cycles = cycles;
+		return;
+	}
+
+	/* whole iterations that end before the next event */
+	skip = ((CycInt_ActiveInt_Cycles - 1) >> CYCINT_SHIFT);
+	if (skip <= CyclesGlobalClockCounter)
+		return;
+	skip = (skip - CyclesGlobalClockCounter) / cycles * cycles;
+	if (!skip)
+		return;
+	/* check the body only once while the loop state stays the same */
+	if (!SpinLoop_CheckBody(targetpc, branchpc))
+	{
+		SpinLoop.rejected = true;
+		return;
+	}
+
+	LOG_TRACE(TRACE_INT, "cpu skipping %"PRIu64" cycles of spin loop at 0x%x\n",
+		  skip, targetpc);
+	M68000_AddCycles_CE(skip);
+	SpinLoop.clock += skip;
+}
+
+
 /**
  * Execute a 'NOP' opcode (increment PC by 2 bytes and take care
  * of prefetch at the CPU level depending on the current CPU mode)
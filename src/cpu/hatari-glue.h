@@ -22,6 +22,10 @@ extern void UAE_Set_State_Restore ( void );
 extern int Init680x0(void);
 extern void Exit680x0(void);
 
+/* Longest backwards branch (in bytes) checked for a CPU spin loop */
+#define SPINLOOP_MAX_SIZE 32
+extern void SpinLoop_Check(uaecptr branchpc, uaecptr targetpc);
+
 extern uae_u32 REGPARAM3 OpCode_GemDos(uae_u32 opcode);
 extern uae_u32 REGPARAM3 OpCode_Pexec(uae_u32 opcode);
 extern uae_u32 REGPARAM3 OpCode_SysInit(uae_u32 opcode);
@@ -27,6 +27,7 @@ const char Memory_fileid[] = "Hatari memory.c";
 #include "stMemory.h"
 #include "m68000.h"
 #include "configuration.h"
+#include "historycpu.h"
 
 #include "newcpu.h"
 
@@ -1634,6 +1635,10 @@ void memory_map_Standard_RAM ( Uint32 MMU_Bank0_Size , Uint32 MMU_Bank1_Size )
 		map_banks_ce(&SysMem_bank, 0x00, 0x10000 >> 16, 0, CE_MEMBANK_CHIP16, CACHE_ENABLE_BOTH);
 		map_banks_ce(&STmem_bank, 0x10000 >> 16, ( STmem_size - 0x10000 ) >> 16, 0, CE_MEMBANK_CHIP16, CACHE_ENABLE_BOTH);
 	}
+
+	/* RAM banks were re-mapped, CPU history needs to track writes to them again */
+	if (HistoryCpu_Active)
+		HistoryCpu_InstallHooks();
 }
 
 
@@ -1847,6 +1852,9 @@ void memory_init(uae_u32 NewSTMemSize, uae_u32 NewTTMemSize, uae_u32 NewRomMemSt
 	}
 
 	illegal_count = 0;
+
+	if (HistoryCpu_Active)
+		HistoryCpu_InstallHooks();
 }
 
 
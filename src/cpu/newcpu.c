@@ -146,7 +146,9 @@ static struct cputbl_data cpudatatbl[65536];
 
 struct mmufixup mmufixup[2];
 
+#ifndef COUNT_INSTRS
 #define COUNT_INSTRS 0
+#endif
 #define MC68060_PCR   0x04300000
 #define MC68EC060_PCR 0x04310000
 
@@ -183,15 +185,19 @@ void (*flush_icache)(int);
 #if COUNT_INSTRS
 static unsigned long int instrcount[65536];
 static uae_u16 opcodenums[65536];
+static bool instrcount_loaded;
 
 static int compfn (const void *el1, const void *el2)
 {
-	return instrcount[*(const uae_u16 *)el1] < instrcount[*(const uae_u16 *)el2];
+	uae_u16 op1 = *(const uae_u16 *)el1, op2 = *(const uae_u16 *)el2;
+	if (instrcount[op1] != instrcount[op2])
+		return instrcount[op1] < instrcount[op2] ? 1 : -1;
+	return op1 - op2;
 }
 
-static TCHAR *icountfilename (void)
+static const TCHAR *icountfilename (void)
 {
-	TCHAR *name = getenv ("INSNCOUNT");
+	const TCHAR *name = getenv ("INSNCOUNT");
 	if (name)
 		return name;
 	return COUNT_INSTRS == 2 ? "frequent.68k" : "insncount";
@@ -200,9 +206,13 @@ static TCHAR *icountfilename (void)
 void dump_counts (void)
 {
 	FILE *f = fopen (icountfilename (), "w");
-	unsigned long int total;
+	unsigned long int total = 0;
 	int i;
 
+	if (!f) {
+		write_log (_T("Failed to write instruction count file '%s'\n"), icountfilename ());
+		return;
+	}
 	write_log (_T("Writing instruction count file...\n"));
 	for (i = 0; i < 65536; i++) {
 		opcodenums[i] = i;
@@ -1846,6 +1856,9 @@ void set_cpu_caches (bool flush)
 
 STATIC_INLINE void count_instr (uae_u32 opcode)
 {
+#if COUNT_INSTRS
+	instrcount[opcode & 0xffff]++;
+#endif
 }
 
 static uae_u32 opcode_swap(uae_u16 opcode)
@@ -2326,16 +2339,20 @@ void init_m68k (void)
 	}
 
 #if COUNT_INSTRS
-	{
+	/* CPU may be re-initialized at run-time, keep the counts collected so far */
+	if (!instrcount_loaded) {
 		FILE *f = fopen (icountfilename (), "r");
+		instrcount_loaded = true;
 		memset (instrcount, 0, sizeof instrcount);
 		if (f) {
-			uae_u32 opcode, count, total;
+			unsigned int opcode;
+			unsigned long int count, total;
 			TCHAR name[20];
 			write_log (_T("Reading instruction count file...\n"));
-			fscanf (f, "Total: %lu\n", &total);
-			while (fscanf (f, "%x: %lu %s\n", &opcode, &count, name) == 3) {
-				instrcount[opcode] = count;
+			if (fscanf (f, "Total: %lu\n", &total) == 1) {
+				while (fscanf (f, "%x: %lu %19s\n", &opcode, &count, name) == 3) {
+					instrcount[opcode & 0xffff] = count;
+				}
 			}
 			fclose (f);
 		}
@@ -5408,6 +5425,8 @@ static void m68k_run_1_ce (void)
 				}
 #endif
 
+				count_instr (r->opcode);
+
 				(*cpufunctbl[r->opcode])(r->opcode);
 				if (!regs.loop_mode)
 					regs.ird = regs.opcode;
@@ -6524,6 +6543,8 @@ static void m68k_run_3ce (void)
 				}
 #endif
 
+				count_instr (r->opcode);
+
 				(*cpufunctbl[r->opcode])(r->opcode);
 
 #ifdef WINUAE_FOR_HATARI
@@ -6620,6 +6641,8 @@ static void m68k_run_3p(void)
 				}
 #endif
 
+				count_instr (r->opcode);
+
 				(*cpufunctbl[r->opcode])(r->opcode);
 
 #ifndef WINUAE_FOR_HATARI
@@ -6823,6 +6846,8 @@ fprintf ( stderr , "cache valid %d tag1 %x lws1 %x ctag %x data %x mem=%x\n" , c
 				}
 #endif
 
+				count_instr (r->opcode);
+
 				(*cpufunctbl[r->opcode])(r->opcode);
 		
 				wait_memory_cycles();
@@ -6996,6 +7021,8 @@ static void m68k_run_2p (void)
 				}
 #endif
 
+				count_instr (r->opcode);
+
 				if (currprefs.cpu_memory_cycle_exact) {
 
 					(*cpufunctbl[r->opcode])(r->opcode);
@@ -7312,6 +7339,7 @@ static void m68k_run_mmu (void)
 		regs.opcode = get_iiword (0);
 		do_cycles (cpu_cycles);
 		mmu_backup_regs = regs;
+		count_instr (regs.opcode);
 		cpu_cycles = (*cpufunctbl[regs.opcode])(regs.opcode);
 		cpu_cycles = adjust_cycles (cpu_cycles);
 		if (mmu_triggered)
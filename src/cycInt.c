@@ -57,12 +57,15 @@ const char CycInt_fileid[] = "Hatari cycInt.c";
 #include "dmaSnd.h"
 #include "crossbar.h"
 #include "fdc.h"
+#include "hdc.h"
+#include "ide.h"
 #include "ikbd.h"
 #include "cycles.h"
 #include "cycInt.h"
 #include "m68000.h"
 #include "mfp.h"
 #include "midi.h"
+#include "profile.h"
 #include "memorySnapShot.h"
 #include "sound.h"
 #include "screen.h"
@@ -104,6 +107,9 @@ static void (* const pIntHandlerFunctions[MAX_INTERRUPTS])(void) =
 	FDC_InterruptHandler_Update,
 	Blitter_InterruptHandler,
 	Midi_InterruptHandler_Update,
+	HDC_InterruptHandler_Acsi,
+	Ide_InterruptHandler,
+	Profile_CpuSample,
 
 };
 
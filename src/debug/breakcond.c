@@ -15,6 +15,7 @@ const char BreakCond_fileid[] = "Hatari breakcond.c";
 
 #include <ctype.h>
 #include <stdlib.h>
+#include <inttypes.h>
 #include "config.h"
 #include "main.h"
 #include "file.h"
@@ -45,8 +46,9 @@ const char BreakCond_fileid[] = "Hatari breakcond.c";
 
 #define BC_DEFAULT_DSP_SPACE 'P'
 
-typedef struct {
+typedef struct bc_value_s {
 	bool is_indirect;
+	bool is_pc;	/* value is (CPU or DSP) PC register */
 	char dsp_space;	/* DSP has P, X, Y address spaces, zero if not DSP */
 	value_t valuetype;	/* Hatari value variable type */
 	union {
@@ -58,13 +60,18 @@ typedef struct {
 	} value;
 	Uint32 bits;	/* CPU has 8/16/32 bit address widths */
 	Uint32 mask;	/* <width mask> && <value mask> */
+	/* compiled value getter, set by BreakCond_CompileValue() */
+	Uint32 (*get)(const struct bc_value_s *bc_value);
 } bc_value_t;
 
-typedef struct {
+typedef struct bc_condition_s {
 	bc_value_t lvalue;
 	bc_value_t rvalue;
 	char comparison;
 	bool track;	/* track value changes */
+	Uint32 rnumber;	/* masked rvalue, when it's a number */
+	/* compiled comparison, set by BreakCond_CompileCondition() */
+	bool (*match)(const struct bc_condition_s *condition, Uint32 *lvalue);
 } bc_condition_t;
 
 typedef struct {
@@ -85,6 +92,10 @@ typedef struct {
 	bc_condition_t *conditions;
 	int ccount;	/* condition count */
 	int hits;	/* how many times breakpoint hit */
+	bool has_pc;	/* has "pc = <number>" condition, see pc_index */
+	Uint32 pc;	/* ...with this address */
+	Uint64 evals;	/* how many times conditions were evaluated */
+	Uint64 checks;	/* how many conditions those evaluations checked */
 } bc_breakpoint_t;
 
 typedef struct {
@@ -95,15 +106,45 @@ typedef struct {
 	int allocated;
 	bool delayed_change;
 	const debug_reason_t reason;
+	/* hash of the addresses in breakpoints with "pc = <number>"
+	 * condition, so that those need to be evaluated only when
+	 * PC is at one of them
+	 */
+	Uint32 (*const get_pc)(void);
+	const Uint32 pc_mask;	/* PC register value bits */
+	Uint32 *pc_index;
+	Uint32 pc_index_mask;	/* index size - 1 */
+	int pc_count;		/* breakpoints in the index */
+	/* bitmap of the same addresses for quick checks, see breakcond.h */
+	Uint8 *pc_bits;
+	const Uint8 **pc_bits_public;	/* set when all breakpoints are indexed */
+	const Uint32 pc_bits_mask;	/* address bits covered by the bitmap */
+	const int pc_bits_shift;	/* address bits shift for bit index */
 } bc_breakpoints_t;
 
+static Uint32 GetCpuPC(void);
+static Uint32 GetDspPC(void);
+
+const Uint8 *BreakCond_CpuPcBits;
+const Uint8 *BreakCond_DspPcBits;
+
 static bc_breakpoints_t CpuBreakPoints = {
 	.name = "CPU",
-	.reason = REASON_CPU_BREAKPOINT
+	.reason = REASON_CPU_BREAKPOINT,
+	.get_pc = GetCpuPC,
+	.pc_mask = 0xffffffff,
+	.pc_bits_public = &BreakCond_CpuPcBits,
+	.pc_bits_mask = BC_CPU_PC_BITS_MASK,
+	.pc_bits_shift = 1
 };
 static bc_breakpoints_t DspBreakPoints = {
 	.name = "DSP",
-	.reason = REASON_DSP_BREAKPOINT
+	.reason = REASON_DSP_BREAKPOINT,
+	.get_pc = GetDspPC,
+	.pc_mask = 0xffff,
+	.pc_bits_public = &BreakCond_DspPcBits,
+	.pc_bits_mask = BC_DSP_PC_BITS_MASK,
+	.pc_bits_shift = 0
 };
 
 
@@ -236,6 +277,136 @@ static Uint32 BreakCond_GetValue(const bc_value_t *bc_value)
 }
 
 
+/* Compiled value getters for BreakCond_CompileValue(), for the most
+ * common value types.  Others use generic BreakCond_GetValue().
+ */
+static Uint32 BreakCond_GetNumber(const bc_value_t *bc_value)
+{
+	return bc_value->value.number & bc_value->mask;
+}
+static Uint32 BreakCond_GetFunc32(const bc_value_t *bc_value)
+{
+	return bc_value->value.func32() & bc_value->mask;
+}
+static Uint32 BreakCond_GetReg16(const bc_value_t *bc_value)
+{
+	return *(bc_value->value.reg16) & bc_value->mask;
+}
+static Uint32 BreakCond_GetReg32(const bc_value_t *bc_value)
+{
+	return *(bc_value->value.reg32) & bc_value->mask;
+}
+static Uint32 BreakCond_GetSTLong(const bc_value_t *bc_value)
+{
+	return STMemory_ReadLong(bc_value->value.number) & bc_value->mask;
+}
+static Uint32 BreakCond_GetSTWord(const bc_value_t *bc_value)
+{
+	return STMemory_ReadWord(bc_value->value.number) & bc_value->mask;
+}
+static Uint32 BreakCond_GetSTByte(const bc_value_t *bc_value)
+{
+	return STMemory_ReadByte(bc_value->value.number) & bc_value->mask;
+}
+
+/**
+ * Select getter function for given value, so that its type,
+ * addressing and width need not be resolved on every check
+ */
+static void BreakCond_CompileValue(bc_value_t *bc_value)
+{
+	bc_value->get = BreakCond_GetValue;
+	if (bc_value->is_indirect) {
+		if (bc_value->dsp_space ||
+		    bc_value->valuetype != VALUE_TYPE_NUMBER) {
+			return;
+		}
+		switch (bc_value->bits) {
+		case 32:
+			bc_value->get = BreakCond_GetSTLong;
+			break;
+		case 16:
+			bc_value->get = BreakCond_GetSTWord;
+			break;
+		case 8:
+			bc_value->get = BreakCond_GetSTByte;
+			break;
+		}
+		return;
+	}
+	switch (bc_value->valuetype) {
+	case VALUE_TYPE_NUMBER:
+		bc_value->get = BreakCond_GetNumber;
+		break;
+	case VALUE_TYPE_FUNCTION32:
+		bc_value->get = BreakCond_GetFunc32;
+		break;
+	case VALUE_TYPE_REG16:
+		bc_value->get = BreakCond_GetReg16;
+		break;
+	case VALUE_TYPE_VAR32:
+	case VALUE_TYPE_REG32:
+		bc_value->get = BreakCond_GetReg32;
+		break;
+	default:
+		break;
+	}
+}
+
+/* Compiled comparisons for BreakCond_CompileCondition(), generic ones
+ * and ones for comparing against a number.  Both return compared
+ * lvalue for value change tracking.
+ */
+#define BC_MATCH_FUNCTIONS(name, op) \
+static bool BreakCond_Match##name(const bc_condition_t *condition, Uint32 *lvalue) \
+{ \
+	*lvalue = condition->lvalue.get(&(condition->lvalue)); \
+	return *lvalue op condition->rvalue.get(&(condition->rvalue)); \
+} \
+static bool BreakCond_Match##name##Number(const bc_condition_t *condition, Uint32 *lvalue) \
+{ \
+	*lvalue = condition->lvalue.get(&(condition->lvalue)); \
+	return *lvalue op condition->rnumber; \
+}
+BC_MATCH_FUNCTIONS(Less, <)
+BC_MATCH_FUNCTIONS(Greater, >)
+BC_MATCH_FUNCTIONS(Equal, ==)
+BC_MATCH_FUNCTIONS(NotEqual, !=)
+
+/**
+ * Select value getters and comparison function for given condition
+ */
+static void BreakCond_CompileCondition(bc_condition_t *condition)
+{
+	bool number;
+
+	BreakCond_CompileValue(&(condition->lvalue));
+	BreakCond_CompileValue(&(condition->rvalue));
+
+	number = (condition->rvalue.get == BreakCond_GetNumber);
+	condition->rnumber = condition->rvalue.value.number & condition->rvalue.mask;
+
+	switch (condition->comparison) {
+	case '<':
+		condition->match = number ? BreakCond_MatchLessNumber : BreakCond_MatchLess;
+		break;
+	case '>':
+		condition->match = number ? BreakCond_MatchGreaterNumber : BreakCond_MatchGreater;
+		break;
+	case '=':
+		condition->match = number ? BreakCond_MatchEqualNumber : BreakCond_MatchEqual;
+		break;
+	case '!':
+		condition->match = number ? BreakCond_MatchNotEqualNumber : BreakCond_MatchNotEqual;
+		break;
+	default:
+		fprintf(stderr, "ERROR: Unknown breakpoint value comparison operator '%c'!\n",
+			condition->comparison);
+		abort();
+	}
+}
+
+
 /**
  * Show & update rvalue for a tracked breakpoint condition to lvalue
  */
@@ -245,6 +416,7 @@ static void BreakCond_UpdateTracked(bc_condition_t *condition, Uint32 value)
 
 	/* next monitor changes to this new value */
 	condition->rvalue.value.number = value;
+	condition->rnumber = value & condition->rvalue.mask;
 
 	if (condition->lvalue.is_indirect &&
 	    condition->lvalue.valuetype == VALUE_TYPE_NUMBER) {
@@ -261,46 +433,109 @@ static void BreakCond_UpdateTracked(bc_condition_t *condition, Uint32 value)
 /**
  * Return true if all of the given breakpoint's conditions match
  */
-static bool BreakCond_MatchConditions(bc_condition_t *condition, int count)
+static bool BreakCond_MatchConditions(bc_breakpoint_t *bp)
 {
-	Uint32 lvalue, rvalue;
-	bool hit = false;
+	bc_condition_t *condition = bp->conditions;
+	Uint32 lvalue;
 	int i;
 
-	for (i = 0; i < count; condition++, i++) {
-
-		lvalue = BreakCond_GetValue(&(condition->lvalue));
-		rvalue = BreakCond_GetValue(&(condition->rvalue));
+	bp->evals++;
+	for (i = 0; i < bp->ccount; condition++, i++) {
 
-		switch (condition->comparison) {
-		case '<':
-			hit = (lvalue < rvalue);
-			break;
-		case '>':
-			hit = (lvalue > rvalue);
-			break;
-		case '=':
-			hit = (lvalue == rvalue);
-			break;
-		case '!':
-			hit = (lvalue != rvalue);
-			break;
-		default:
-			fprintf(stderr, "ERROR: Unknown breakpoint value comparison operator '%c'!\n",
-				condition->comparison);
-			abort();
-		}
-		if (likely(!hit)) {
+		if (likely(!condition->match(condition, &lvalue))) {
+			bp->checks += i + 1;
 			return false;
 		}
 		if (condition->track) {
 			BreakCond_UpdateTracked(condition, lvalue);
 		}
 	}
+	bp->checks += i;
 	/* all conditions matched */
 	return true;
 }
 
+/**
+ * Return true if given PC address is in given breakpoints' PC index
+ */
+static bool BreakCond_MatchPcIndex(const bc_breakpoints_t *bps, Uint32 pc)
+{
+	Uint32 slot = (pc ^ (pc >> 16)) & bps->pc_index_mask;
+	Uint32 key, bit;
+
+	/* higher CPU address bits alias in the bitmap, so it can only
+	 * tell for certain that address isn't there
+	 */
+	bit = (pc & bps->pc_bits_mask) >> bps->pc_bits_shift;
+	if (likely(!(bps->pc_bits[bit >> 3] & (1 << (bit & 7))))) {
+		return false;
+	}
+
+	/* PC values are even on CPU and 16-bit on DSP, so ~0 can't be one */
+	while ((key = bps->pc_index[slot]) != ~0u) {
+		if (key == pc) {
+			return true;
+		}
+		slot = (slot + 1) & bps->pc_index_mask;
+	}
+	return false;
+}
+
+/**
+ * Re-create PC address index for given breakpoints after changes
+ */
+static void BreakCond_UpdatePcIndex(bc_breakpoints_t *bps)
+{
+	bc_breakpoint_t *bp;
+	Uint32 size, slot, pc;
+	int i;
+
+	bps->pc_count = 0;
+	for (bp = bps->breakpoint, i = 0; i < bps->count; bp++, i++) {
+		if (bp->has_pc) {
+			bps->pc_count++;
+		}
+	}
+	free(bps->pc_index);
+	bps->pc_index = NULL;
+	*(bps->pc_bits_public) = NULL;
+	if (!bps->pc_count) {
+		return;
+	}
+	/* bitmap is kept once allocated, just cleared */
+	size = ((bps->pc_bits_mask >> bps->pc_bits_shift) + 1) / 8;
+	if (!bps->pc_bits) {
+		bps->pc_bits = malloc(size);
+		assert(bps->pc_bits);
+	}
+	memset(bps->pc_bits, 0, size);
+	/* at most half full */
+	for (size = 4; size < 2 * (Uint32)bps->pc_count; size *= 2)
+		;
+	bps->pc_index = malloc(size * sizeof(Uint32));
+	assert(bps->pc_index);
+	memset(bps->pc_index, 0xff, size * sizeof(Uint32));
+	bps->pc_index_mask = size - 1;
+
+	for (bp = bps->breakpoint, i = 0; i < bps->count; bp++, i++) {
+		if (!bp->has_pc) {
+			continue;
+		}
+		pc = bp->pc;
+		slot = (pc ^ (pc >> 16)) & bps->pc_index_mask;
+		while (bps->pc_index[slot] != ~0u && bps->pc_index[slot] != pc) {
+			slot = (slot + 1) & bps->pc_index_mask;
+		}
+		bps->pc_index[slot] = pc;
+
+		slot = (pc & bps->pc_bits_mask) >> bps->pc_bits_shift;
+		bps->pc_bits[slot >> 3] |= 1 << (slot & 7);
+	}
+	if (bps->pc_count == bps->count) {
+		*(bps->pc_bits_public) = bps->pc_bits;
+	}
+}
+
 
 /**
  * Check and show which breakpoints' conditions matched
@@ -312,8 +547,17 @@ static bool BreakCond_MatchBreakPoints(bc_breakpoints_t *bps)
 	bc_breakpoint_t *bp;
 	bool changes = false;
 	bool hit = false;
+	bool pc_hit = false;
 	int i;
 
+	if (bps->pc_count) {
+		pc_hit = BreakCond_MatchPcIndex(bps, bps->get_pc() & bps->pc_mask);
+		/* common case, only PC breakpoints and PC not at any of them */
+		if (!pc_hit && bps->pc_count == bps->count) {
+			return false;
+		}
+	}
+
 	/* array should not be changed while it's being traversed */
 	assert(likely(!bps->delayed_change));
 	bps->delayed_change = true;
@@ -321,7 +565,10 @@ static bool BreakCond_MatchBreakPoints(bc_breakpoints_t *bps)
 	bp = bps->breakpoint;
 	for (i = 0; i < bps->count; bp++, i++) {
 
-		if (BreakCond_MatchConditions(bp->conditions, bp->ccount)) {
+		if (bp->has_pc && !pc_hit) {
+			continue;
+		}
+		if (BreakCond_MatchConditions(bp)) {
 			bp->hits++;
 			if (bp->options.skip) {
 				if (bp->hits % bp->options.skip) {
@@ -503,6 +750,13 @@ static Uint32 GetCpuSR(void)
 {
 	return M68000_GetSR();
 }
+/**
+ * Helper function to get DSP PC register value as Uint32
+ */
+static Uint32 GetDspPC(void)
+{
+	return DSP_GetPC();
+}
 
 /**
  * If given string is register name (for DSP or CPU), set bc_value
@@ -526,6 +780,7 @@ static bool BreakCond_ParseRegister(const char *regname, bc_value_t *bc_value)
 			/* all DSP memory values are 24-bits */
 			bc_value->bits = 24;
 			bc_value->valuetype = regsize;
+			bc_value->is_pc = (strcasecmp(regname, "PC") == 0);
 			EXITFUNC(("-> true (DSP)\n"));
 			return true;
 		}
@@ -547,6 +802,7 @@ static bool BreakCond_ParseRegister(const char *regname, bc_value_t *bc_value)
 		bc_value->bits = 32;
 		bc_value->value.func32 = GetCpuPC;
 		bc_value->valuetype = VALUE_TYPE_FUNCTION32;
+		bc_value->is_pc = true;
 		EXITFUNC(("-> true (CPU)\n"));
 		return true;
 	}
@@ -1169,6 +1425,32 @@ static void BreakCond_CheckTracking(bc_breakpoint_t *bp)
 }
 
 
+/**
+ * Compile breakpoint conditions, and if one of them is "pc = <number>"
+ * comparison, add breakpoint to the PC address index.
+ */
+static void BreakCond_Compile(bc_breakpoints_t *bps, bc_breakpoint_t *bp)
+{
+	bc_condition_t *condition;
+	int i;
+
+	condition = bp->conditions;
+	for (i = 0; i < bp->ccount; condition++, i++) {
+		BreakCond_CompileCondition(condition);
+
+		if (!bp->has_pc &&
+		    condition->lvalue.is_pc && !condition->lvalue.is_indirect &&
+		    (condition->lvalue.mask & bps->pc_mask) == bps->pc_mask &&
+		    condition->comparison == '=' && !condition->track &&
+		    condition->match == BreakCond_MatchEqualNumber) {
+			bp->has_pc = true;
+			bp->pc = condition->rnumber;
+		}
+	}
+	BreakCond_UpdatePcIndex(bps);
+}
+
+
 /**
  * Parse given breakpoint expression and store it.
  * Return true for success and false for failure.
@@ -1235,6 +1517,7 @@ static bool BreakCond_Parse(const char *expression, bc_options_t *options, bool
 			}
 		}
 		BreakCond_CheckTracking(bp);
+		BreakCond_Compile(bps, bp);
 
 		bp->options.quiet = options->quiet;
 		bp->options.skip = options->skip;
@@ -1327,6 +1610,13 @@ static void BreakCond_List(bc_breakpoints_t *bps)
 	for (i = 1; i <= bps->count; bp++, i++) {
 		fprintf(stderr, "%4d:", i);
 		BreakCond_Print(bp);
+		if (bp->evals) {
+			fprintf(stderr, "\t-> evaluated %"PRIu64" times, %.2f conditions on average%s\n",
+				bp->evals, (double)bp->checks / bp->evals,
+				bp->has_pc ? " (only at its PC address)" : "");
+		} else if (bp->has_pc) {
+			fprintf(stderr, "\t-> evaluated only at its PC address\n");
+		}
 	}
 }
 
@@ -1368,6 +1658,7 @@ static bool BreakCond_Remove(bc_breakpoints_t *bps, int position)
 		memmove(bp, bp + 1, (bps->count - position) * sizeof(bc_breakpoint_t));
 	}
 	bps->count--;
+	BreakCond_UpdatePcIndex(bps);
 	return true;
 }
 
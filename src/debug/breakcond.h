@@ -17,6 +17,36 @@ extern const char BreakAddr_Description[];
 
 extern bool BreakCond_MatchCpu(void);
 extern bool BreakCond_MatchDsp(void);
+
+/* Bitmaps with a bit for each address used in "pc = <address>"
+ * breakpoint conditions: one bit per even 24-bit CPU address
+ * (higher address bits are ignored) and per DSP P memory address.
+ * Set only when all CPU/DSP breakpoints have such condition,
+ * NULL otherwise.
+ */
+#define BC_CPU_PC_BITS_MASK 0xffffff
+#define BC_DSP_PC_BITS_MASK 0xffff
+extern const Uint8 *BreakCond_CpuPcBits;
+extern const Uint8 *BreakCond_DspPcBits;
+
+/**
+ * Return true if breakpoints can't match at given CPU PC address,
+ * i.e. they all are PC breakpoints and none of them is for it.
+ */
+static inline bool BreakCond_CpuPcMiss(Uint32 pc)
+{
+	pc = (pc & BC_CPU_PC_BITS_MASK) >> 1;
+	return BreakCond_CpuPcBits && !(BreakCond_CpuPcBits[pc >> 3] & (1 << (pc & 7)));
+}
+/**
+ * Return true if breakpoints can't match at given DSP PC address
+ */
+static inline bool BreakCond_DspPcMiss(Uint32 pc)
+{
+	pc &= BC_DSP_PC_BITS_MASK;
+	return BreakCond_DspPcBits && !(BreakCond_DspPcBits[pc >> 3] & (1 << (pc & 7)));
+}
+
 extern int BreakCond_CpuBreakPointCount(void);
 extern int BreakCond_DspBreakPointCount(void);
 extern bool BreakCond_Command(const char *expression, bool bForDsp);
@@ -675,7 +675,7 @@ static const struct {
 	{ false,"ikbd",      IKBD_Info,            NULL, "Show IKBD (SCI) register contents" },
 	{ true, "memdump",   DebugInfo_CpuMemDump, NULL, "Dump CPU memory from given <address>" },
 	{ false,"mfp",       MFP_Info,             NULL, "Show MFP register contents" },
-	{ false,"mmu",       M68000_MMU_Info,      NULL, "Show MMU register contents" },
+	{ false,"mmu",       M68000_MMU_Info,      NULL, "Show MMU register contents (and 030 ATC hit statistics)" },
 	{ false,"nvram",     NvRam_Info,           NULL, "Show (TT/Falcon) NVRAM contents" },
 	{ false,"osheader",  DebugInfo_OSHeader,   NULL, "Show TOS OS header contents" },
 	{ true, "regaddr",   DebugInfo_RegAddr, DebugInfo_RegAddrArgs, "Show <disasm|memdump> from CPU/DSP address pointed by <register>" },
@@ -24,6 +24,7 @@ const char DebugCpu_fileid[] = "Hatari debugcpu.c";
 #include "evaluate.h"
 #include "hatari-glue.h"
 #include "history.h"
+#include "historycpu.h"
 #include "log.h"
 #include "m68000.h"
 #include "memorySnapShot.h"
@@ -889,9 +890,10 @@ Uint32 DebugCpu_InstrCount(void)
 }
 
 /**
- * This function is called after each CPU instruction when debugging is enabled.
+ * This function is called after each CPU instruction when several
+ * debugging features are enabled, or ones without specialized checks.
  */
-void DebugCpu_Check(void)
+static void DebugCpu_CheckAll(void)
 {
 	nCpuInstructions++;
 	if (bCpuProfiling)
@@ -907,7 +909,7 @@ void DebugCpu_Check(void)
 		uaecptr nextpc;
 		m68k_dumpstate_file(TraceFile, &nextpc, 0xffffffff);
 	}
-	if (nCpuActiveCBs)
+	if (nCpuActiveCBs && !BreakCond_CpuPcMiss(M68000_GetPC()))
 	{
 		if (BreakCond_MatchCpu())
 		{
@@ -935,25 +937,67 @@ void DebugCpu_Check(void)
 	}
 }
 
+/**
+ * Specialized versions of the above, for when only one of profiling,
+ * history or breakpoints is enabled, so that each of them costs only
+ * what it uses.
+ */
+static void DebugCpu_CheckProfile(void)
+{
+	nCpuInstructions++;
+	Profile_CpuUpdate();
+}
+
+static void DebugCpu_CheckHistory(void)
+{
+	nCpuInstructions++;
+	History_AddCpu();
+}
+
+static void DebugCpu_CheckBreak(void)
+{
+	nCpuInstructions++;
+	if (BreakCond_CpuPcMiss(M68000_GetPC()))
+		return;
+	if (BreakCond_MatchCpu())
+		DebugUI(REASON_CPU_BREAKPOINT);
+}
+
+/* Called by the CPU core after each instruction when debugging is enabled */
+void (*DebugCpu_Check)(void) = DebugCpu_CheckAll;
+
 /**
  * Should be called before returning back emulation to tell the CPU core
  * to call us after each instruction if "real-time" debugging like
- * breakpoints has been set.
+ * breakpoints has been set, and to select the check function for that.
  */
 void DebugCpu_SetDebugging(void)
 {
+	bool bHistory;
+
 	bCpuProfiling = Profile_CpuStart();
 	nCpuActiveCBs = BreakCond_CpuBreakPointCount();
-
-	if (nCpuActiveCBs || nCpuSteps || bCpuProfiling || History_TrackCpu()
-	    || LOG_TRACE_LEVEL((TRACE_CPU_DISASM|TRACE_CPU_SYMBOLS|TRACE_CPU_REGS))
-	    || ConOutDevices)
-	{
-		M68000_SetDebugger(true);
-		nCpuInstructions = 0;
-	}	
+	bHistory = History_TrackCpu();
+	if (HistoryCpu_Active)
+		HistoryCpu_InstallHooks();
+
+	if (nCpuSteps || ConOutDevices
+	    || (LogTraceFlags & (TRACE_CPU_DISASM|TRACE_CPU_SYMBOLS|TRACE_CPU_REGS))
+	    || (!!nCpuActiveCBs + bCpuProfiling + bHistory) > 1)
+		DebugCpu_Check = DebugCpu_CheckAll;
+	else if (nCpuActiveCBs)
+		DebugCpu_Check = DebugCpu_CheckBreak;
+	else if (bCpuProfiling)
+		DebugCpu_Check = DebugCpu_CheckProfile;
+	else if (bHistory)
+		DebugCpu_Check = DebugCpu_CheckHistory;
 	else
+	{
 		M68000_SetDebugger(false);
+		return;
+	}
+	M68000_SetDebugger(true);
+	nCpuInstructions = 0;
 }
 
 
@@ -10,7 +10,7 @@
 #ifndef HATARI_DEBUGCPU_H
 #define HATARI_DEBUGCPU_H
 
-extern void DebugCpu_Check(void);
+extern void (*DebugCpu_Check)(void);
 extern void DebugCpu_SetDebugging(void);
 
 extern Uint32 DebugCpu_CallDepth(void);
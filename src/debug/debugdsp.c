@@ -531,7 +531,7 @@ void DebugDsp_Check(void)
 	{
 		DebugDsp_ShowAddressInfo(DSP_GetPC(), TraceFile);
 	}
-	if (nDspActiveCBs)
+	if (nDspActiveCBs && !BreakCond_DspPcMiss(DSP_GetPC()))
 	{
 		if (BreakCond_MatchDsp())
 		{
@@ -567,7 +567,7 @@ void DebugDsp_SetDebugging(void)
 	nDspActiveCBs = BreakCond_DspBreakPointCount();
 
 	if (nDspActiveCBs || nDspSteps || bDspProfiling || History_TrackDsp()
-	    || LOG_TRACE_LEVEL((TRACE_DSP_DISASM|TRACE_DSP_SYMBOLS)))
+	    || (LogTraceFlags & (TRACE_DSP_DISASM|TRACE_DSP_SYMBOLS)))
 	{
 		DSP_SetDebugging(true);
 		nDspInstructions = 0;
@@ -25,7 +25,10 @@ const char DebugUI_fileid[] = "Hatari debugui.c";
 #include "main.h"
 #include "change.h"
 #include "configuration.h"
+#include "diskOverlay.h"
 #include "file.h"
+#include "floppy.h"
+#include "hdc.h"
 #include "log.h"
 #include "m68000.h"
 #include "memorySnapShot.h"
@@ -411,6 +414,41 @@ static int DebugUI_SetTracing(int argc, char *argv[])
 	return DEBUGGER_CMDDONE;
 }
 
+/**
+ * Command: List, enable or disable individual trace points
+ */
+static char *DebugUI_MatchTracePoint(const char *text, int state)
+{
+	static const char* types[] = { "list", "off", "on", "reset" };
+	return DebugUI_MatchHelper(types, ARRAY_SIZE(types), text, state);
+}
+static int DebugUI_TracePoint(int argc, char *argv[])
+{
+	const char *errstr;
+	int i;
+
+	if (argc == 1 || (argc == 2 && strcmp(argv[1], "list") == 0))
+	{
+		Log_ListTracePoints(debugOutput);
+		return DEBUGGER_CMDDONE;
+	}
+	if (argc == 2 && strcmp(argv[1], "reset") == 0)
+	{
+		Log_ResetTracePoints();
+		return DEBUGGER_CMDDONE;
+	}
+	if (argc < 3 || (strcmp(argv[1], "on") != 0 && strcmp(argv[1], "off") != 0))
+		return DebugUI_PrintCmdHelp(argv[0]);
+
+	for (i = 2; i < argc; i++)
+	{
+		errstr = Log_SetTracePoints(argv[i], strcmp(argv[1], "on") == 0);
+		if (errstr)
+			fprintf(stderr, "ERROR: '%s': %s\n", argv[i], errstr);
+	}
+	return DEBUGGER_CMDDONE;
+}
+
 /**
  * Command: Change Hatari work directory
  */
@@ -448,6 +486,46 @@ static int DebugUI_Rename(int argc, char *argv[])
 }
 
 
+/**
+ * Command: Show, merge or discard disk image overlays
+ */
+static char *DebugUI_MatchOverlay(const char *text, int state)
+{
+	static const char* types[] = { "discard", "info", "merge" };
+	return DebugUI_MatchHelper(types, ARRAY_SIZE(types), text, state);
+}
+static int DebugUI_Overlay(int argc, char *argv[])
+{
+	int failed;
+
+	if (argc != 2)
+		return DebugUI_PrintCmdHelp(argv[0]);
+
+	if (strcmp(argv[1], "info") == 0)
+	{
+		DiskOverlay_Info(debugOutput, 0);
+		return DEBUGGER_CMDDONE;
+	}
+	if (!DiskOverlay_IsEnabled())
+	{
+		fprintf(stderr, "Disk image overlays are not enabled (see --disk-overlay).\n");
+		return DEBUGGER_CMDDONE;
+	}
+	/* overlays must not be written meanwhile by the disk I/O thread */
+	HDC_IoWaitAll();
+	if (strcmp(argv[1], "merge") == 0)
+		failed = DiskOverlay_MergeAll() + Floppy_MergeOverlays(true);
+	else if (strcmp(argv[1], "discard") == 0)
+		failed = DiskOverlay_DiscardAll() + Floppy_MergeOverlays(false);
+	else
+		return DebugUI_PrintCmdHelp(argv[0]);
+
+	if (failed)
+		fprintf(stderr, "ERROR: %d overlay(s) could not be handled!\n", failed);
+	return DEBUGGER_CMDDONE;
+}
+
+
 /**
  * Command: Reset emulation
  */
@@ -969,12 +1047,19 @@ static const dbgcommand_t uicommand[] =
 	{ History_Parse, History_Match,
 	  "history", "hi",
 	  "show last CPU/DSP PC values & executed instructions",
-	  "cpu|dsp|on|off|<count> [limit]|save <file>\n"
+	  "cpu|dsp|on|off|<count> [limit]|save <file>|full <MB> [file]|load <file>|regs [count]|writer <address>\n"
 	  "\t'cpu' and 'dsp' enable instruction history tracking for just given\n"
 	  "\tprocessor, 'on' tracks them both, 'off' will disable history.\n"
 	  "\tOptional 'limit' will set how many past instructions are tracked.\n"
 	  "\tGiving just count will show (at max) given number of last saved PC\n"
-	  "\tvalues and instructions currently at corresponding RAM addresses.",
+	  "\tvalues and instructions currently at corresponding RAM addresses.\n"
+	  "\n"
+	  "\t'full <MB> [file]' records also CPU register and SR changes and\n"
+	  "\tRAM writes done by each instruction, into ring buffer of given\n"
+	  "\tsize, and optionally streams all of it to given file. 'load <file>'\n"
+	  "\tloads such a file instead. 'regs [count]' shows them for last\n"
+	  "\tinstructions, and 'writer <address>' which instruction last\n"
+	  "\twrote to given address.",
 	  false },
 	{ DebugInfo_Command, DebugInfo_MatchInfo,
 	  "info", "i",
@@ -997,6 +1082,15 @@ static const dbgcommand_t uicommand[] =
 	  "\tOpen log file, no argument closes the log file. Output of\n"
 	  "\tregister & memory dumps and disassembly will be written to it.",
 	  false },
+	{ DebugUI_Overlay, DebugUI_MatchOverlay,
+	  "overlay", "",
+	  "show, merge or discard disk image overlays",
+	  "<info|merge|discard>\n"
+	  "\t'info' lists the HD image overlays in use, 'merge' writes\n"
+	  "\tthe HD and floppy overlay contents back to the images and\n"
+	  "\t'discard' throws them away.  As emulated OS can have disk\n"
+	  "\tcontents cached, discarding is best followed by a reset.",
+	  false },
 	{ DebugUI_CommandsFromFile, NULL,
 	  "parse", "p",
 	  "get debugger commands from file",
@@ -1050,6 +1144,19 @@ static const dbgcommand_t uicommand[] =
 	  "\tsettings.  For example, to enable CPU disassembly and VBL\n"
 	  "\ttracing, use:\n\t\ttrace cpu_disasm,video_hbl",
 	  false },
+	{ DebugUI_TracePoint, DebugUI_MatchTracePoint,
+	  "tracepoint", "",
+	  "list, enable or disable individual trace points",
+	  "[list|reset|<on|off> <point> [point...]]\n"
+	  "\tEach trace call site is a trace point, which gets a number\n"
+	  "\twhen it's executed first time.  'list' (default) shows those\n"
+	  "\twith their hit counts, 'on' and 'off' enable and disable\n"
+	  "\tgiven points regardless of the 'trace' settings, and 'reset'\n"
+	  "\tdisables all of them and zeroes their hit counts.  Point can\n"
+	  "\tbe its number, 'all', or source file name with optional line\n"
+	  "\tnumber, which applies also to points executed later, e.g.:\n"
+	  "\t\ttracepoint on fdc.c:1234",
+	  false },
 	{ Vars_List, NULL,
 	  "variables", "v",
 	  "List builtin symbols / variables",
@@ -21,6 +21,7 @@ const char History_fileid[] = "Hatari history.c";
 #include "evaluate.h"
 #include "file.h"
 #include "history.h"
+#include "historycpu.h"
 #include "m68000.h"
 #include "68kDisass.h"
 
@@ -107,6 +108,9 @@ static void History_Enable(history_type_t track, unsigned limit)
 	default:
 		msg = "error";
 	}
+	if (!(track & HISTORY_TRACK_CPU)) {
+		HistoryCpu_Disable();
+	}
 	HistoryTracking = track;
 	fprintf(stderr, "History tracking %s (max. %d instructions).\n", msg, limit);
 }
@@ -134,6 +138,10 @@ void History_AddCpu(void)
 	History_Advance();
 	History.item[History.idx].for_dsp = false;
 	History.item[History.idx].pc.cpu = pc;
+
+	if (unlikely(HistoryCpu_Active)) {
+		HistoryCpu_Add();
+	}
 }
 
 /**
@@ -294,7 +302,7 @@ static void History_Save(const char *name)
  */
 char *History_Match(const char *text, int state)
 {
-	static const char* cmds[] = { "cpu", "dsp", "off", "save" };
+	static const char* cmds[] = { "cpu", "dsp", "full", "load", "off", "regs", "save", "writer" };
 	return DebugUI_MatchHelper(cmds, ARRAY_SIZE(cmds), text, state);
 }
 
@@ -304,10 +312,44 @@ char *History_Match(const char *text, int state)
 int History_Parse(int nArgc, char *psArgs[])
 {
 	int count, limit = 0;
+	Uint32 addr;
 
 	if (nArgc < 2) {
 		return DebugUI_PrintCmdHelp(psArgs[0]);
 	}
+	/* full CPU history sub-commands */
+	if (strcmp(psArgs[1], "full") == 0) {
+		if (nArgc < 3 || nArgc > 4 || atoi(psArgs[2]) <= 0) {
+			return DebugUI_PrintCmdHelp(psArgs[0]);
+		}
+		if (HistoryCpu_Enable(atoi(psArgs[2]), nArgc == 4 ? psArgs[3] : NULL)) {
+			limit = History.limit ? History.limit : HISTORY_ITEMS_MIN;
+			History_Enable(HistoryTracking | HISTORY_TRACK_CPU, limit);
+		}
+		return DEBUGGER_CMDDONE;
+	}
+	if (strcmp(psArgs[1], "load") == 0) {
+		if (nArgc != 3) {
+			return DebugUI_PrintCmdHelp(psArgs[0]);
+		}
+		HistoryCpu_Load(psArgs[2]);
+		return DEBUGGER_CMDDONE;
+	}
+	if (strcmp(psArgs[1], "regs") == 0) {
+		HistoryCpu_Show(stderr, nArgc > 2 ? atoi(psArgs[2]) : 0);
+		return DEBUGGER_CMDDONE;
+	}
+	if (strcmp(psArgs[1], "writer") == 0) {
+		if (nArgc != 3) {
+			return DebugUI_PrintCmdHelp(psArgs[0]);
+		}
+		if (!Eval_Number(psArgs[2], &addr)) {
+			fprintf(stderr, "ERROR: invalid address '%s'!\n", psArgs[2]);
+			return DEBUGGER_CMDDONE;
+		}
+		HistoryCpu_ShowWriter(addr);
+		return DEBUGGER_CMDDONE;
+	}
 	if (nArgc > 2) {
 		limit = atoi(psArgs[2]);
 	}
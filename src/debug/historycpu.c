@@ -0,0 +1,763 @@
+/*
+ * Hatari - historycpu.c
+ *
+ * This file is distributed under the GNU General Public License, version 2
+ * or at your option any later version. Read the file gpl.txt for details.
+ *
+ * historycpu.c - full CPU instruction history, which records also
+ * the register and SR changes and the memory writes done by each
+ * instruction.
+ *
+ * Records are delta-encoded into a ring of fixed size chunks. Each
+ * chunk starts with the full register state, so it can be decoded
+ * on its own, and oldest chunks can be dropped when the ring is full.
+ * Completed chunks can also be streamed to a file, for traces longer
+ * than what fits into memory, and such a file loaded back for viewing.
+ *
+ * Stream file format, all values being little-endian:
+ * - "HATHIST1" magic
+ * - chunks, each starting with 88 byte header: chunk size including
+ *   the header (Uint32), record count (Uint32), number of the first
+ *   record (Uint64), D0-D7/A0-A7 (16*Uint32), PC (Uint32), SR (Uint16)
+ *   and padding (Uint16), followed by the records described at
+ *   HistoryCpu_Add()
+ *
+ * Memory writes are caught by replacing the RAM memory banks with
+ * copies that record the write before calling the original bank
+ * write function.
+ */
+const char HistoryCpu_fileid[] = "Hatari historycpu.c";
+
+#include <errno.h>
+#include <inttypes.h>
+#include "main.h"
+#include "configuration.h"
+#include "debugui.h"
+#include "debug_priv.h"
+#include "file.h"
+#include "hatari-glue.h"	/* for currprefs */
+#include "history.h"
+#include "historycpu.h"
+#include "m68000.h"
+#include "68kDisass.h"
+
+#define HISTCPU_MAGIC	"HATHIST1"
+
+#define CHUNK_SIZE	(64*1024)
+
+/* max. memory writes recorded for single instruction
+ * (MOVEM + exception stack frame), must fit into flags
+ */
+#define MAX_WRITES	48
+/* max. size of an encoded record */
+#define RECORD_MAX	(1 + 5 + 2 + 16*5 + 2 + MAX_WRITES*(5+1+5))
+
+/* record flags, rest of the bits are memory write count */
+#define REC_REGS	0x01	/* register change mask follows */
+#define REC_SR		0x02	/* SR value follows */
+#define REC_WRITES_SHIFT 2
+
+/* max. number of different RAM banks to wrap */
+#define MAX_BANKS	16
+
+/* signed values as variable length unsigned ints */
+#define ZIGZAG(d)	(((Uint32)(d) << 1) ^ (Uint32)((Sint32)(d) >> 31))
+#define UNZIGZAG(v)	(((v) >> 1) ^ -((v) & 1))
+
+/* same layout as chunk header in stream file, without any padding */
+typedef struct {
+	Uint32 size;		/* bytes used, including this header */
+	Uint32 records;		/* records in this chunk */
+	Uint64 first;		/* number of the first record */
+	Uint32 regs[16];	/* D0-D7/A0-A7 before first record */
+	Uint32 pc;		/* PC before first record */
+	Uint16 sr;		/* SR before first record */
+	Uint16 pad;
+} hist_chunk_t;
+
+typedef struct {
+	Uint32 addr;
+	Uint32 value;
+	int size;
+} hist_write_t;
+
+/* decoded record */
+typedef struct {
+	Uint64 number;
+	Uint32 pc;		/* executed instruction */
+	Uint32 nextpc;		/* PC after it */
+	Uint32 regs[16];	/* registers after it */
+	Uint16 sr;
+	Uint16 changed;		/* changed registers mask */
+	bool sr_changed;
+	int nwrites;
+	hist_write_t writes[MAX_WRITES];
+} hist_record_t;
+
+static struct {
+	Uint8 *buf;		/* ring of CHUNK_SIZE chunks */
+	int chunks;		/* ring size */
+	int used;		/* valid chunks in ring */
+	int cur;		/* index of current chunk */
+	hist_chunk_t *chunk;	/* current chunk */
+	Uint64 records;		/* total recorded */
+	Uint64 lost;		/* memory writes not recorded */
+	/* state after last record */
+	Uint32 regs[16];
+	Uint32 pc;
+	Uint16 sr;
+	Uint32 waddr;		/* previous write address in chunk */
+	/* writes for current instruction */
+	int nwrites;
+	hist_write_t writes[MAX_WRITES];
+	Uint32 addrmask;	/* for 24-bit address space */
+	FILE *fp;		/* file where chunks are streamed */
+	Uint64 saved;		/* chunks saved to file */
+} HistCpu;
+
+/* whether full history is being recorded */
+bool HistoryCpu_Active;
+
+/* memory bank wrappers */
+static addrbank **OrigBanks;
+static struct {
+	addrbank *orig;
+	addrbank copy;
+} Wrapped[MAX_BANKS];
+static int nWrapped;
+
+
+/* ------------------ memory write tracking ------------------ */
+
+/**
+ * Store memory write done by the current instruction
+ */
+static void HistoryCpu_AddWrite(uaecptr addr, int size, uae_u32 value)
+{
+	hist_write_t *w;
+
+	if (unlikely(HistCpu.nwrites >= MAX_WRITES)) {
+		HistCpu.lost++;
+		return;
+	}
+	w = &HistCpu.writes[HistCpu.nwrites++];
+	w->addr = addr & HistCpu.addrmask;
+	w->value = value;
+	w->size = size;
+}
+
+static void REGPARAM2 HistoryCpu_lput(uaecptr addr, uae_u32 v)
+{
+	HistoryCpu_AddWrite(addr, 4, v);
+	OrigBanks[bankindex(addr)]->lput(addr, v);
+}
+static void REGPARAM2 HistoryCpu_wput(uaecptr addr, uae_u32 v)
+{
+	HistoryCpu_AddWrite(addr, 2, v);
+	OrigBanks[bankindex(addr)]->wput(addr, v);
+}
+static void REGPARAM2 HistoryCpu_bput(uaecptr addr, uae_u32 v)
+{
+	HistoryCpu_AddWrite(addr, 1, v);
+	OrigBanks[bankindex(addr)]->bput(addr, v);
+}
+
+/**
+ * Return true if given bank is one of the write tracking wrappers
+ */
+static bool HistoryCpu_IsWrapper(const addrbank *bank)
+{
+	int i;
+	for (i = 0; i < nWrapped; i++) {
+		if (bank == &Wrapped[i].copy) {
+			return true;
+		}
+	}
+	return false;
+}
+
+/**
+ * Return (updated) write tracking wrapper for given bank,
+ * or NULL if there are too many of them.
+ */
+static addrbank *HistoryCpu_GetWrapper(addrbank *bank)
+{
+	addrbank *copy;
+	int i;
+
+	for (i = 0; i < nWrapped; i++) {
+		if (Wrapped[i].orig == bank) {
+			break;
+		}
+	}
+	if (i == nWrapped) {
+		if (nWrapped >= MAX_BANKS) {
+			return NULL;
+		}
+		Wrapped[nWrapped++].orig = bank;
+	}
+	/* original bank settings may have changed since last time */
+	copy = &Wrapped[i].copy;
+	*copy = *bank;
+	copy->lput = HistoryCpu_lput;
+	copy->wput = HistoryCpu_wput;
+	copy->bput = HistoryCpu_bput;
+	/* writes need to go through above functions */
+	copy->baseaddr_direct_w = NULL;
+	return copy;
+}
+
+/**
+ * Replace RAM memory banks with write tracking wrappers.
+ * Needs to be redone after memory banks get re-mapped, which
+ * memory_init() and memory_map_Standard_RAM() do.
+ */
+void HistoryCpu_InstallHooks(void)
+{
+	addrbank *bank, *copy;
+	int i;
+
+	if (!HistoryCpu_Active) {
+		return;
+	}
+	for (i = 0; i < MEMORY_BANKS; i++) {
+		bank = mem_banks[i];
+		if (!bank || HistoryCpu_IsWrapper(bank)) {
+			continue;
+		}
+		OrigBanks[i] = bank;
+		/* other banks can be compared against, or give bus errors */
+		if (!(bank->flags & ABFLAG_RAM)) {
+			continue;
+		}
+		copy = HistoryCpu_GetWrapper(bank);
+		if (copy) {
+			mem_banks[i] = copy;
+		}
+	}
+	HistCpu.addrmask = currprefs.address_space_24 ? 0xffffff : 0xffffffff;
+}
+
+/**
+ * Restore original memory banks
+ */
+static void HistoryCpu_RemoveHooks(void)
+{
+	int i;
+
+	for (i = 0; i < MEMORY_BANKS; i++) {
+		if (HistoryCpu_IsWrapper(mem_banks[i])) {
+			mem_banks[i] = OrigBanks[i];
+		}
+	}
+	nWrapped = 0;
+}
+
+
+/* ------------------ recording ------------------ */
+
+static Uint8 *HistoryCpu_PutVarint(Uint8 *p, Uint32 value)
+{
+	while (value >= 0x80) {
+		*p++ = value | 0x80;
+		value >>= 7;
+	}
+	*p++ = value;
+	return p;
+}
+
+/**
+ * Convert chunk header between host and stream file (little-endian)
+ * byte order
+ */
+static void HistoryCpu_SwapHeader(hist_chunk_t *dst, const hist_chunk_t *src)
+{
+	int i;
+
+	dst->size = SDL_SwapLE32(src->size);
+	dst->records = SDL_SwapLE32(src->records);
+	dst->first = SDL_SwapLE64(src->first);
+	for (i = 0; i < 16; i++) {
+		dst->regs[i] = SDL_SwapLE32(src->regs[i]);
+	}
+	dst->pc = SDL_SwapLE32(src->pc);
+	dst->sr = SDL_SwapLE16(src->sr);
+	dst->pad = 0;
+}
+
+/**
+ * Write completed chunk to the stream file
+ */
+static void HistoryCpu_SaveChunk(const hist_chunk_t *chunk)
+{
+	hist_chunk_t header;
+	size_t len = chunk->size - sizeof(header);
+
+	HistoryCpu_SwapHeader(&header, chunk);
+	if (fwrite(&header, sizeof(header), 1, HistCpu.fp) != 1 ||
+	    fwrite(chunk + 1, 1, len, HistCpu.fp) != len) {
+		fprintf(stderr, "ERROR: writing CPU history failed (%d), streaming stopped!\n", errno);
+		fclose(HistCpu.fp);
+		HistCpu.fp = NULL;
+		return;
+	}
+	HistCpu.saved++;
+}
+
+/**
+ * Start new chunk with current register state
+ */
+static void HistoryCpu_NextChunk(void)
+{
+	hist_chunk_t *chunk;
+
+	if (HistCpu.chunk && HistCpu.fp) {
+		HistoryCpu_SaveChunk(HistCpu.chunk);
+	}
+	HistCpu.cur = (HistCpu.cur + 1) % HistCpu.chunks;
+	if (HistCpu.used < HistCpu.chunks) {
+		HistCpu.used++;
+	}
+	chunk = (hist_chunk_t *)(HistCpu.buf + (size_t)HistCpu.cur * CHUNK_SIZE);
+	chunk->size = sizeof(hist_chunk_t);
+	chunk->records = 0;
+	chunk->first = HistCpu.records;
+	memcpy(chunk->regs, HistCpu.regs, sizeof(chunk->regs));
+	chunk->pc = HistCpu.pc;
+	chunk->sr = HistCpu.sr;
+	chunk->pad = 0;
+	HistCpu.chunk = chunk;
+	HistCpu.waddr = 0;
+}
+
+/**
+ * Add record of register changes and memory writes by the last
+ * executed CPU instruction, and PC of the next one.
+ *
+ * Record is:
+ * - flags byte: REC_* bits + memory write count
+ * - PC change from previous record (zigzag varint)
+ * - if REC_REGS: little-endian Uint16 mask of changed D0-D7/A0-A7
+ *   registers, followed by their value changes (zigzag varints)
+ * - if REC_SR: little-endian Uint16 SR value
+ * - for each write: address change from previous write (zigzag
+ *   varint), size byte and value (varint)
+ */
+void HistoryCpu_Add(void)
+{
+	Uint8 *p, *flags;
+	Uint32 pc, value;
+	Uint16 sr, mask = 0;
+	int i;
+
+	if (HistCpu.chunk->size + RECORD_MAX > CHUNK_SIZE) {
+		HistoryCpu_NextChunk();
+	}
+	p = (Uint8 *)HistCpu.chunk + HistCpu.chunk->size;
+	flags = p++;
+	*flags = HistCpu.nwrites << REC_WRITES_SHIFT;
+
+	pc = M68000_GetPC();
+	p = HistoryCpu_PutVarint(p, ZIGZAG(pc - HistCpu.pc));
+	HistCpu.pc = pc;
+
+	for (i = 0; i < 16; i++) {
+		if (regs.regs[i] != HistCpu.regs[i]) {
+			mask |= 1 << i;
+		}
+	}
+	if (mask) {
+		*flags |= REC_REGS;
+		*p++ = mask;
+		*p++ = mask >> 8;
+		for (i = 0; i < 16; i++) {
+			if (mask & (1 << i)) {
+				value = regs.regs[i];
+				p = HistoryCpu_PutVarint(p, ZIGZAG(value - HistCpu.regs[i]));
+				HistCpu.regs[i] = value;
+			}
+		}
+	}
+	sr = M68000_GetSR();
+	if (sr != HistCpu.sr) {
+		*flags |= REC_SR;
+		*p++ = sr;
+		*p++ = sr >> 8;
+		HistCpu.sr = sr;
+	}
+	for (i = 0; i < HistCpu.nwrites; i++) {
+		const hist_write_t *w = &HistCpu.writes[i];
+		p = HistoryCpu_PutVarint(p, ZIGZAG(w->addr - HistCpu.waddr));
+		*p++ = w->size;
+		p = HistoryCpu_PutVarint(p, w->value);
+		HistCpu.waddr = w->addr;
+	}
+	HistCpu.nwrites = 0;
+
+	HistCpu.chunk->size = p - (Uint8 *)HistCpu.chunk;
+	HistCpu.chunk->records++;
+	HistCpu.records++;
+}
+
+
+/* ------------------ decoding ------------------ */
+
+static const Uint8 *HistoryCpu_GetVarint(const Uint8 *p, Uint32 *value)
+{
+	Uint32 v = 0;
+	int shift = 0;
+
+	while (*p & 0x80) {
+		v |= (Uint32)(*p++ & 0x7f) << shift;
+		shift += 7;
+	}
+	*value = v | ((Uint32)*p++ << shift);
+	return p;
+}
+
+/**
+ * Return given chunk in memory, counting from the oldest one
+ */
+static const hist_chunk_t *HistoryCpu_Chunk(int c)
+{
+	int idx = (HistCpu.cur + HistCpu.chunks - HistCpu.used + 1 + c) % HistCpu.chunks;
+	return (const hist_chunk_t *)(HistCpu.buf + (size_t)idx * CHUNK_SIZE);
+}
+
+/**
+ * Decode all records in memory, oldest first, and call given
+ * callback for each of them
+ */
+static void HistoryCpu_Decode(void (*callback)(const hist_record_t *rec, void *data),
+                              void *data)
+{
+	const hist_chunk_t *chunk;
+	const Uint8 *p, *end;
+	hist_record_t rec;
+	Uint32 value, waddr;
+	Uint8 flags;
+	int c, i;
+
+	for (c = 0; c < HistCpu.used; c++) {
+		chunk = HistoryCpu_Chunk(c);
+
+		memcpy(rec.regs, chunk->regs, sizeof(rec.regs));
+		rec.nextpc = chunk->pc;
+		rec.sr = chunk->sr;
+		rec.number = chunk->first;
+		waddr = 0;
+
+		p = (const Uint8 *)chunk + sizeof(hist_chunk_t);
+		end = (const Uint8 *)chunk + chunk->size;
+		while (p < end) {
+			flags = *p++;
+			rec.pc = rec.nextpc;
+			p = HistoryCpu_GetVarint(p, &value);
+			rec.nextpc += UNZIGZAG(value);
+
+			rec.changed = 0;
+			if (flags & REC_REGS) {
+				rec.changed = p[0] | (p[1] << 8);
+				p += 2;
+				for (i = 0; i < 16; i++) {
+					if (rec.changed & (1 << i)) {
+						p = HistoryCpu_GetVarint(p, &value);
+						rec.regs[i] += UNZIGZAG(value);
+					}
+				}
+			}
+			rec.sr_changed = flags & REC_SR;
+			if (rec.sr_changed) {
+				rec.sr = p[0] | (p[1] << 8);
+				p += 2;
+			}
+			rec.nwrites = flags >> REC_WRITES_SHIFT;
+			for (i = 0; i < rec.nwrites; i++) {
+				p = HistoryCpu_GetVarint(p, &value);
+				waddr += UNZIGZAG(value);
+				rec.writes[i].addr = waddr;
+				rec.writes[i].size = *p++;
+				p = HistoryCpu_GetVarint(p, &rec.writes[i].value);
+			}
+			callback(&rec, data);
+			rec.number++;
+		}
+	}
+}
+
+/**
+ * Output given record: instruction and its effects
+ */
+static void HistoryCpu_ShowRecord(const hist_record_t *rec, FILE *fp)
+{
+	static const char sizes[] = "?bw?l";
+	Uint32 dummy;
+	int i;
+
+	Disasm(fp, rec->pc, &dummy, 1);
+	if (!(rec->changed || rec->sr_changed || rec->nwrites)) {
+		return;
+	}
+	fputs("\t->", fp);
+	for (i = 0; i < 16; i++) {
+		if (rec->changed & (1 << i)) {
+			fprintf(fp, " %c%d=$%x", i < 8 ? 'D' : 'A', i & 7, rec->regs[i]);
+		}
+	}
+	if (rec->sr_changed) {
+		fprintf(fp, " SR=$%04x", rec->sr);
+	}
+	for (i = 0; i < rec->nwrites; i++) {
+		fprintf(fp, " ($%x).%c=$%x", rec->writes[i].addr,
+			sizes[rec->writes[i].size], rec->writes[i].value);
+	}
+	fputs("\n", fp);
+}
+
+typedef struct {
+	Uint64 from;
+	FILE *fp;
+} show_data_t;
+
+static void HistoryCpu_ShowCallback(const hist_record_t *rec, void *data)
+{
+	show_data_t *show = data;
+	if (rec->number >= show->from) {
+		HistoryCpu_ShowRecord(rec, show->fp);
+	}
+}
+
+/**
+ * Show given number of last records, all if count is zero
+ */
+void HistoryCpu_Show(FILE *fp, Uint32 count)
+{
+	show_data_t show;
+	Uint64 stored;
+
+	if (!HistCpu.buf) {
+		fprintf(stderr, "Full CPU history is not enabled or loaded.\n");
+		return;
+	}
+
+	stored = HistCpu.records - HistoryCpu_Chunk(0)->first;
+	if (!stored) {
+		fprintf(stderr, "No full CPU history recorded yet.\n");
+		return;
+	}
+	if (!count || count > stored) {
+		count = stored;
+	}
+	show.from = HistCpu.records - count;
+	show.fp = fp;
+	HistoryCpu_Decode(HistoryCpu_ShowCallback, &show);
+}
+
+typedef struct {
+	Uint32 addr;
+	bool found;
+	hist_record_t rec;
+} writer_data_t;
+
+static void HistoryCpu_WriterCallback(const hist_record_t *rec, void *data)
+{
+	writer_data_t *writer = data;
+	int i;
+
+	for (i = 0; i < rec->nwrites; i++) {
+		if (writer->addr >= rec->writes[i].addr &&
+		    writer->addr < rec->writes[i].addr + rec->writes[i].size) {
+			writer->rec = *rec;
+			writer->found = true;
+			return;
+		}
+	}
+}
+
+/**
+ * Show which instruction last wrote given address
+ */
+void HistoryCpu_ShowWriter(Uint32 addr)
+{
+	writer_data_t writer;
+
+	if (!HistCpu.buf) {
+		fprintf(stderr, "Full CPU history is not enabled or loaded.\n");
+		return;
+	}
+
+	writer.addr = addr & HistCpu.addrmask;
+	writer.found = false;
+	HistoryCpu_Decode(HistoryCpu_WriterCallback, &writer);
+
+	if (!writer.found) {
+		fprintf(stderr, "No write to $%x in the full CPU history in memory.\n", addr);
+		return;
+	}
+	fprintf(stderr, "$%x was last written %"PRIu64" instructions ago, by:\n",
+		addr, HistCpu.records - writer.rec.number);
+	HistoryCpu_ShowRecord(&writer.rec, stderr);
+}
+
+
+/* ------------------ enabling & command ------------------ */
+
+/**
+ * Stop full history recording, free its data and close stream file
+ */
+void HistoryCpu_Disable(void)
+{
+	if (!HistCpu.buf) {
+		return;
+	}
+	HistoryCpu_RemoveHooks();
+	if (HistCpu.fp) {
+		HistoryCpu_SaveChunk(HistCpu.chunk);
+		if (HistCpu.fp) {
+			fprintf(stderr, "%"PRIu64" full CPU history chunks saved.\n", HistCpu.saved);
+			fclose(HistCpu.fp);
+		}
+	}
+	if (HistCpu.lost) {
+		fprintf(stderr, "WARNING: %"PRIu64" memory writes were not recorded (max %d per instruction).\n",
+			HistCpu.lost, MAX_WRITES);
+	}
+	free(HistCpu.buf);
+	free(OrigBanks);
+	OrigBanks = NULL;
+	memset(&HistCpu, 0, sizeof(HistCpu));
+	HistoryCpu_Active = false;
+	fprintf(stderr, "Full CPU history disabled.\n");
+}
+
+/**
+ * Start full history recording into ring buffer of given size,
+ * and optionally stream it to given file.
+ */
+bool HistoryCpu_Enable(int megabytes, const char *filename)
+{
+	HistoryCpu_Disable();
+
+	if (filename) {
+		if (File_Exists(filename)) {
+			fprintf(stderr, "ERROR: file '%s' already exists!\n", filename);
+			return false;
+		}
+		HistCpu.fp = fopen(filename, "wb");
+		if (!HistCpu.fp) {
+			fprintf(stderr, "ERROR: opening '%s' failed (%d).\n", filename, errno);
+			return false;
+		}
+		fwrite(HISTCPU_MAGIC, strlen(HISTCPU_MAGIC), 1, HistCpu.fp);
+	}
+	HistCpu.chunks = megabytes * (1024*1024 / CHUNK_SIZE);
+	HistCpu.buf = malloc((size_t)HistCpu.chunks * CHUNK_SIZE);
+	OrigBanks = calloc(MEMORY_BANKS, sizeof(*OrigBanks));
+	if (!(HistCpu.buf && OrigBanks)) {
+		fprintf(stderr, "ERROR: full CPU history allocation failed!\n");
+		if (HistCpu.fp) {
+			fclose(HistCpu.fp);
+		}
+		free(HistCpu.buf);
+		free(OrigBanks);
+		OrigBanks = NULL;
+		memset(&HistCpu, 0, sizeof(HistCpu));
+		return false;
+	}
+	HistCpu.cur = HistCpu.chunks - 1;
+	memcpy(HistCpu.regs, regs.regs, sizeof(HistCpu.regs));
+	HistCpu.pc = M68000_GetPC();
+	HistCpu.sr = M68000_GetSR();
+	HistoryCpu_NextChunk();
+	HistoryCpu_Active = true;
+	HistoryCpu_InstallHooks();
+
+	fprintf(stderr, "Full CPU history enabled (%d MB%s%s).\n", megabytes,
+		filename ? ", streamed to " : "", filename ? filename : "");
+	return true;
+}
+
+/**
+ * Load full CPU history streamed to given file into memory, for
+ * viewing it with the same commands as recorded history.  Stops
+ * current recording.
+ */
+bool HistoryCpu_Load(const char *filename)
+{
+	hist_chunk_t header, *chunk;
+	char magic[sizeof(HISTCPU_MAGIC) - 1];
+	size_t len;
+	int chunks = 0;
+	FILE *fp;
+
+	HistoryCpu_Disable();
+
+	fp = fopen(filename, "rb");
+	if (!fp) {
+		fprintf(stderr, "ERROR: opening '%s' failed (%d).\n", filename, errno);
+		return false;
+	}
+	if (fread(magic, sizeof(magic), 1, fp) != 1 ||
+	    memcmp(magic, HISTCPU_MAGIC, sizeof(magic)) != 0) {
+		fprintf(stderr, "ERROR: '%s' is not a full CPU history file!\n", filename);
+		fclose(fp);
+		return false;
+	}
+
+	/* count chunks for the ring size */
+	while (fread(&header, sizeof(header), 1, fp) == 1) {
+		HistoryCpu_SwapHeader(&header, &header);
+		if (header.size < sizeof(header) || header.size > CHUNK_SIZE ||
+		    fseeko(fp, header.size - sizeof(header), SEEK_CUR) != 0) {
+			break;
+		}
+		chunks++;
+	}
+	if (!chunks) {
+		fprintf(stderr, "ERROR: no full CPU history in '%s'!\n", filename);
+		fclose(fp);
+		return false;
+	}
+	HistCpu.buf = malloc((size_t)chunks * CHUNK_SIZE);
+	if (!HistCpu.buf) {
+		fprintf(stderr, "ERROR: full CPU history allocation failed!\n");
+		fclose(fp);
+		return false;
+	}
+	HistCpu.chunks = chunks;
+
+	fseeko(fp, sizeof(magic), SEEK_SET);
+	while (HistCpu.used < chunks) {
+		chunk = (hist_chunk_t *)(HistCpu.buf + (size_t)HistCpu.used * CHUNK_SIZE);
+		if (fread(&header, sizeof(header), 1, fp) != 1) {
+			break;
+		}
+		HistoryCpu_SwapHeader(chunk, &header);
+		len = chunk->size - sizeof(header);
+		if (fread(chunk + 1, 1, len, fp) != len) {
+			break;
+		}
+		HistCpu.chunk = chunk;
+		HistCpu.used++;
+	}
+	fclose(fp);
+
+	if (!HistCpu.used) {
+		fprintf(stderr, "ERROR: '%s' is truncated!\n", filename);
+		free(HistCpu.buf);
+		memset(&HistCpu, 0, sizeof(HistCpu));
+		return false;
+	}
+	if (HistCpu.used < chunks) {
+		fprintf(stderr, "WARNING: '%s' is truncated, ignoring its last chunk.\n", filename);
+	}
+	/* ring is full, with the last loaded chunk as current one */
+	HistCpu.chunks = HistCpu.used;
+	HistCpu.cur = HistCpu.used - 1;
+	HistCpu.records = HistCpu.chunk->first + HistCpu.chunk->records;
+	HistCpu.addrmask = currprefs.address_space_24 ? 0xffffff : 0xffffffff;
+
+	fprintf(stderr, "%d full CPU history chunks (%"PRIu64" instructions) loaded from '%s'.\n",
+		HistCpu.used, HistCpu.records - HistoryCpu_Chunk(0)->first, filename);
+	return true;
+}
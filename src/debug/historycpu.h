@@ -0,0 +1,24 @@
+/*
+  Hatari - historycpu.h
+
+  This file is distributed under the GNU General Public License, version 2
+  or at your option any later version. Read the file gpl.txt for details.
+*/
+
+#ifndef HATARI_HISTORYCPU_H
+#define HATARI_HISTORYCPU_H
+
+extern bool HistoryCpu_Active;
+
+/* for history.c */
+extern void HistoryCpu_Add(void);
+extern bool HistoryCpu_Enable(int megabytes, const char *filename);
+extern void HistoryCpu_Disable(void);
+extern bool HistoryCpu_Load(const char *filename);
+extern void HistoryCpu_Show(FILE *fp, Uint32 count);
+extern void HistoryCpu_ShowWriter(Uint32 addr);
+
+/* for debugcpu.c & memory.c, memory banks may have been re-mapped */
+extern void HistoryCpu_InstallHooks(void);
+
+#endif
@@ -21,12 +21,14 @@ const char Log_fileid[] = "Hatari log.c";
 #include <string.h>
 #include <ctype.h>
 #include <assert.h>
+#include <SDL.h>
 
 #include "main.h"
 #include "configuration.h"
 #include "console.h"
 #include "dialog.h"
 #include "log.h"
+#include "tracebuf.h"
 #include "screen.h"
 #include "file.h"
 #include "vdi.h"
@@ -204,7 +206,11 @@ int Log_Init(void)
 
 	hLogFile = File_Open(ConfigureParams.Log.sLogFileName, "w");
 	TraceFile = File_Open(ConfigureParams.Log.sTraceFileName, "w");
-   
+
+	if (ConfigureParams.Log.sTraceBinFileName[0] &&
+	    !TraceBuf_Init(ConfigureParams.Log.sTraceBinFileName))
+		return 0;
+
 	return (hLogFile && TraceFile);
 }
 
@@ -227,6 +233,7 @@ int Log_SetAlertLevel(int level)
  */
 void Log_UnInit(void)
 {
+	TraceBuf_UnInit();
 	hLogFile = File_Close(hLogFile);
 	TraceFile = File_Close(TraceFile);
 }
@@ -504,6 +511,206 @@ char *Log_MatchTrace(const char *text, int state)
 	return NULL;
 }
 
+
+/* registered trace points in registration order */
+static trace_point_t *TracePoints, *LastTracePoint;
+static int nTracePoints;
+/* enable/disable specs to apply on points registered later */
+static struct {
+	char *spec;
+	bool enable;
+} *PendingSpecs;
+static int nPendingSpecs;
+/* trace points may be registered from other threads too */
+static SDL_SpinLock TracePointLock;
+
+/**
+ * Return true if trace point matches given spec: "all", trace point
+ * number, or source file name with optional ":<line>" suffix.
+ * File name matches if it's given point file path or tail of it.
+ */
+static bool Log_TracePointMatch(const trace_point_t *point, const char *spec)
+{
+	const char *colon, *tail;
+	size_t len, flen;
+	char *end;
+	long val;
+
+	if (strcmp(spec, "all") == 0)
+		return true;
+	val = strtol(spec, &end, 10);
+	if (!*end)
+		return point->id == val;
+
+	colon = strrchr(spec, ':');
+	if (colon)
+	{
+		len = colon - spec;
+		if (atoi(colon + 1) != point->line)
+			return false;
+	}
+	else
+		len = strlen(spec);
+
+	flen = strlen(point->file);
+	if (len > flen)
+		return false;
+	tail = point->file + flen - len;
+	if (strncmp(tail, spec, len) != 0)
+		return false;
+	return tail == point->file || tail[-1] == '/' || tail[-1] == '\\';
+}
+
+/**
+ * Register given trace point on its first execution, enable it if
+ * earlier given specs match it.  Return true if point is enabled.
+ * Lock is needed only for registration, enabled points just
+ * check their (byte) state.
+ */
+bool Log_TracePointCheck(trace_point_t *point, Uint64 level)
+{
+	Uint8 state;
+	int i;
+
+	if (point->state != TRACEPOINT_NEW)
+		return point->state == TRACEPOINT_ON;
+
+	SDL_AtomicLock(&TracePointLock);
+	if (point->state == TRACEPOINT_NEW)
+	{
+		state = TRACEPOINT_OFF;
+		point->level = level;
+		point->id = ++nTracePoints;
+		point->next = NULL;
+		if (LastTracePoint)
+			LastTracePoint->next = point;
+		else
+			TracePoints = point;
+		LastTracePoint = point;
+
+		for (i = 0; i < nPendingSpecs; i++)
+		{
+			if (Log_TracePointMatch(point, PendingSpecs[i].spec))
+				state = PendingSpecs[i].enable;
+		}
+		/* set state last, so that point is complete when
+		 * other threads skip the lock for it */
+		SDL_MemoryBarrierRelease();
+		point->state = state;
+	}
+	SDL_AtomicUnlock(&TracePointLock);
+	return point->state == TRACEPOINT_ON;
+}
+
+/**
+ * Enable or disable trace points matching given spec, both the already
+ * registered ones and ones registered later (see Log_TracePointMatch()).
+ * Return error string or NULL for success.
+ */
+const char* Log_SetTracePoints(const char *spec, bool enable)
+{
+	trace_point_t *point;
+	char *end;
+	void *specs;
+	int count = 0;
+
+	if (!*spec)
+		return "empty trace point spec";
+
+	SDL_AtomicLock(&TracePointLock);
+	for (point = TracePoints; point; point = point->next)
+	{
+		if (Log_TracePointMatch(point, spec))
+		{
+			point->state = enable ? TRACEPOINT_ON : TRACEPOINT_OFF;
+			count++;
+		}
+	}
+	/* point numbers are known only for registered points */
+	strtol(spec, &end, 10);
+	if (*end)
+	{
+		specs = realloc(PendingSpecs, (nPendingSpecs + 1) * sizeof(*PendingSpecs));
+		if (specs)
+		{
+			PendingSpecs = specs;
+			PendingSpecs[nPendingSpecs].spec = strdup(spec);
+			PendingSpecs[nPendingSpecs].enable = enable;
+			if (PendingSpecs[nPendingSpecs].spec)
+				nPendingSpecs++;
+		}
+		count = 1;
+	}
+	SDL_AtomicUnlock(&TracePointLock);
+
+	if (!count)
+		return "no such trace point";
+	return NULL;
+}
+
+/**
+ * List registered trace points with their hit counts and trace flags.
+ */
+void Log_ListTracePoints(FILE *fp)
+{
+	trace_point_t *point;
+	const char *file, *sep;
+	int i, enabled = 0;
+
+	SDL_AtomicLock(&TracePointLock);
+	fprintf(fp, "Trace points registered: %d (executed at least once)\n", nTracePoints);
+	for (point = TracePoints; point; point = point->next)
+	{
+		file = strrchr(point->file, '/');
+		file = file ? file + 1 : point->file;
+		fprintf(fp, "%4d %s %10u  %s:%d (", point->id,
+			point->state == TRACEPOINT_ON ? "ON " : "off",
+			(unsigned)SDL_AtomicGet(&point->hits), file, point->line);
+		sep = "";
+		for (i = 0; i < ARRAY_SIZE(TraceFlags); i++)
+		{
+			Uint64 flag = TraceFlags[i].flag;
+			/* single flags only, not "all" or combinations */
+			if (flag && !(flag & (flag - 1)) && (point->level & flag))
+			{
+				fprintf(fp, "%s%s", sep, TraceFlags[i].name);
+				sep = ",";
+			}
+		}
+		fprintf(fp, ")\n");
+		if (point->state == TRACEPOINT_ON)
+			enabled++;
+	}
+	fprintf(fp, "%d trace point(s) enabled.\n", enabled);
+	for (i = 0; i < nPendingSpecs; i++)
+		fprintf(fp, "- %s '%s'\n", PendingSpecs[i].enable ? "on" : "off",
+			PendingSpecs[i].spec);
+	SDL_AtomicUnlock(&TracePointLock);
+}
+
+/**
+ * Disable all trace points, zero their hit counts and forget
+ * the specs given for the points registered later.
+ */
+void Log_ResetTracePoints(void)
+{
+	trace_point_t *point;
+	int i;
+
+	SDL_AtomicLock(&TracePointLock);
+	for (point = TracePoints; point; point = point->next)
+	{
+		point->state = TRACEPOINT_OFF;
+		SDL_AtomicSet(&point->hits, 0);
+	}
+	for (i = 0; i < nPendingSpecs; i++)
+		free(PendingSpecs[i].spec);
+	free(PendingSpecs);
+	PendingSpecs = NULL;
+	nPendingSpecs = 0;
+	SDL_AtomicUnlock(&TracePointLock);
+}
+
 #else	/* !ENABLE_TRACING */
 
 /** dummy */
@@ -518,4 +725,26 @@ char *Log_MatchTrace(const char *text, int state)
 	return NULL;
 }
 
+/** dummy */
+bool Log_TracePointCheck(trace_point_t *point, Uint64 level)
+{
+	return false;
+}
+
+/** dummy */
+const char* Log_SetTracePoints(const char *spec, bool enable)
+{
+	return "Hatari has been compiled without ENABLE_TRACING!";
+}
+
+/** dummy */
+void Log_ListTracePoints(FILE *fp)
+{
+}
+
+/** dummy */
+void Log_ResetTracePoints(void)
+{
+}
+
 #endif	/* !ENABLE_TRACING */
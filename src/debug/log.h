@@ -9,6 +9,7 @@
 
 #include <stdbool.h>
 #include <SDL_types.h>
+#include <SDL_atomic.h>
 
 
 /* Exception debugging
@@ -83,6 +84,8 @@ extern void Log_AlertDlg(LOGTYPE nType, const char *psFormat, ...)
 extern LOGTYPE Log_ParseOptions(const char *OptionStr);
 extern const char* Log_SetTraceOptions(const char *OptionsStr);
 extern char *Log_MatchTrace(const char *text, int state);
+extern int TraceBuf_Printf(const char *format, ...)
+	__attribute__ ((format (printf, 1, 2)));
 
 #ifndef __GNUC__
 #undef __attribute__
@@ -296,13 +299,65 @@ enum {
 
 extern FILE *TraceFile;
 extern Uint64 LogTraceFlags;
+extern bool LogTraceBinary;
 
-#if ENABLE_TRACING
+/* Trace point states */
+enum {
+	TRACEPOINT_OFF,
+	TRACEPOINT_ON,
+	TRACEPOINT_NEW		/* not yet registered */
+};
 
-#define	LOG_TRACE(level, ...) \
-	if (unlikely(LogTraceFlags & (level))) { fprintf(TraceFile, __VA_ARGS__); fflush(TraceFile); }
+/* Every LOG_TRACE and LOG_TRACE_LEVEL call site has its own trace
+ * point, which gets registered (numbered) when the site is executed
+ * first time, and can then be enabled individually with the
+ * "tracepoint" debugger command, regardless of the trace flags.
+ */
+typedef struct trace_point_s {
+	Uint8 state;
+	const char *file;
+	int line;
+	Uint64 level;		/* set on registration */
+	SDL_atomic_t hits;	/* LOG_TRACE is called from other threads too */
+	int id;
+	struct trace_point_s *next;
+} trace_point_t;
+
+extern bool Log_TracePointCheck(trace_point_t *point, Uint64 level);
+extern const char* Log_SetTracePoints(const char *spec, bool enable);
+extern void Log_ListTracePoints(FILE *fp);
+extern void Log_ResetTracePoints(void);
 
-#define LOG_TRACE_LEVEL( level )	(unlikely(LogTraceFlags & (level)))
+#if ENABLE_TRACING
+
+/* With binary tracing (--trace-bin), events are stored to a ring buffer
+ * instead, the trace file is then used only for the other trace output
+ * (disassembly, register dumps) written directly to it.
+ *
+ * Once a trace point is registered and not enabled, its state is
+ * zero, so the additional check is just a (predicted) byte test.
+ * Level isn't necessarily a constant, so it's stored to the point
+ * only when the point gets registered.
+ *
+ * LOG_TRACE_LEVEL() guards trace output done with several statements
+ * (e.g. LOG_TRACE_PRINT() calls).  Code deciding whether tracing needs
+ * to be set up should check LogTraceFlags directly instead.
+ */
+#define LOG_TRACE_LEVEL( level )	__extension__ ({ \
+	static trace_point_t trace_point_ = { TRACEPOINT_NEW, __FILE__, __LINE__ }; \
+	bool trace_on_ = (unlikely(trace_point_.state) && Log_TracePointCheck(&trace_point_, (level))) || \
+	    unlikely(LogTraceFlags & (level)); \
+	if (trace_on_) \
+		SDL_AtomicAdd(&trace_point_.hits, 1); \
+	trace_on_; \
+})
+
+#define	LOG_TRACE(level, ...) { \
+	if (LOG_TRACE_LEVEL(level)) { \
+		if (LogTraceBinary) TraceBuf_Printf(__VA_ARGS__); \
+		else { fprintf(TraceFile, __VA_ARGS__); fflush(TraceFile); } \
+	} \
+}
 
 #else		/* ENABLE_TRACING */
 
@@ -316,7 +371,8 @@ extern Uint64 LogTraceFlags;
  * In code it's used in such a way that it will be optimized away when tracing
  * is disabled.
  */
-#define LOG_TRACE_PRINT(...)	fprintf(TraceFile , __VA_ARGS__)
+#define LOG_TRACE_PRINT(...) \
+	(LogTraceBinary ? TraceBuf_Printf(__VA_ARGS__) : fprintf(TraceFile , __VA_ARGS__))
 
 
 #endif		/* HATARI_LOG_H */
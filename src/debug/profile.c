@@ -235,9 +235,10 @@ static void add_callee_cost(callee_t *callsite, callstack_t *stack)
 }
 
 /**
- * Add new caller or updated earlier caller stats for call site
+ * Add new caller or updated earlier caller stats for call site.
+ * Return caller info, or NULL on alloc failure.
  */
-static void add_caller(callee_t *callsite, Uint32 pc, Uint32 prev_pc, calltype_t flag)
+static caller_t *add_caller(callee_t *callsite, Uint32 pc, Uint32 prev_pc, calltype_t flag)
 {
 	int i, count, oldcount;
 	caller_t *info;
@@ -250,7 +251,7 @@ static void add_caller(callee_t *callsite, Uint32 pc, Uint32 prev_pc, calltype_t
 		info = calloc(1, sizeof(*info));
 		if (!info) {
 			fprintf(stderr, "ERROR: caller info alloc failed!\n");
-			return;
+			return NULL;
 		}
 		/* first call to this address, save address */
 		callsite->addr = pc;
@@ -266,14 +267,14 @@ static void add_caller(callee_t *callsite, Uint32 pc, Uint32 prev_pc, calltype_t
 				/* increment caller */
 				info->flags |= flag;
 				info->calls++;
-				return;
+				return info;
 			}
 			if (!info->addr) {
 				/* add caller to empty slot */
 				info->addr = prev_pc;
 				info->flags |= flag;
 				info->calls = 1;
-				return;
+				return info;
 			}
 		}
 		oldcount = count;
@@ -282,7 +283,7 @@ static void add_caller(callee_t *callsite, Uint32 pc, Uint32 prev_pc, calltype_t
 		info = realloc(callsite->callers, count * sizeof(*info));
 		if (!info) {
 			fprintf(stderr, "ERROR: caller info alloc failed!\n");
-			return;
+			return NULL;
 		}
 		callsite->callers = info;
 		callsite->count = count;
@@ -291,6 +292,62 @@ static void add_caller(callee_t *callsite, Uint32 pc, Uint32 prev_pc, calltype_t
 	}
 }
 
+/**
+ * Return call path node index for given callee called from given
+ * parent node, add new node if there's not yet one.  Return -1 on
+ * alloc failure.
+ */
+static int get_callnode(callinfo_t *callinfo, int parent, int idx)
+{
+	int i, *hash, size, node;
+	Uint32 key;
+
+	/* keep hash table at most half full */
+	if (unlikely(2 * callinfo->nodecount >= callinfo->hashmask)) {
+		size = callinfo->hashmask ? 2 * (callinfo->hashmask + 1) : 1024;
+		hash = calloc(size, sizeof(*hash));
+		if (!hash) {
+			fputs("ERROR: call path hash alloc failed!\n", stderr);
+			return -1;
+		}
+		free(callinfo->nodehash);
+		callinfo->nodehash = hash;
+		callinfo->hashmask = size - 1;
+		/* re-hash existing nodes */
+		for (node = 0; node < callinfo->nodecount; node++) {
+			key = (Uint32)callinfo->nodes[node].parent * 0x9E3779B1u + callinfo->nodes[node].callee_idx;
+			for (i = key & callinfo->hashmask; hash[i]; i = (i + 1) & callinfo->hashmask)
+				;
+			hash[i] = node + 1;
+		}
+	}
+	key = (Uint32)parent * 0x9E3779B1u + idx;
+	hash = callinfo->nodehash;
+	for (i = key & callinfo->hashmask; hash[i]; i = (i + 1) & callinfo->hashmask) {
+		node = hash[i] - 1;
+		if (callinfo->nodes[node].parent == parent && callinfo->nodes[node].callee_idx == idx) {
+			return node;
+		}
+	}
+	/* new node */
+	if (callinfo->nodecount >= callinfo->nodealloc) {
+		int count = callinfo->nodealloc ? 2 * callinfo->nodealloc : 256;
+		callnode_t *nodes = realloc(callinfo->nodes, count * sizeof(*nodes));
+		if (!nodes) {
+			fputs("ERROR: call path node alloc failed!\n", stderr);
+			return -1;
+		}
+		callinfo->nodes = nodes;
+		callinfo->nodealloc = count;
+	}
+	node = callinfo->nodecount++;
+	memset(&(callinfo->nodes[node]), 0, sizeof(callinfo->nodes[node]));
+	callinfo->nodes[node].parent = parent;
+	callinfo->nodes[node].callee_idx = idx;
+	hash[i] = node + 1;
+	return node;
+}
+
 /**
  * Add information about the called symbol, and if it was a subroutine
  * call, add it to stack of functions which total costs are tracked.
@@ -353,6 +410,7 @@ void Profile_CallStart(int idx, callinfo_t *callinfo, Uint32 prev_pc, calltype_t
 	/* set subroutine call information */
 	stack->ret_addr = callinfo->return_pc;
 	stack->callee_idx = idx;
+	stack->node = get_callnode(callinfo, callinfo->depth > 1 ? stack[-1].node : -1, idx);
 	stack->caller_addr = prev_pc;
 	stack->callee_addr = pc;
 
@@ -389,6 +447,11 @@ Uint32 Profile_CallEnd(callinfo_t *callinfo, counters_t *totalcost)
 		 */
 		set_counter_diff(&(stack->all), totalcost);
 		add_callee_cost(callinfo->site + stack->callee_idx, stack);
+		if (stack->node >= 0) {
+			counters_t owncost = stack->out;
+			set_counter_diff(&owncost, &(stack->all));
+			add_counter_costs(&(callinfo->nodes[stack->node].own), &owncost);
+		}
 	}
 
 	/* if current function had a parent:
@@ -408,6 +471,56 @@ Uint32 Profile_CallEnd(callinfo_t *callinfo, counters_t *totalcost)
 }
 
 
+/**
+ * Add caller information for a call found when sampling the call
+ * stack, and sample cost to it.  Exclusive (own) cost is added
+ * only for the function where sampled PC was.
+ */
+void Profile_CallSample(callinfo_t *callinfo, int idx, Uint32 pc, Uint32 prev_pc, counters_t *cost, bool own)
+{
+	caller_t *info;
+
+	if (unlikely(idx >= callinfo->sites)) {
+		fprintf(stderr, "ERROR: number of symbols increased during profiling (%d > %d)!\n", idx, callinfo->sites);
+		return;
+	}
+	info = add_caller(callinfo->site + idx, pc, prev_pc, CALL_SUBROUTINE);
+	if (!info) {
+		return;
+	}
+	/* own call count needs to match caller call count */
+	add_counter_costs(&(info->all), cost);
+	info->own.calls += cost->calls;
+	if (own) {
+		info->own.count += cost->count;
+		info->own.cycles += cost->cycles;
+	}
+}
+
+
+/**
+ * Add sample cost to the call path given as callee indexes,
+ * starting from the outermost function.  Without any (known)
+ * functions in the path, cost is added to the path-less costs.
+ */
+void Profile_CallPathSample(callinfo_t *callinfo, const int *idx, int depth, counters_t *cost)
+{
+	int i, node = -1;
+
+	if (!depth) {
+		add_counter_costs(&(callinfo->nopath), cost);
+		return;
+	}
+	for (i = 0; i < depth; i++) {
+		node = get_callnode(callinfo, node, idx[i]);
+		if (node < 0) {
+			return;
+		}
+	}
+	add_counter_costs(&(callinfo->nodes[node].own), cost);
+}
+
+
 /**
  * Add costs to all functions still in call stack and print their names
  *
@@ -583,11 +696,157 @@ void Profile_FreeCallinfo(callinfo_t *callinfo)
 		if (callinfo->stack) {
 			free(callinfo->stack);
 		}
+		free(callinfo->nodes);
+		free(callinfo->nodehash);
 		memset(callinfo, 0, sizeof(*callinfo));
 	}
 }
 
 
+/* ------------------- profile data export ---------------------- */
+
+/**
+ * Output name for function with given callsite index
+ */
+static void output_function_name(FILE *fp, callinfo_t *callinfo, int idx,
+				 const char* (*get_symbol)(Uint32, symtype_t))
+{
+	Uint32 addr = callinfo->site[idx].addr;
+	const char *name = get_symbol(addr, SYMTYPE_TEXT);
+
+	if (name) {
+		fputs(name, fp);
+	} else {
+		fprintf(fp, "0x%x", addr);
+	}
+}
+
+/**
+ * Save call paths and their exclusive cycles in "folded stacks"
+ * format used by flame graph tools:
+ *	outer_function;called_function;...;innermost_function <cycles>
+ * Cycles sampled outside of known functions are given as "[unknown]".
+ */
+static void Profile_SaveFolded(FILE *fp, callinfo_t *callinfo,
+			       const char* (*get_symbol)(Uint32, symtype_t))
+{
+	int i, node, depth, *path;
+
+	path = malloc(callinfo->nodecount * sizeof(*path));
+	if (!path) {
+		fputs("ERROR: call path alloc failed!\n", stderr);
+		return;
+	}
+	for (i = 0; i < callinfo->nodecount; i++) {
+		if (!callinfo->nodes[i].own.cycles) {
+			continue;
+		}
+		depth = 0;
+		for (node = i; node >= 0; node = callinfo->nodes[node].parent) {
+			path[depth++] = callinfo->nodes[node].callee_idx;
+		}
+		while (depth-- > 0) {
+			output_function_name(fp, callinfo, path[depth], get_symbol);
+			fputc(depth ? ';' : ' ', fp);
+		}
+		fprintf(fp, "%"PRIu64"\n", callinfo->nodes[i].own.cycles);
+	}
+	if (callinfo->nopath.cycles) {
+		fprintf(fp, "[unknown] %"PRIu64"\n", callinfo->nopath.cycles);
+	}
+	free(path);
+}
+
+/**
+ * Save caller information in Valgrind Callgrind format, for
+ * viewing it in Kcachegrind.  Exclusive costs are assigned to
+ * the function start address.  There's no source file information,
+ * so all functions are given the "???" file, like Valgrind does
+ * for unknown files.
+ */
+static void Profile_SaveCallgrind(FILE *fp, callinfo_t *callinfo,
+				  const char* (*get_symbol)(Uint32, symtype_t),
+				  const char* (*get_caller)(Uint32*))
+{
+	const char *name;
+	counters_t own;
+	callee_t *site;
+	caller_t *info;
+	Uint32 addr;
+	int i, j;
+
+	fputs("# callgrind format\nversion: 1\n", fp);
+	fprintf(fp, "creator: %s\n", PROG_NAME);
+	fputs("positions: instr\nevents: Instructions Cycles\n", fp);
+
+	for (i = 0, site = callinfo->site; i < callinfo->sites; i++, site++) {
+		if (!site->callers) {
+			continue;
+		}
+		/* own costs of the function */
+		memset(&own, 0, sizeof(own));
+		for (j = 0, info = site->callers; j < site->count; j++, info++) {
+			add_counter_costs(&own, &(info->own));
+		}
+		fputs("\nfl=???\nfn=", fp);
+		output_function_name(fp, callinfo, i, get_symbol);
+		fprintf(fp, "\n0x%x %"PRIu64" %"PRIu64"\n", site->addr, own.count, own.cycles);
+
+		/* and inclusive costs of its calls, in callers */
+		for (j = 0, info = site->callers; j < site->count; j++, info++) {
+			if (!(info->addr && info->all.count)) {
+				continue;
+			}
+			addr = info->addr;
+			name = get_caller(&addr);
+			if (name) {
+				fprintf(fp, "\nfl=???\nfn=%s\n", name);
+			} else {
+				fprintf(fp, "\nfl=???\nfn=0x%x\n", info->addr);
+			}
+			fputs("cfl=???\ncfn=", fp);
+			output_function_name(fp, callinfo, i, get_symbol);
+			fprintf(fp, "\ncalls=%d 0x%x\n", info->calls, site->addr);
+			fprintf(fp, "0x%x %"PRIu64" %"PRIu64"\n",
+				info->addr, info->all.count, info->all.cycles);
+		}
+	}
+}
+
+/**
+ * Export CPU or DSP caller information to given file in given format.
+ */
+static bool Profile_Export(const char *fname, bool bForDsp, bool callgrind)
+{
+	const char *(*get_caller)(Uint32*);
+	const char *(*get_symbol)(Uint32, symtype_t);
+	callinfo_t *callinfo;
+	FILE *out;
+
+	if (bForDsp) {
+		Profile_DspGetCallinfo(&callinfo, &get_caller, &get_symbol);
+	} else {
+		Profile_CpuGetCallinfo(&callinfo, &get_caller, &get_symbol);
+	}
+	if (!callinfo->sites) {
+		fprintf(stderr, "ERROR: no caller information, were symbols loaded before profiling?\n");
+		return false;
+	}
+	if (!(out = fopen(fname, "w"))) {
+		fprintf(stderr, "ERROR: opening '%s' for writing failed!\n", fname);
+		perror(NULL);
+		return false;
+	}
+	if (callgrind) {
+		Profile_SaveCallgrind(out, callinfo, get_symbol, get_caller);
+	} else {
+		Profile_SaveFolded(out, callinfo, get_symbol);
+	}
+	fclose(out);
+	return true;
+}
+
+
 /* ------------------- command parsing ---------------------- */
 
 /**
@@ -598,8 +857,9 @@ void Profile_FreeCallinfo(callinfo_t *callinfo)
 char *Profile_Match(const char *text, int state)
 {
 	static const char *names[] = {
-		"addresses", "callers", "caches", "counts", "cycles", "d-hits", "i-misses",
-		"loops", "off", "on", "save", "stack", "stats", "symbols"
+		"addresses", "callers", "caches", "callgrind", "counts", "cycles", "d-hits",
+		"folded", "i-misses", "loops", "off", "on", "sample", "save", "stack", "stats",
+		"symbols"
 	};
 	return DebugUI_MatchHelper(names, ARRAY_SIZE(names), text, state);
 }
@@ -610,6 +870,7 @@ const char Profile_Description[] =
 	"\tSubcommands:\n"
 	"\t- on\n"
 	"\t- off\n"
+	"\t- sample <cycles>\n"
 	"\t- counts [count]\n"
 	"\t- cycles [count]\n"
 	"\t- i-misses [count]\n"
@@ -621,12 +882,20 @@ const char Profile_Description[] =
 	"\t- stack\n"
 	"\t- stats\n"
 	"\t- save <file>\n"
+	"\t- callgrind <file>\n"
+	"\t- folded <file>\n"
 	"\t- loops <file> [CPU limit] [DSP limit]\n"
 	"\n"
 	"\t'on' & 'off' enable and disable profiling.  Data is collected\n"
 	"\tuntil debugger is entered again at which point you get profiling\n"
 	"\tstatistics ('stats') summary.\n"
 	"\n"
+	"\t'sample' enables statistical CPU profiling instead, where PC\n"
+	"\tand call stack are sampled only every given number of cycles.\n"
+	"\tIt has negligible overhead, but instead of instruction counts\n"
+	"\tyou get sample counts, no cache information, and callers are\n"
+	"\tfound by (heuristically) scanning stack for return addresses.\n"
+	"\n"
 	"\tThen you can ask for list of the PC addresses, sorted either by\n"
 	"\texecution 'counts', used 'cycles', i-cache misses or d-cache hits.\n"
 	"\tFirst can be limited just to named addresses with 'symbols'.\n"
@@ -644,7 +913,9 @@ const char Profile_Description[] =
 	"\tprofile stack (this is useful only with :noinit breakpoints).\n"
 	"\n"
 	"\tProfile address and callers information can be saved with\n"
-	"\t'save' command.\n"
+	"\t'save' command.  Callers information can also be exported\n"
+	"\tdirectly in Valgrind 'callgrind' format (for Kcachegrind), and\n"
+	"\tas 'folded' call stacks (for flame graph tools).\n"
 	"\n"
 	"\tDetailed (spin) looping information can be collected by\n"
 	"\tspecifying to which file it should be saved, with optional\n"
@@ -756,7 +1027,7 @@ int Profile_Command(int nArgc, char *psArgs[], bool bForDsp)
 	Uint32 *disasm_addr;
 	bool *enabled;
 
-	if (nArgc > 2) {
+	if (nArgc > 2 && strcmp(psArgs[1], "sample") != 0) {
 		show = atoi(psArgs[2]);
 	}
 	if (bForDsp) {
@@ -783,9 +1054,24 @@ int Profile_Command(int nArgc, char *psArgs[], bool bForDsp)
 		return DEBUGGER_CMDCONT;
 
 	} else if (strcmp(psArgs[1], "on") == 0) {
+		if (!bForDsp) {
+			Profile_CpuSetSampling(0);
+		}
 		*enabled = true;
 		fprintf(stderr, "Profiling enabled.\n");
 
+	} else if (strcmp(psArgs[1], "sample") == 0) {
+		int cycles = nArgc > 2 ? atoi(psArgs[2]) : 0;
+		if (bForDsp) {
+			fprintf(stderr, "Sampling is supported only for CPU, not DSP.\n");
+		} else if (cycles <= 0) {
+			DebugUI_PrintCmdHelp(psArgs[0]);
+		} else {
+			Profile_CpuSetSampling(cycles);
+			*enabled = true;
+			fprintf(stderr, "Sampling profiling enabled (every %d cycles).\n", cycles);
+		}
+
 	} else if (strcmp(psArgs[1], "off") == 0) {
 		*enabled = false;
 		fprintf(stderr, "Profiling disabled.\n");
@@ -844,6 +1130,12 @@ int Profile_Command(int nArgc, char *psArgs[], bool bForDsp)
 	} else if (strcmp(psArgs[1], "save") == 0) {
 		Profile_Save(psArgs[2], bForDsp);
 
+	} else if (nArgc == 3 && strcmp(psArgs[1], "callgrind") == 0) {
+		Profile_Export(psArgs[2], bForDsp, true);
+
+	} else if (nArgc == 3 && strcmp(psArgs[1], "folded") == 0) {
+		Profile_Export(psArgs[2], bForDsp, false);
+
 	} else if (strcmp(psArgs[1], "loops") == 0) {
 		Profile_Loops(nArgc, psArgs);
 
@@ -31,6 +31,7 @@ extern void Profile_CpuFree(void);
 extern bool Profile_CpuStart(void);
 extern void Profile_CpuUpdate(void);
 extern void Profile_CpuStop(void);
+extern void Profile_CpuSample(void);
 
 /* CPU profile results */
 extern bool Profile_CpuAddr_HasData(Uint32 addr);
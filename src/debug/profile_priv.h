@@ -25,6 +25,7 @@ typedef struct {
 
 typedef struct {
 	int callee_idx;		/* index of called function */
+	int node;		/* call path node of called function */
 	Uint32 ret_addr;	/* address after returning from call */
 	Uint32 caller_addr;	/* caller address for callstack printing */
 	Uint32 callee_addr;	/* callee address for callstack printing */
@@ -47,6 +48,13 @@ typedef struct {
 	caller_t *callers;	/* who called this address */
 } callee_t;
 
+/* call path (calling context tree) node, for folded stacks */
+typedef struct {
+	int parent;		/* parent node index, -1 for top level */
+	int callee_idx;		/* index of called function */
+	counters_t own;		/* costs excluding called code */
+} callnode_t;
+
 /* impossible PC value, for uninitialized PC values */
 #define PC_UNDEFINED 0xFFFFFFFF
 
@@ -58,6 +66,12 @@ typedef struct {
 	Uint32 return_pc;	/* address for last call return address (speedup) */
 	callee_t *site;		/* symbol specific caller information */
 	callstack_t *stack;	/* calls that will return */
+	callnode_t *nodes;	/* call paths seen */
+	int nodecount;		/* number of used nodes */
+	int nodealloc;		/* number of allocated nodes */
+	int *nodehash;		/* (parent, callee) -> node index + 1 */
+	int hashmask;		/* hash table size - 1 */
+	counters_t nopath;	/* sampled costs outside known functions */
 } callinfo_t;
 
 
@@ -76,12 +90,15 @@ extern void Profile_CallStart(int idx, callinfo_t *callinfo, Uint32 prev_pc, cal
 extern void Profile_FinalizeCalls(Uint32 pc, callinfo_t *callinfo, counters_t *totalcost,
 				  const char* (get_symbol)(Uint32, symtype_t), const char* (get_caller)(Uint32*));
 extern Uint32 Profile_CallEnd(callinfo_t *callinfo, counters_t *totalcost);
+extern void Profile_CallSample(callinfo_t *callinfo, int idx, Uint32 pc, Uint32 prev_pc, counters_t *cost, bool own);
+extern void Profile_CallPathSample(callinfo_t *callinfo, const int *idx, int depth, counters_t *cost);
 extern int  Profile_AllocCallinfo(callinfo_t *callinfo, int count, const char *info);
 extern void Profile_FreeCallinfo(callinfo_t *callinfo);
 extern bool Profile_LoopReset(void);
 
 /* parser helpers */
 extern void Profile_CpuGetPointers(bool **enabled, Uint32 **disasm_addr);
+extern void Profile_CpuSetSampling(Uint32 cycles);
 extern void Profile_DspGetPointers(bool **enabled, Uint32 **disasm_addr);
 extern void Profile_CpuGetCallinfo(callinfo_t **callinfo, const char* (**get_caller)(Uint32*), const char* (**get_symbol)(Uint32, symtype_t));
 extern void Profile_DspGetCallinfo(callinfo_t **callinfo, const char* (**get_caller)(Uint32*), const char* (**get_symbol)(Uint32, symtype_t));
@@ -25,6 +25,7 @@ const char Profilecpu_fileid[] = "Hatari profilecpu.c";
 #include "profile_priv.h"
 #include "debug_priv.h"
 #include "stMemory.h"
+#include "cycInt.h"
 #include "tos.h"
 #include "screen.h"
 #include "video.h"
@@ -73,6 +74,13 @@ typedef struct {
 } cpu_profile_item_t;
 
 
+/* profile data is allocated in pages, only for executed code,
+ * so that large TT-RAM sizes don't need huge allocations
+ */
+#define PROFILE_PAGE_SHIFT 11
+#define PROFILE_PAGE_ITEMS (1 << PROFILE_PAGE_SHIFT)
+#define PROFILE_PAGE_MASK  (PROFILE_PAGE_ITEMS - 1)
+
 /* max count of hits/misses single instruction can trigger at once */
 #define MAX_I_HITS   8
 #define MAX_I_MISSES 8
@@ -81,8 +89,10 @@ typedef struct {
 
 static struct {
 	counters_t all;       /* total counts for all areas */
-	cpu_profile_item_t *data; /* profile data items */
-	Uint32 size;          /* number of allocated profile data items */
+	cpu_profile_item_t **pages; /* profile data item pages */
+	Uint32 pagecount;     /* number of page pointers */
+	Uint32 pagesused;     /* number of allocated pages */
+	Uint32 size;          /* number of profile data items */
 	profile_area_t ttram; /* TT-RAM stats */
 	profile_area_t ram;   /* normal RAM stats */
 	profile_area_t rom;   /* cartridge ROM stats */
@@ -101,6 +111,7 @@ static struct {
 	Uint32 d_hit_counts[MAX_D_HITS];    /* D-cache hit counts */
 	Uint32 i_miss_counts[MAX_I_MISSES]; /* I-cache miss counts */
 	Uint32 d_miss_counts[MAX_D_MISSES]; /* D-cache miss counts */
+	Uint32 sample_cycles; /* sampling period, zero when every instruction is profiled */
 	bool processed;	      /* true when data is already processed */
 	bool enabled;         /* true when profiling enabled */
 } cpu_profile;
@@ -121,6 +132,11 @@ static cpu_warnings_t cpu_warnings;
 #define MAX_SHOW_COUNT	8
 #define MAX_MULTI_RETURN 1
 
+/* how many stack words are scanned for return addresses when sampling */
+#define MAX_SAMPLE_STACK 128
+/* max. number of sampled call stack frames */
+#define MAX_SAMPLE_DEPTH 16
+
 
 /* ------------------ CPU profile address mapping ----------------- */
 
@@ -178,6 +194,62 @@ static inline Uint32 address2index(Uint32 pc)
 	return (pc >> 1);
 }
 
+/**
+ * Return profile data item for given index, allocate its page if needed.
+ */
+static inline cpu_profile_item_t *index2item(Uint32 idx)
+{
+	static cpu_profile_item_t lost;
+	cpu_profile_item_t **page = cpu_profile.pages + (idx >> PROFILE_PAGE_SHIFT);
+
+	if (unlikely(!*page)) {
+		*page = calloc(PROFILE_PAGE_ITEMS, sizeof(**page));
+		if (!*page) {
+			perror("ERROR: CPU profile page alloc failed");
+			return &lost;
+		}
+		cpu_profile.pagesused++;
+	}
+	return *page + (idx & PROFILE_PAGE_MASK);
+}
+
+/**
+ * Return profile data item for given index, or empty item if
+ * there's no data for it.
+ */
+static inline const cpu_profile_item_t *index2data(Uint32 idx)
+{
+	static const cpu_profile_item_t empty;
+	const cpu_profile_item_t *page = cpu_profile.pages[idx >> PROFILE_PAGE_SHIFT];
+
+	if (!page) {
+		return &empty;
+	}
+	return page + (idx & PROFILE_PAGE_MASK);
+}
+
+/**
+ * Return first index from given one onwards that has been executed,
+ * or 'end' if there are none before it.  Skips unallocated pages.
+ */
+static Uint32 next_active_index(Uint32 idx, Uint32 end)
+{
+	const cpu_profile_item_t *page;
+
+	while (idx < end) {
+		page = cpu_profile.pages[idx >> PROFILE_PAGE_SHIFT];
+		if (!page) {
+			idx = (idx | PROFILE_PAGE_MASK) + 1;
+			continue;
+		}
+		if (page[idx & PROFILE_PAGE_MASK].count) {
+			return idx;
+		}
+		idx++;
+	}
+	return end;
+}
+
 /**
  * convert sorting array profile data index to Atari memory address.
  */
@@ -223,14 +295,14 @@ static Uint32 index2address(Uint32 idx)
  */
 bool Profile_CpuAddr_HasData(Uint32 addr)
 {
-	cpu_profile_item_t *item;
+	const cpu_profile_item_t *item;
 	Uint32 idx;
 
-	if (!cpu_profile.data) {
+	if (!cpu_profile.pages) {
 		return false;
 	}
 	idx = address2index(addr);
-	item = &(cpu_profile.data[idx]);
+	item = index2data(idx);
 	if (!item->count) {
 		return false;
 	}
@@ -246,17 +318,17 @@ bool Profile_CpuAddr_HasData(Uint32 addr)
  */
 int Profile_CpuAddr_DataStr(char *buffer, int maxlen, Uint32 addr)
 {
-	cpu_profile_item_t *item;
+	const cpu_profile_item_t *item;
 	float percentage;
 	Uint32 idx;
 	int count;
 
 	assert(buffer && maxlen > 0);
-	if (!cpu_profile.data) {
+	if (!cpu_profile.pages) {
 		return 0;
 	}
 	idx = address2index(addr);
-	item = &(cpu_profile.data[idx]);
+	item = index2data(idx);
 	if (!item->count) {
 		return 0;
 	}
@@ -335,7 +407,8 @@ static void show_cpu_area_stats(profile_area_t *area)
 	fprintf(stderr, "- active instruction addresses:\n  %d (%.2f%% of all areas)\n",
 		area->active,
 		100.0 * area->active / cpu_profile.active);
-	fprintf(stderr, "- executed instructions:\n  %"PRIu64" (%.2f%% of all areas)\n",
+	fprintf(stderr, "- %s:\n  %"PRIu64" (%.2f%% of all areas)\n",
+		cpu_profile.sample_cycles ? "PC samples" : "executed instructions",
 		area->counters.count,
 		100.0 * area->counters.count / cpu_profile.all.count);
 	/* CPU cache in use? */
@@ -442,12 +515,10 @@ Uint32 Profile_CpuShowAddresses(Uint32 lower, Uint32 upper, FILE *out, paging_t
 	int oldcols[DISASM_COLUMNS], newcols[DISASM_COLUMNS];
 	int show, shown, addrs, active;
 	const char *symbol;
-	cpu_profile_item_t *data;
 	Uint32 idx, end, size;
 	uaecptr nextpc, addr;
 
-	data = cpu_profile.data;
-	if (!data) {
+	if (!cpu_profile.pages) {
 		fprintf(stderr, "ERROR: no CPU profiling data available!\n");
 		return 0;
 	}
@@ -479,11 +550,8 @@ Uint32 Profile_CpuShowAddresses(Uint32 lower, Uint32 upper, FILE *out, paging_t
 	shown = 2; /* first and last printf */
 
 	addrs = nextpc = 0;
-	idx = address2index(lower);
-	for (; shown < show && addrs < active && idx < end; idx++) {
-		if (!data[idx].count) {
-			continue;
-		}
+	idx = next_active_index(address2index(lower), end);
+	for (; shown < show && addrs < active && idx < end; idx = next_active_index(idx + 1, end)) {
 		addr = index2address(idx);
 		if (addr != nextpc && nextpc) {
 			fprintf(out, "[...]\n");
@@ -536,8 +604,8 @@ static void leave_instruction_column(int *oldcols)
  */
 static int cmp_cpu_i_misses(const void *p1, const void *p2)
 {
-	Uint32 count1 = cpu_profile.data[*(const Uint32*)p1].i_misses;
-	Uint32 count2 = cpu_profile.data[*(const Uint32*)p2].i_misses;
+	Uint32 count1 = index2data(*(const Uint32*)p1)->i_misses;
+	Uint32 count2 = index2data(*(const Uint32*)p2)->i_misses;
 	if (count1 > count2) {
 		return -1;
 	}
@@ -555,7 +623,6 @@ void Profile_CpuShowInstrMisses(int show)
 	int active;
 	int oldcols[DISASM_COLUMNS];
 	Uint32 *sort_arr, *end, addr, nextpc;
-	cpu_profile_item_t *data = cpu_profile.data;
 	float percentage;
 	Uint32 count;
 
@@ -574,7 +641,7 @@ void Profile_CpuShowInstrMisses(int show)
 	show = (show < active ? show : active);
 	for (end = sort_arr + show; sort_arr < end; sort_arr++) {
 		addr = index2address(*sort_arr);
-		count = data[*sort_arr].i_misses;
+		count = index2data(*sort_arr)->i_misses;
 		percentage = 100.0*count/cpu_profile.all.i_misses;
 		fprintf(stderr, "0x%06x\t%5.2f%%\t%d%s\t", addr, percentage, count,
 		       count == MAX_CPU_PROFILE_VALUE ? " (OVERFLOW)" : "");
@@ -590,8 +657,8 @@ void Profile_CpuShowInstrMisses(int show)
  */
 static int cmp_cpu_d_hits(const void *p1, const void *p2)
 {
-	Uint32 count1 = cpu_profile.data[*(const Uint32*)p1].d_hits;
-	Uint32 count2 = cpu_profile.data[*(const Uint32*)p2].d_hits;
+	Uint32 count1 = index2data(*(const Uint32*)p1)->d_hits;
+	Uint32 count2 = index2data(*(const Uint32*)p2)->d_hits;
 	if (count1 > count2) {
 		return -1;
 	}
@@ -609,7 +676,6 @@ void Profile_CpuShowDataHits(int show)
 	int active;
 	int oldcols[DISASM_COLUMNS];
 	Uint32 *sort_arr, *end, addr, nextpc;
-	cpu_profile_item_t *data = cpu_profile.data;
 	float percentage;
 	Uint32 count;
 
@@ -628,7 +694,7 @@ void Profile_CpuShowDataHits(int show)
 	show = (show < active ? show : active);
 	for (end = sort_arr + show; sort_arr < end; sort_arr++) {
 		addr = index2address(*sort_arr);
-		count = data[*sort_arr].d_hits;
+		count = index2data(*sort_arr)->d_hits;
 		percentage = 100.0*count/cpu_profile.all.d_hits;
 		fprintf(stderr, "0x%06x\t%5.2f%%\t%d%s\t", addr, percentage, count,
 		       count == MAX_CPU_PROFILE_VALUE ? " (OVERFLOW)" : "");
@@ -645,8 +711,8 @@ void Profile_CpuShowDataHits(int show)
  */
 static int cmp_cpu_cycles(const void *p1, const void *p2)
 {
-	Uint32 count1 = cpu_profile.data[*(const Uint32*)p1].cycles;
-	Uint32 count2 = cpu_profile.data[*(const Uint32*)p2].cycles;
+	Uint32 count1 = index2data(*(const Uint32*)p1)->cycles;
+	Uint32 count2 = index2data(*(const Uint32*)p2)->cycles;
 	if (count1 > count2) {
 		return -1;
 	}
@@ -664,11 +730,10 @@ void Profile_CpuShowCycles(int show)
 	int active;
 	int oldcols[DISASM_COLUMNS];
 	Uint32 *sort_arr, *end, addr, nextpc;
-	cpu_profile_item_t *data = cpu_profile.data;
 	float percentage;
 	Uint32 count;
 
-	if (!data) {
+	if (!cpu_profile.pages) {
 		fprintf(stderr, "ERROR: no CPU profiling data available!\n");
 		return;
 	}
@@ -683,7 +748,7 @@ void Profile_CpuShowCycles(int show)
 	show = (show < active ? show : active);
 	for (end = sort_arr + show; sort_arr < end; sort_arr++) {
 		addr = index2address(*sort_arr);
-		count = data[*sort_arr].cycles;
+		count = index2data(*sort_arr)->cycles;
 		percentage = 100.0*count/cpu_profile.all.cycles;
 		fprintf(stderr, "0x%06x\t%5.2f%%\t%d%s\t", addr, percentage, count,
 		       count == MAX_CPU_PROFILE_VALUE ? " (OVERFLOW)" : "");
@@ -700,8 +765,8 @@ void Profile_CpuShowCycles(int show)
  */
 static int cmp_cpu_count(const void *p1, const void *p2)
 {
-	Uint32 count1 = cpu_profile.data[*(const Uint32*)p1].count;
-	Uint32 count2 = cpu_profile.data[*(const Uint32*)p2].count;
+	Uint32 count1 = index2data(*(const Uint32*)p1)->count;
+	Uint32 count2 = index2data(*(const Uint32*)p2)->count;
 	if (count1 > count2) {
 		return -1;
 	}
@@ -718,7 +783,6 @@ static int cmp_cpu_count(const void *p1, const void *p2)
  */
 void Profile_CpuShowCounts(int show, bool only_symbols)
 {
-	cpu_profile_item_t *data = cpu_profile.data;
 	int symbols, matched, active;
 	int oldcols[DISASM_COLUMNS];
 	Uint32 *sort_arr, *end, addr, nextpc;
@@ -726,7 +790,7 @@ void Profile_CpuShowCounts(int show, bool only_symbols)
 	float percentage;
 	Uint32 count;
 
-	if (!data) {
+	if (!cpu_profile.pages) {
 		fprintf(stderr, "ERROR: no CPU profiling data available!\n");
 		return;
 	}
@@ -741,7 +805,7 @@ void Profile_CpuShowCounts(int show, bool only_symbols)
 		fprintf(stderr, "addr:\t\tcount:\n");
 		for (end = sort_arr + show; sort_arr < end; sort_arr++) {
 			addr = index2address(*sort_arr);
-			count = data[*sort_arr].count;
+			count = index2data(*sort_arr)->count;
 			percentage = 100.0*count/cpu_profile.all.count;
 			fprintf(stderr, "0x%06x\t%5.2f%%\t%d%s\t",
 			       addr, percentage, count,
@@ -770,7 +834,7 @@ void Profile_CpuShowCounts(int show, bool only_symbols)
 		if (!name) {
 			continue;
 		}
-		count = data[*sort_arr].count;
+		count = index2data(*sort_arr)->count;
 		percentage = 100.0*count/cpu_profile.all.count;
 		fprintf(stderr, "0x%06x %6.2f %8d  %-26s %s",
 		       addr, percentage, count, name,
@@ -791,7 +855,7 @@ void Profile_CpuShowCounts(int show, bool only_symbols)
 static const char * addr2name(Uint32 addr, Uint64 *total)
 {
 	Uint32 idx = address2index(addr);
-	*total = cpu_profile.data[idx].count;
+	*total = index2data(idx)->count;
 	return Symbols_GetByCpuAddress(addr, SYMTYPE_TEXT);
 }
 
@@ -843,6 +907,24 @@ void Profile_CpuSave(FILE *out)
 
 /* ------------------ CPU profile control ----------------- */
 
+/**
+ * Free profile data pages and their table
+ */
+static void free_pages(void)
+{
+	Uint32 i;
+
+	for (i = 0; i < cpu_profile.pagecount; i++) {
+		if (cpu_profile.pages[i]) {
+			free(cpu_profile.pages[i]);
+		}
+	}
+	free(cpu_profile.pages);
+	cpu_profile.pages = NULL;
+	cpu_profile.pagecount = 0;
+	cpu_profile.pagesused = 0;
+}
+
 /**
  * Free data from last profiling run, if any
  */
@@ -853,9 +935,8 @@ void Profile_CpuFree(void)
 		free(cpu_profile.sort_arr);
 		cpu_profile.sort_arr = NULL;
 	}
-	if (cpu_profile.data) {
-		free(cpu_profile.data);
-		cpu_profile.data = NULL;
+	if (cpu_profile.pages) {
+		free_pages();
 		fprintf(stderr, "Freed previous CPU profile buffers.\n");
 	}
 }
@@ -865,14 +946,18 @@ void Profile_CpuFree(void)
  */
 bool Profile_CpuStart(void)
 {
+	Uint32 sample_cycles;
 	int size;
 
+	CycInt_RemovePendingInterrupt(INTERRUPT_PROFILE_SAMPLE);
 	Profile_CpuFree();
 	if (!cpu_profile.enabled) {
 		return false;
 	}
 	/* zero everything */
+	sample_cycles = cpu_profile.sample_cycles;
 	memset(&cpu_profile, 0, sizeof(cpu_profile));
+	cpu_profile.sample_cycles = sample_cycles;
 	memset(&cpu_warnings, 0, sizeof(cpu_warnings));
 	cpu_warnings.multireturn = MAX_MULTI_RETURN;
 
@@ -883,13 +968,15 @@ bool Profile_CpuStart(void)
 	}
 
 	/* Add one entry for catching invalid PC values */
-	cpu_profile.data = calloc(size + 1, sizeof(*cpu_profile.data));
-	if (!cpu_profile.data) {
+	cpu_profile.pagecount = (size + PROFILE_PAGE_ITEMS) >> PROFILE_PAGE_SHIFT;
+	cpu_profile.pages = calloc(cpu_profile.pagecount, sizeof(*cpu_profile.pages));
+	if (!cpu_profile.pages) {
 		perror("ERROR, new CPU profile buffer alloc failed");
+		cpu_profile.pagecount = 0;
 		return false;
 	}
-	fprintf(stderr, "Allocated CPU profile buffer (%d MB).\n",
-	       (int)sizeof(*cpu_profile.data)*size/(1024*1024));
+	fprintf(stderr, "Allocated CPU profile page table (%d KB).\n",
+	       (int)sizeof(*cpu_profile.pages)*cpu_profile.pagecount/1024);
 	cpu_profile.size = size;
 
 	Profile_AllocCallinfo(&(cpu_callinfo), Symbols_CpuCodeCount(), "CPU");
@@ -914,6 +1001,12 @@ bool Profile_CpuStart(void)
 	cpu_profile.disasm_addr = 0;
 	cpu_profile.processed = false;
 	cpu_profile.enabled = true;
+
+	if (cpu_profile.sample_cycles) {
+		/* statistical profiling doesn't need per-instruction updates */
+		CycInt_AddRelativeInterrupt(cpu_profile.sample_cycles, INT_CPU_CYCLE, INTERRUPT_PROFILE_SAMPLE);
+		return false;
+	}
 	return cpu_profile.enabled;
 }
 
@@ -1165,7 +1258,7 @@ void Profile_CpuUpdate(void)
 
 	idx = address2index(prev_pc);
 	assert(idx <= cpu_profile.size);
-	prev = cpu_profile.data + idx;
+	prev = index2item(idx);
 
 	if (likely(prev->count < MAX_CPU_PROFILE_VALUE)) {
 		prev->count++;
@@ -1271,10 +1364,173 @@ void Profile_CpuUpdate(void)
 }
 
 
+/* ------------------ CPU profile sampling ----------------- */
+
+/**
+ * If given return address is after a subroutine call instruction,
+ * return address of that instruction, otherwise PC_UNDEFINED.
+ *
+ * For calls with a known target, that needs to be within given
+ * (callee) function for the call to be accepted.  Indirect calls
+ * are accepted as-is.
+ */
+static Uint32 sample_call_addr(Uint32 ret, Uint32 callee)
+{
+	Uint32 target, addr;
+	Uint16 op;
+	int len;
+
+	if ((ret & 1) || !STMemory_CheckAreaType(ret - 6, 6, ABFLAG_RAM | ABFLAG_ROM)) {
+		return PC_UNDEFINED;
+	}
+	/* check longest instructions first */
+	op = STMemory_ReadWord(ret - 6);
+	if (op == 0x61ff) {
+		/* bsr.l */
+		len = 6;
+		target = ret - 4 + STMemory_ReadLong(ret - 4);
+	} else if (op == 0x4eb9) {
+		/* jsr abs.l */
+		len = 6;
+		target = STMemory_ReadLong(ret - 4);
+	} else {
+		op = STMemory_ReadWord(ret - 4);
+		len = 4;
+		if (op == 0x6100 || op == 0x4eba) {
+			/* bsr.w, jsr d16(pc) */
+			target = ret - 2 + (Sint16)STMemory_ReadWord(ret - 2);
+		} else if (op == 0x4eb8) {
+			/* jsr abs.w */
+			target = (Sint16)STMemory_ReadWord(ret - 2);
+		} else if ((op & 0xfff8) == 0x4ea8 || (op & 0xfff8) == 0x4eb0 || op == 0x4ebb) {
+			/* jsr d16(An), jsr d8(An,Xn), jsr d8(pc,Xn) */
+			return ret - len;
+		} else {
+			op = STMemory_ReadWord(ret - 2);
+			len = 2;
+			if ((op & 0xff00) == 0x6100 && (op & 0xff) && (op & 0xff) != 0xff) {
+				/* bsr.s */
+				target = ret + (Sint8)(op & 0xff);
+			} else if ((op & 0xfff8) == 0x4e90) {
+				/* jsr (An) */
+				return ret - len;
+			} else {
+				return PC_UNDEFINED;
+			}
+		}
+	}
+	addr = target;
+	if (!Symbols_GetBeforeCpuAddress(&addr) || addr != callee) {
+		return PC_UNDEFINED;
+	}
+	return ret - len;
+}
+
+/**
+ * Collect caller information for sampled PC by scanning the stack
+ * for return addresses, starting from function containing the PC.
+ */
+static void sample_calls(Uint32 pc, counters_t *cost)
+{
+	int i, idx, depth, path[MAX_SAMPLE_DEPTH + 1], outer[MAX_SAMPLE_DEPTH + 1];
+	Uint32 sp, callee, caller;
+	bool own = true;
+
+	callee = pc;
+	if (!Symbols_GetBeforeCpuAddress(&callee)) {
+		Profile_CallPathSample(&cpu_callinfo, NULL, 0, cost);
+		return;
+	}
+	depth = 0;
+	idx = Symbols_GetCpuCodeIndex(callee);
+	if (idx >= 0) {
+		path[depth++] = idx;
+	}
+	sp = regs.regs[15];
+	for (i = 0; i < MAX_SAMPLE_STACK && depth <= MAX_SAMPLE_DEPTH; i++, sp += 2) {
+		if (!STMemory_CheckAreaType(sp, 4, ABFLAG_RAM)) {
+			break;
+		}
+		caller = sample_call_addr(STMemory_ReadLong(sp), callee);
+		if (caller == PC_UNDEFINED) {
+			continue;
+		}
+		/* own cost only for the function with the sampled PC */
+		if (idx >= 0) {
+			Profile_CallSample(&cpu_callinfo, idx, callee, caller, cost, own);
+		}
+		own = false;
+		/* continue from function which did the call */
+		callee = caller;
+		if (!Symbols_GetBeforeCpuAddress(&callee)) {
+			break;
+		}
+		idx = Symbols_GetCpuCodeIndex(callee);
+		if (idx >= 0 && depth <= MAX_SAMPLE_DEPTH) {
+			path[depth++] = idx;
+		}
+		sp += 2;
+	}
+	/* call path goes from outermost function inwards */
+	for (i = 0; i < depth; i++) {
+		outer[i] = path[depth - 1 - i];
+	}
+	Profile_CallPathSample(&cpu_callinfo, outer, depth, cost);
+}
+
+/**
+ * Cycle interrupt handler for statistical CPU profiling: add sample
+ * for current PC address, with cycles since previous sample.
+ */
+void Profile_CpuSample(void)
+{
+	counters_t *counters = &(cpu_profile.all);
+	cpu_profile_item_t *item;
+	Uint32 pc, idx, cycles;
+	counters_t cost;
+
+	CycInt_AcknowledgeInterrupt();
+	if (!(cpu_profile.pages && cpu_profile.sample_cycles)) {
+		return;
+	}
+	CycInt_AddRelativeInterrupt(cpu_profile.sample_cycles, INT_CPU_CYCLE, INTERRUPT_PROFILE_SAMPLE);
+
+	pc = M68000_GetPC();
+	if (ConfigureParams.System.bAddressSpace24) {
+		pc &= 0xffffff;
+	}
+	idx = address2index(pc);
+	assert(idx <= cpu_profile.size);
+	item = index2item(idx);
+
+	cycles = CyclesGlobalClockCounter - cpu_profile.prev_cycles;
+	cpu_profile.prev_cycles = CyclesGlobalClockCounter;
+
+	if (likely(item->count < MAX_CPU_PROFILE_VALUE)) {
+		item->count++;
+	}
+	if (likely(item->cycles < MAX_CPU_PROFILE_VALUE - cycles)) {
+		item->cycles += cycles;
+	} else {
+		item->cycles = MAX_CPU_PROFILE_VALUE;
+	}
+
+	if (cpu_callinfo.sites) {
+		memset(&cost, 0, sizeof(cost));
+		cost.calls = 1;
+		cost.count = 1;
+		cost.cycles = cycles;
+		sample_calls(pc, &cost);
+	}
+	counters->count++;
+	counters->cycles += cycles;
+}
+
+
 /**
  * Helper for accounting CPU profile area item.
  */
-static void update_area_item(profile_area_t *area, Uint32 addr, cpu_profile_item_t *item)
+static void update_area_item(profile_area_t *area, Uint32 addr, const cpu_profile_item_t *item)
 {
 	Uint32 cycles = item->cycles;
 	Uint32 count = item->count;
@@ -1303,17 +1559,16 @@ static void update_area_item(profile_area_t *area, Uint32 addr, cpu_profile_item
  */
 static Uint32 update_area(profile_area_t *area, Uint32 start, Uint32 end)
 {
-	cpu_profile_item_t *item;
 	Uint32 addr;
 
 	memset(area, 0, sizeof(profile_area_t));
 	area->lowest = end;
 
-	item = &(cpu_profile.data[start]);
-	for (addr = start; addr < end; addr++, item++) {
-		update_area_item(area, addr, item);
+	addr = next_active_index(start, end);
+	for (; addr < end; addr = next_active_index(addr + 1, end)) {
+		update_area_item(area, addr, index2data(addr));
 	}
-	return addr;
+	return end;
 }
 
 /**
@@ -1321,14 +1576,15 @@ static Uint32 update_area(profile_area_t *area, Uint32 start, Uint32 end)
  */
 static Uint32* index_area(profile_area_t *area, Uint32 *sort_arr)
 {
-	cpu_profile_item_t *item;
-	Uint32 addr;
+	Uint32 addr, end;
 
-	item = &(cpu_profile.data[area->lowest]);
-	for (addr = area->lowest; addr <= area->highest; addr++, item++) {
-		if (item->count) {
-			*sort_arr++ = addr;
-		}
+	if (!area->active) {
+		return sort_arr;
+	}
+	end = area->highest + 1;
+	addr = next_active_index(area->lowest, end);
+	for (; addr < end; addr = next_active_index(addr + 1, end)) {
+		*sort_arr++ = addr;
 	}
 	return sort_arr;
 }
@@ -1343,6 +1599,7 @@ void Profile_CpuStop(void)
 	unsigned int size, stsize;
 	int active;
 
+	CycInt_RemovePendingInterrupt(INTERRUPT_PROFILE_SAMPLE);
 	if (cpu_profile.processed || !cpu_profile.enabled) {
 		return;
 	}
@@ -1403,12 +1660,12 @@ void Profile_CpuStop(void)
 
 	if (!sort_arr) {
 		perror("ERROR: allocating CPU profile address data");
-		free(cpu_profile.data);
-		cpu_profile.data = NULL;
+		free_pages();
 		return;
 	}
-	fprintf(stderr, "Allocated CPU profile address buffer (%d KB).\n",
-	       (int)sizeof(*sort_arr)*(active+512)/1024);
+	fprintf(stderr, "Allocated CPU profile address buffer (%d KB), data uses %d pages (%d KB).\n",
+	       (int)sizeof(*sort_arr)*(active+512)/1024, cpu_profile.pagesused,
+	       (int)(sizeof(cpu_profile_item_t)*PROFILE_PAGE_ITEMS/1024)*cpu_profile.pagesused);
 	cpu_profile.sort_arr = sort_arr;
 	cpu_profile.active = active;
 
@@ -1434,6 +1691,14 @@ void Profile_CpuGetPointers(bool **enabled, Uint32 **disasm_addr)
 	*enabled = &cpu_profile.enabled;
 }
 
+/**
+ * Set CPU profile sampling period, zero profiles every instruction.
+ */
+void Profile_CpuSetSampling(Uint32 cycles)
+{
+	cpu_profile.sample_cycles = cycles;
+}
+
 /**
  * Get callinfo & symbol search pointers for stack walking.
  */
@@ -30,6 +30,13 @@ typedef struct {
 	symbol_t *names;	/* all items sorted by symbol name */
 	char *strtab;		/* from a.out only */
 	char *debug_strtab;	/* from pure-c debug information only */
+	/* lookup indexes, built only by the debugger */
+	int *codepages;		/* TEXT address page -> first symbol index */
+	uint32_t pagebase;	/* address of the first TEXT symbol */
+	uint32_t pagecount;	/* number of TEXT address pages */
+	int pageshift;		/* TEXT address -> page shift */
+	int *namehash;		/* name hash -> names index + 1, 0 = empty */
+	uint32_t hashmask;	/* name hash table size - 1 */
 } symbol_list_t;
 
 typedef struct {
@@ -208,8 +215,12 @@ static void symbol_list_free(symbol_list_t *list)
 	list->debug_strtab = NULL;
 	free(list->addresses);
 	free(list->names);
+	free(list->codepages);
+	free(list->namehash);
 
 	/* catch use of freed list */
+	list->codepages = NULL;
+	list->namehash = NULL;
 	list->addresses = NULL;
 	list->codecount = 0;
 	list->datacount = 0;
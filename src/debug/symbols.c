@@ -43,6 +43,11 @@ const char Symbols_fileid[] = "Hatari symbols.c";
  */
 #define MAX_SYM_SIZE 32
 
+/* TEXT symbol count from which address page index is built */
+#define SYMBOLS_INDEX_MIN 64
+/* smallest TEXT address page size, 2^4 = 16 bytes */
+#define SYMBOLS_PAGE_SHIFT_MIN 4
+
 /* TODO: add symbol name/address file names to configuration? */
 static symbol_list_t *CpuSymbolsList;
 static symbol_list_t *DspSymbolsList;
@@ -225,6 +230,83 @@ static void symbols_trim_addresses(symbol_list_t* list)
 	list->datacount = list->namecount - i;
 }
 
+/**
+ * Return hash for given symbol name (FNV-1a).
+ */
+static uint32_t symbols_hash_name(const char *name)
+{
+	uint32_t hash = 2166136261u;
+
+	while (*name) {
+		hash ^= (unsigned char)*name++;
+		hash *= 16777619u;
+	}
+	return hash;
+}
+
+/**
+ * Build open addressing hash table for symbol name lookups.
+ * Names are added in sorted order, so for name duplicates,
+ * the one earlier in the names list is found first.
+ */
+static void symbols_index_names(symbol_list_t* list)
+{
+	uint32_t size, idx;
+	int i;
+
+	/* keep table at most half full */
+	for (size = 16; size < 2 * (uint32_t)list->namecount; size <<= 1)
+		;
+	list->namehash = calloc(size, sizeof(int));
+	assert(list->namehash);
+	list->hashmask = size - 1;
+
+	for (i = 0; i < list->namecount; i++) {
+		idx = symbols_hash_name(list->names[i].name) & list->hashmask;
+		while (list->namehash[idx]) {
+			idx = (idx + 1) & list->hashmask;
+		}
+		list->namehash[idx] = i + 1;
+	}
+}
+
+/**
+ * Build page index for TEXT symbol address lookups.  For each
+ * address page, index tells the first symbol at or after page start,
+ * so lookups need to search only the symbols within a single page.
+ * Page size is selected so that there are at most ~2 pages per symbol.
+ */
+static void symbols_index_addresses(symbol_list_t* list)
+{
+	const symbol_t *sym = list->addresses;
+	int i, count = list->codecount;
+	uint32_t page, range;
+
+	/* binary search is fast enough for small symbol counts */
+	if (count < SYMBOLS_INDEX_MIN) {
+		return;
+	}
+	list->pagebase = sym[0].address;
+	range = sym[count-1].address - list->pagebase;
+
+	list->pageshift = SYMBOLS_PAGE_SHIFT_MIN;
+	while ((range >> list->pageshift) > 2 * (uint32_t)count) {
+		list->pageshift++;
+	}
+	list->pagecount = (range >> list->pageshift) + 1;
+
+	/* extra item at end for the symbol count */
+	list->codepages = malloc((list->pagecount + 1) * sizeof(int));
+	assert(list->codepages);
+
+	for (i = 0, page = 0; page <= list->pagecount; page++) {
+		while (i < count && ((sym[i].address - list->pagebase) >> list->pageshift) < page) {
+			i++;
+		}
+		list->codepages[page] = i;
+	}
+}
+
 /**
  * Set sections to match running process by adding TEXT/DATA/BSS
  * start addresses to section offsets and ends, and return true if
@@ -324,6 +406,10 @@ static symbol_list_t* Symbols_Load(const char *filename, Uint32 *offsets, Uint32
 	qsort(list->addresses, list->namecount, sizeof(symbol_t), symbols_by_address);
 	symbols_trim_addresses(list);
 
+	/* lookup indexes for name & TEXT address searches */
+	symbols_index_names(list);
+	symbols_index_addresses(list);
+
 	/* skip verbose output when symbols are auto-loaded */
 	if (ConfigureParams.Debugger.bSymbolsAutoLoad) {
 		fprintf(stderr, "Skipping duplicate address & symbol name checks when autoload is enabled.\n");
@@ -439,29 +525,22 @@ char* Symbols_MatchDspDataAddress(const char *text, int state)
 /* ---------------- symbol name -> address search ------------------ */
 
 /**
- * Binary search symbol of given type by name.
+ * Search symbol of given type by name from the list name hash.
  * Return symbol if name matches, zero otherwise.
  */
-static const symbol_t* Symbols_SearchByName(symbol_t* entries, int count, symtype_t symtype, const char *name)
+static const symbol_t* Symbols_SearchByName(symbol_list_t* list, symtype_t symtype, const char *name)
 {
-	/* left, right, middle */
-        int l, r, m, dir;
+	const symbol_t *entry;
+	uint32_t idx;
 
-	/* bisect */
-	l = 0;
-	r = count - 1;
-	do {
-		m = (l+r) >> 1;
-		dir = strcmp(entries[m].name, name);
-		if (dir == 0 && (entries[m].type & symtype)) {
-			return &(entries[m]);
-		}
-		if (dir > 0) {
-			r = m-1;
-		} else {
-			l = m+1;
+	idx = symbols_hash_name(name) & list->hashmask;
+	while (list->namehash[idx]) {
+		entry = &(list->names[list->namehash[idx] - 1]);
+		if ((entry->type & symtype) && strcmp(entry->name, name) == 0) {
+			return entry;
 		}
-	} while (l <= r);
+		idx = (idx + 1) & list->hashmask;
+	}
 	return NULL;
 }
 
@@ -472,10 +551,10 @@ static const symbol_t* Symbols_SearchByName(symbol_t* entries, int count, symtyp
 static bool Symbols_GetAddress(symbol_list_t* list, symtype_t symtype, const char *name, Uint32 *addr)
 {
 	const symbol_t *entry;
-	if (!(list && list->names)) {
+	if (!(list && list->namehash)) {
 		return false;
 	}
-	entry = Symbols_SearchByName(list->names, list->namecount, symtype, name);
+	entry = Symbols_SearchByName(list, symtype, name);
 	if (entry) {
 		*addr = entry->address;
 		return true;
@@ -523,12 +602,60 @@ static int Symbols_SearchBeforeAddress(symbol_t* entries, int count, Uint32 addr
 	return r;
 }
 
+/**
+ * Search TEXT symbol by address in given list, using the address
+ * page index when it's available.  Return index for symbol which
+ * address matches or precedes the given one, -1 if there's none.
+ *
+ * Performance critical, called on every instruction
+ * when profiling is enabled.
+ */
+static int Symbols_SearchCodeBefore(symbol_list_t* list, Uint32 addr)
+{
+	uint32_t page;
+	int first, count;
+
+	if (!list->codecount) {
+		return -1;
+	}
+	if (!list->codepages) {
+		return Symbols_SearchBeforeAddress(list->addresses, list->codecount, addr);
+	}
+	if (addr < list->pagebase) {
+		return -1;
+	}
+	page = (addr - list->pagebase) >> list->pageshift;
+	if (page >= list->pagecount) {
+		return list->codecount - 1;
+	}
+	/* symbols within the page, if none, the one before it */
+	first = list->codepages[page];
+	count = list->codepages[page+1] - first;
+	if (!count) {
+		return first - 1;
+	}
+	return first + Symbols_SearchBeforeAddress(list->addresses + first, count, addr);
+}
+
+/**
+ * Search TEXT symbol by address in given list.
+ * Return symbol index if address matches, -1 otherwise.
+ */
+static int Symbols_SearchCode(symbol_list_t* list, Uint32 addr)
+{
+	int i = Symbols_SearchCodeBefore(list, addr);
+	if (i >= 0 && list->addresses[i].address == addr) {
+		return i;
+	}
+	return -1;
+}
+
 static const char* Symbols_GetBeforeAddress(symbol_list_t *list, Uint32 *addr)
 {
 	if (!(list && list->addresses)) {
 		return NULL;
 	}
-	int i = Symbols_SearchBeforeAddress(list->addresses, list->codecount, *addr);
+	int i = Symbols_SearchCodeBefore(list, *addr);
 	if (i >= 0) {
 		*addr = list->addresses[i].address;
 		return list->addresses[i].name;
@@ -547,9 +674,6 @@ const char* Symbols_GetBeforeDspAddress(Uint32 *addr)
 /**
  * Binary search symbol by address in given sorted list.
  * Return symbol index if address matches, -1 otherwise.
- *
- * Performance critical, called on every instruction
- * when profiling is enabled.
  */
 static int Symbols_SearchByAddress(symbol_t* entries, int count, Uint32 addr)
 {
@@ -587,7 +711,7 @@ static const char* Symbols_GetByAddress(symbol_list_t* list, Uint32 addr, symtyp
 		return NULL;
 	}
 	if (type & SYMTYPE_TEXT) {
-		int i = Symbols_SearchByAddress(list->addresses, list->codecount, addr);
+		int i = Symbols_SearchCode(list, addr);
 		if (i >= 0) {
 			return list->addresses[i].name;
 		}
@@ -618,7 +742,7 @@ static int Symbols_GetCodeIndex(symbol_list_t* list, Uint32 addr)
 	if (!list) {
 		return -1;
 	}
-	return Symbols_SearchByAddress(list->addresses, list->codecount, addr);
+	return Symbols_SearchCode(list, addr);
 }
 int Symbols_GetCpuCodeIndex(Uint32 addr)
 {
@@ -0,0 +1,104 @@
+/*
+ * Hatari - tracebuf-common.c
+ *
+ * This file is distributed under the GNU General Public License, version 2
+ * or at your option any later version. Read the file gpl.txt for details.
+ *
+ * tracebuf-common.c - printf format parsing for the binary trace events.
+ *
+ * This code is shared between the trace event writer in Hatari
+ * and the standalone "trace2ascii" decoder tool, so that both
+ * agree on the arguments stored for each format.
+ */
+
+/**
+ * Find next conversion in printf format string 'fmt'.  Set 'end' to
+ * point after it, and store the argument types for it to 'args',
+ * '*' width and precision arguments first.
+ * Return pointer to the conversion '%' character, or NULL if there
+ * are no more conversions.  'nargs' is set to the argument count.
+ */
+static const char *TraceBuf_NextConversion(const char *fmt, const char **end,
+                                           int *args, int *nargs)
+{
+	const char *start;
+	int type = TRACEBUF_ARG_INT;
+
+	*nargs = 0;
+	start = strchr(fmt, '%');
+	if (!start)
+		return NULL;
+
+	fmt = start + 1;
+	/* flags, field width and precision */
+	while (*fmt && strchr("-+ #0'123456789.*", *fmt))
+	{
+		if (*fmt == '*' && *nargs < 2)
+			args[(*nargs)++] = TRACEBUF_ARG_INT;
+		fmt++;
+	}
+	/* length modifier */
+	switch (*fmt)
+	{
+	case 'h':
+		fmt += (fmt[1] == 'h') ? 2 : 1;
+		break;
+	case 'l':
+		if (fmt[1] == 'l')
+		{
+			type = TRACEBUF_ARG_LLONG;
+			fmt++;
+		}
+		else
+			type = TRACEBUF_ARG_LONG;
+		fmt++;
+		break;
+	case 'q':
+		type = TRACEBUF_ARG_LLONG;
+		fmt++;
+		break;
+	case 'j':
+		type = TRACEBUF_ARG_INTMAX;
+		fmt++;
+		break;
+	case 'z':
+		type = TRACEBUF_ARG_SIZE;
+		fmt++;
+		break;
+	case 't':
+		type = TRACEBUF_ARG_PTRDIFF;
+		fmt++;
+		break;
+	case 'L':
+		type = TRACEBUF_ARG_LDOUBLE;
+		fmt++;
+		break;
+	}
+	/* conversion */
+	switch (*fmt)
+	{
+	case 'e': case 'E': case 'f': case 'F':
+	case 'g': case 'G': case 'a': case 'A':
+		if (type != TRACEBUF_ARG_LDOUBLE)
+			type = TRACEBUF_ARG_DOUBLE;
+		break;
+	case 's':
+		type = TRACEBUF_ARG_STR;
+		break;
+	case 'p':
+		type = TRACEBUF_ARG_PTR;
+		break;
+	case '%':
+		type = TRACEBUF_ARG_NONE;
+		break;
+	case '\0':
+		/* incomplete conversion, output as-is */
+		*nargs = 0;
+		*end = fmt;
+		return start;
+	}
+	if (type != TRACEBUF_ARG_NONE)
+		args[(*nargs)++] = type;
+	*end = fmt + 1;
+	return start;
+}
@@ -0,0 +1,450 @@
+/*
+ * Hatari - tracebuf.c
+ *
+ * This file is distributed under the GNU General Public License, version 2
+ * or at your option any later version. Read the file gpl.txt for details.
+ *
+ * Binary trace event output.
+ *
+ * Instead of formatting and flushing trace output text for every
+ * event, LOG_TRACE() events are stored as compact binary records
+ * (format id, cycle timestamp, arguments) into a per-thread ring
+ * buffer.  A background thread drains the ring buffers to the trace
+ * file.  The "trace2ascii" tool renders such a file back to text.
+ *
+ * Each ring has a single producer (its thread) and a single consumer
+ * (the writer thread), so the ring head and tail are updated without
+ * locks.  A mutex is used only when a thread traces for the first
+ * time or a format string is seen for the first time.
+ */
+const char TraceBuf_fileid[] = "Hatari tracebuf.c";
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <SDL.h>
+
+#include "main.h"
+#include "cycles.h"
+#include "file.h"
+#include "log.h"
+#include "tracebuf.h"
+
+#include "tracebuf-common.c"
+
+#define TRACEBUF_RING_SIZE	(1 << 20)	/* bytes, power of 2 */
+#define TRACEBUF_MAX_THREADS	8
+#define TRACEBUF_MAX_RECORD	2048		/* longer strings are truncated */
+#define TRACEBUF_MAX_FORMATS	4096
+#define TRACEBUF_HASH_SIZE	(2 * TRACEBUF_MAX_FORMATS)
+
+typedef struct {
+	Uint8 *data;
+	SDL_atomic_t head;	/* advanced by the producing thread */
+	SDL_atomic_t tail;	/* advanced by the writer thread */
+} tracebuf_ring_t;
+
+typedef struct {
+	const char *format;
+	int nargs;
+	Uint8 args[TRACEBUF_MAX_ARGS];
+} tracebuf_format_t;
+
+bool LogTraceBinary;
+
+static FILE *TraceBufFile;
+static SDL_Thread *pWriterThread;
+static SDL_sem *pWriterWakeup;
+static SDL_mutex *pRegisterMutex;
+static SDL_TLSID RingTLS;
+static bool bWriterQuit;
+
+static tracebuf_ring_t Rings[TRACEBUF_MAX_THREADS];
+static SDL_atomic_t nRings;
+
+/* format id is the index to Formats[], id 0 is for text which
+ * could not be stored as binary arguments
+ */
+static tracebuf_format_t Formats[TRACEBUF_MAX_FORMATS];
+static SDL_atomic_t nFormats;
+static int nFormatsWritten;
+static void *FormatHashKeys[TRACEBUF_HASH_SIZE];
+static Uint16 FormatHashIds[TRACEBUF_HASH_SIZE];
+
+
+/**
+ * Parse argument types for given format string to 'fmt'.
+ * Return false if the format has too many arguments.
+ */
+static bool TraceBuf_ParseFormat(tracebuf_format_t *fmt, const char *format)
+{
+	const char *conv, *end = format;
+	int args[3], nargs, i;
+
+	fmt->format = format;
+	fmt->nargs = 0;
+	while ((conv = TraceBuf_NextConversion(end, &end, args, &nargs)))
+	{
+		if (fmt->nargs + nargs > TRACEBUF_MAX_ARGS)
+			return false;
+		for (i = 0; i < nargs; i++)
+			fmt->args[fmt->nargs++] = args[i];
+	}
+	return true;
+}
+
+/**
+ * Return format id for given format string, registering it on first use.
+ * Lookup is lock-free, hash entries are never removed while tracing.
+ */
+static int TraceBuf_FormatId(const char *format)
+{
+	unsigned int slot = ((uintptr_t)format >> 3) % TRACEBUF_HASH_SIZE;
+	void *key;
+	int id;
+
+	while ((key = SDL_AtomicGetPtr(&FormatHashKeys[slot])))
+	{
+		if (key == format)
+			return FormatHashIds[slot];
+		slot = (slot + 1) % TRACEBUF_HASH_SIZE;
+	}
+
+	SDL_LockMutex(pRegisterMutex);
+	/* another thread may have registered it meanwhile */
+	while ((key = SDL_AtomicGetPtr(&FormatHashKeys[slot])) && key != format)
+		slot = (slot + 1) % TRACEBUF_HASH_SIZE;
+	if (key)
+	{
+		id = FormatHashIds[slot];
+	}
+	else
+	{
+		id = SDL_AtomicGet(&nFormats);
+		if (id < TRACEBUF_MAX_FORMATS && TraceBuf_ParseFormat(&Formats[id], format))
+			SDL_AtomicSet(&nFormats, id + 1);
+		else
+			id = 0;
+		FormatHashIds[slot] = id;
+		SDL_AtomicSetPtr(&FormatHashKeys[slot], (void *)(uintptr_t)format);
+	}
+	SDL_UnlockMutex(pRegisterMutex);
+	return id;
+}
+
+/**
+ * Return ring buffer for the calling thread, or NULL if there are
+ * already too many tracing threads.
+ */
+static tracebuf_ring_t *TraceBuf_GetRing(void)
+{
+	tracebuf_ring_t *ring = SDL_TLSGet(RingTLS);
+	int idx;
+
+	if (ring)
+		return ring;
+
+	SDL_LockMutex(pRegisterMutex);
+	idx = SDL_AtomicGet(&nRings);
+	if (idx < TRACEBUF_MAX_THREADS)
+	{
+		ring = &Rings[idx];
+		ring->data = malloc(TRACEBUF_RING_SIZE);
+		if (ring->data)
+		{
+			SDL_TLSSet(RingTLS, ring, NULL);
+			SDL_AtomicSet(&nRings, idx + 1);
+		}
+		else
+			ring = NULL;
+	}
+	SDL_UnlockMutex(pRegisterMutex);
+	return ring;
+}
+
+/**
+ * Store string argument to record at 'p', with at most 'space' bytes.
+ * Return number of bytes used.
+ */
+static int TraceBuf_PutString(Uint8 *p, int space, const char *str)
+{
+	Uint32 len;
+
+	if (!str)
+	{
+		len = TRACEBUF_STR_NULL;
+		memcpy(p, &len, sizeof(len));
+		return TRACEBUF_ALIGN(sizeof(len));
+	}
+	len = strlen(str);
+	if (len > space - sizeof(len))
+		len = space - sizeof(len);
+	memcpy(p, &len, sizeof(len));
+	memcpy(p + sizeof(len), str, len);
+	return TRACEBUF_ALIGN(sizeof(len) + len);
+}
+
+/**
+ * Copy record to the ring, waiting for the writer thread to make
+ * space if the ring is full.
+ */
+static void TraceBuf_PutRecord(tracebuf_ring_t *ring, const Uint8 *rec, Uint32 size)
+{
+	Uint32 head = SDL_AtomicGet(&ring->head);
+	Uint32 offset = head & (TRACEBUF_RING_SIZE - 1);
+	Uint32 used;
+
+	while ((used = head - (Uint32)SDL_AtomicGet(&ring->tail)) + size > TRACEBUF_RING_SIZE)
+	{
+		SDL_SemPost(pWriterWakeup);
+		SDL_Delay(1);
+	}
+
+	if (offset + size <= TRACEBUF_RING_SIZE)
+	{
+		memcpy(ring->data + offset, rec, size);
+	}
+	else
+	{
+		Uint32 part = TRACEBUF_RING_SIZE - offset;
+		memcpy(ring->data + offset, rec, part);
+		memcpy(ring->data, rec + part, size - part);
+	}
+	/* publish the record to the writer */
+	SDL_AtomicSet(&ring->head, head + size);
+
+	if (used + size > TRACEBUF_RING_SIZE / 2)
+		SDL_SemPost(pWriterWakeup);
+}
+
+/**
+ * Store trace event with given printf format and arguments.
+ * Return number of bytes stored.
+ */
+int TraceBuf_Printf(const char *format, ...)
+{
+	Uint64 rec[TRACEBUF_MAX_RECORD / sizeof(Uint64)];
+	tracebuf_rec_t *hdr = (tracebuf_rec_t *)rec;
+	Uint8 *p = (Uint8 *)rec + sizeof(*hdr);
+	Uint8 *end = (Uint8 *)rec + sizeof(rec);
+	tracebuf_ring_t *ring;
+	tracebuf_format_t *fmt;
+	va_list ap;
+	int i;
+
+	ring = TraceBuf_GetRing();
+	if (!ring)
+		return 0;
+
+	hdr->type = TRACEBUF_REC_EVENT;
+	hdr->id = TraceBuf_FormatId(format);
+	hdr->cycles = CyclesGlobalClockCounter;
+	fmt = &Formats[hdr->id];
+
+	va_start(ap, format);
+	if (hdr->id == 0)
+	{
+		/* too many formats or arguments, store as text */
+		char text[TRACEBUF_MAX_RECORD - sizeof(*hdr) - sizeof(Uint32)];
+		vsnprintf(text, sizeof(text), format, ap);
+		p += TraceBuf_PutString(p, end - p, text);
+	}
+	else
+	{
+		for (i = 0; i < fmt->nargs; i++)
+		{
+			Sint64 val = 0;
+			double dval;
+
+			switch (fmt->args[i])
+			{
+			case TRACEBUF_ARG_STR:
+				p += TraceBuf_PutString(p, end - p - 8 * (fmt->nargs - i - 1),
+				                        va_arg(ap, const char *));
+				continue;
+			case TRACEBUF_ARG_DOUBLE:
+				dval = va_arg(ap, double);
+				memcpy(p, &dval, sizeof(dval));
+				p += 8;
+				continue;
+			case TRACEBUF_ARG_LDOUBLE:
+				dval = va_arg(ap, long double);
+				memcpy(p, &dval, sizeof(dval));
+				p += 8;
+				continue;
+			case TRACEBUF_ARG_INT:
+				val = va_arg(ap, int);
+				break;
+			case TRACEBUF_ARG_LONG:
+				val = va_arg(ap, long);
+				break;
+			case TRACEBUF_ARG_LLONG:
+				val = va_arg(ap, long long);
+				break;
+			case TRACEBUF_ARG_SIZE:
+				val = va_arg(ap, size_t);
+				break;
+			case TRACEBUF_ARG_INTMAX:
+				val = va_arg(ap, intmax_t);
+				break;
+			case TRACEBUF_ARG_PTRDIFF:
+				val = va_arg(ap, ptrdiff_t);
+				break;
+			case TRACEBUF_ARG_PTR:
+				val = (uintptr_t)va_arg(ap, void *);
+				break;
+			}
+			memcpy(p, &val, sizeof(val));
+			p += 8;
+		}
+	}
+	va_end(ap);
+
+	hdr->size = p - (Uint8 *)rec;
+	TraceBuf_PutRecord(ring, (Uint8 *)rec, hdr->size);
+	return hdr->size;
+}
+
+/**
+ * Write new format strings and all buffered events to the trace file
+ */
+static void TraceBuf_Drain(void)
+{
+	Uint32 heads[TRACEBUF_MAX_THREADS];
+	tracebuf_rec_t hdr;
+	int i, count, rings;
+
+	/* Formats are registered before they're used in events, so
+	 * ring heads need to be read before the format count, for all
+	 * the formats used by the written events to be written first
+	 */
+	rings = SDL_AtomicGet(&nRings);
+	for (i = 0; i < rings; i++)
+		heads[i] = SDL_AtomicGet(&Rings[i].head);
+
+	count = SDL_AtomicGet(&nFormats);
+	for (; nFormatsWritten < count; nFormatsWritten++)
+	{
+		const char *format = Formats[nFormatsWritten].format;
+		size_t len = strlen(format) + 1;
+		static const Uint8 pad[8];
+
+		hdr.size = TRACEBUF_ALIGN(sizeof(hdr) + len);
+		hdr.type = TRACEBUF_REC_FORMAT;
+		hdr.id = nFormatsWritten;
+		hdr.cycles = 0;
+		fwrite(&hdr, sizeof(hdr), 1, TraceBufFile);
+		fwrite(format, len, 1, TraceBufFile);
+		fwrite(pad, hdr.size - sizeof(hdr) - len, 1, TraceBufFile);
+	}
+
+	for (i = 0; i < rings; i++)
+	{
+		tracebuf_ring_t *ring = &Rings[i];
+		Uint32 head = heads[i];
+		Uint32 tail = SDL_AtomicGet(&ring->tail);
+		Uint32 offset = tail & (TRACEBUF_RING_SIZE - 1);
+		Uint32 size = head - tail;
+
+		if (!size)
+			continue;
+		if (offset + size <= TRACEBUF_RING_SIZE)
+		{
+			fwrite(ring->data + offset, size, 1, TraceBufFile);
+		}
+		else
+		{
+			fwrite(ring->data + offset, TRACEBUF_RING_SIZE - offset, 1, TraceBufFile);
+			fwrite(ring->data, size - (TRACEBUF_RING_SIZE - offset), 1, TraceBufFile);
+		}
+		SDL_AtomicSet(&ring->tail, head);
+	}
+	fflush(TraceBufFile);
+}
+
+/**
+ * Writer thread: drain the rings when woken up, or periodically
+ */
+static int TraceBuf_Writer(void *unused)
+{
+	while (!bWriterQuit)
+	{
+		SDL_SemWaitTimeout(pWriterWakeup, 50);
+		TraceBuf_Drain();
+	}
+	TraceBuf_Drain();
+	return 0;
+}
+
+/**
+ * Open binary trace file and start the writer thread.
+ * Return false on failure.
+ */
+bool TraceBuf_Init(const char *filename)
+{
+	static const Uint32 byteorder = TRACEBUF_BYTEORDER;
+
+	TraceBuf_UnInit();
+
+	TraceBufFile = File_Open(filename, "wb");
+	if (!TraceBufFile)
+		return false;
+	fwrite(TRACEBUF_MAGIC, 8, 1, TraceBufFile);
+	fwrite(&byteorder, sizeof(byteorder), 1, TraceBufFile);
+
+	/* id 0 is for events stored as text */
+	Formats[0].format = "%s";
+	Formats[0].nargs = 1;
+	Formats[0].args[0] = TRACEBUF_ARG_STR;
+	SDL_AtomicSet(&nFormats, 1);
+	nFormatsWritten = 0;
+
+	/* thread rings and their registration stay for the whole run */
+	if (!RingTLS)
+		RingTLS = SDL_TLSCreate();
+	if (!pRegisterMutex)
+		pRegisterMutex = SDL_CreateMutex();
+	pWriterWakeup = SDL_CreateSemaphore(0);
+	bWriterQuit = false;
+	if (RingTLS && pRegisterMutex && pWriterWakeup)
+		pWriterThread = SDL_CreateThread(TraceBuf_Writer, "Hatari trace writer", NULL);
+	if (!pWriterThread)
+	{
+		Log_Printf(LOG_ERROR, "Could not start binary trace writer: %s\n", SDL_GetError());
+		TraceBuf_UnInit();
+		return false;
+	}
+	LogTraceBinary = true;
+	return true;
+}
+
+/**
+ * Stop the writer thread after it has written all events,
+ * and close the binary trace file.
+ */
+void TraceBuf_UnInit(void)
+{
+	int i;
+
+	LogTraceBinary = false;
+	if (pWriterThread)
+	{
+		bWriterQuit = true;
+		SDL_SemPost(pWriterWakeup);
+		SDL_WaitThread(pWriterThread, NULL);
+		pWriterThread = NULL;
+	}
+	if (pWriterWakeup)
+	{
+		SDL_DestroySemaphore(pWriterWakeup);
+		pWriterWakeup = NULL;
+	}
+	TraceBufFile = File_Close(TraceBufFile);
+
+	for (i = 0; i < SDL_AtomicGet(&nRings); i++)
+	{
+		SDL_AtomicSet(&Rings[i].head, 0);
+		SDL_AtomicSet(&Rings[i].tail, 0);
+	}
+	memset(FormatHashKeys, 0, sizeof(FormatHashKeys));
+}
@@ -0,0 +1,64 @@
+/*
+ * Hatari - tracebuf.h
+ *
+ * This file is distributed under the GNU General Public License, version 2
+ * or at your option any later version. Read the file gpl.txt for details.
+ *
+ * Binary trace file format, shared with the standalone "trace2ascii"
+ * decoder tool, and the API for writing it.
+ */
+#ifndef HATARI_TRACEBUF_H
+#define HATARI_TRACEBUF_H
+
+#include <stdint.h>
+
+/* File starts with the magic and TRACEBUF_BYTEORDER as uint32_t,
+ * all values are in the byte order of the host writing the trace.
+ */
+#define TRACEBUF_MAGIC		"HATRACE1"
+#define TRACEBUF_BYTEORDER	0x01020304
+
+/* Record types */
+enum {
+	TRACEBUF_REC_FORMAT,	/* printf format string for given id */
+	TRACEBUF_REC_EVENT	/* trace event using format of given id */
+};
+
+/* Each record starts with this header and is padded to 8 bytes.
+ * FORMAT record header is followed by a nil terminated string,
+ * EVENT record header by the arguments for that format, 8 bytes
+ * each, except for strings which are stored as uint32_t length
+ * (TRACEBUF_STR_NULL for NULL pointer) followed by the characters.
+ */
+typedef struct {
+	uint32_t size;		/* record size in bytes, including header */
+	uint16_t type;
+	uint16_t id;		/* format id */
+	uint64_t cycles;	/* emulated cycle count at the event */
+} tracebuf_rec_t;
+
+#define TRACEBUF_STR_NULL	0xffffffff
+#define TRACEBUF_ALIGN(size)	(((size) + 7) & ~7)
+
+/* Argument types of the printf conversions */
+enum {
+	TRACEBUF_ARG_INT,
+	TRACEBUF_ARG_LONG,
+	TRACEBUF_ARG_LLONG,
+	TRACEBUF_ARG_SIZE,
+	TRACEBUF_ARG_INTMAX,
+	TRACEBUF_ARG_PTRDIFF,
+	TRACEBUF_ARG_DOUBLE,
+	TRACEBUF_ARG_LDOUBLE,
+	TRACEBUF_ARG_STR,
+	TRACEBUF_ARG_PTR,
+	TRACEBUF_ARG_NONE	/* "%%" */
+};
+
+/* Max number of arguments stored for one event */
+#define TRACEBUF_MAX_ARGS	16
+
+extern bool TraceBuf_Init(const char *filename);
+extern void TraceBuf_UnInit(void);
+
+#endif /* HATARI_TRACEBUF_H */
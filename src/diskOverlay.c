@@ -0,0 +1,548 @@
+/*
+  Hatari - diskOverlay.c
+
+  This file is distributed under the GNU General Public License, version 2
+  or at your option any later version. Read the file gpl.txt for details.
+
+  Copy-on-write overlays for hard disk images.
+
+  When an overlay directory is configured, ACSI/SCSI/IDE images are
+  opened read-only and all writes go to a per-image overlay file in
+  that directory instead.  Several Hatari instances can then share
+  the same base image (and its pages in the host page cache), each
+  one only storing its own changes.
+
+  Overlay file layout (numbers are big endian):
+	0    "HTOVL001" magic
+	8    block size (32-bit)
+	12   reserved, zero
+	16   size of the base image in bytes (64-bit)
+	512  bitmap of the blocks stored in the overlay, one bit per block
+	data offset (bitmap end aligned to 4 KiB): block N is stored at
+	     data offset + N * block size.  Blocks not in the overlay are
+	     never written, so the file stays sparse on the host.
+
+  Floppy images are completely loaded to memory, so for them the overlay
+  is just a full copy of the modified image, see floppy.c.
+*/
+const char DiskOverlay_fileid[] = "Hatari diskOverlay.c";
+
+#include <errno.h>
+#include <inttypes.h>
+#include <unistd.h>
+
+#include "main.h"
+#include "configuration.h"
+#include "diskOverlay.h"
+#include "file.h"
+#include "log.h"
+#include "utils.h"
+
+#define OVERLAY_MAGIC		"HTOVL001"
+#define OVERLAY_HEADER_SIZE	512
+#define OVERLAY_ALIGN		4096
+#define OVERLAY_MAX		(MAX_ACSI_DEVS + MAX_SCSI_DEVS + MAX_IDE_DEVS)
+#define OVERLAY_COPY_BLOCKS	128	/* max blocks copied at once on merge */
+
+struct disk_overlay {
+	char *basefile;		/* base image file name */
+	char filename[FILENAME_MAX];	/* overlay file name */
+	FILE *base;		/* base image file, owned by the caller */
+	FILE *fp;		/* overlay file */
+	Uint8 *bitmap;		/* blocks stored in the overlay */
+	size_t bitmapBytes;
+	Uint32 blockSize;
+	Uint64 nBlocks;
+	Uint64 nUsed;		/* number of blocks stored in the overlay */
+	off_t dataOffset;
+};
+
+static DISK_OVERLAY *Overlays[OVERLAY_MAX];
+
+
+/*-----------------------------------------------------------------------*/
+/**
+ * Return true if writes to disk images should go to overlay files
+ */
+bool DiskOverlay_IsEnabled(void)
+{
+	return ConfigureParams.HardDisk.bUseImageOverlays &&
+	       ConfigureParams.HardDisk.szImageOverlayDir[0];
+}
+
+/**
+ * Put name of the overlay file for given image file with optional
+ * extra extension to 'buf'.  Return zero on success, negative on error.
+ *
+ * CRC of the absolute image path is added before the image file
+ * extension, so that same named images in different directories get
+ * different overlays, and floppy overlays keep the image type extension.
+ */
+int DiskOverlay_FileName(char *buf, size_t buflen, const char *imagefile, const char *ext)
+{
+	char path[FILENAME_MAX], name[FILENAME_MAX];
+	const char *base, *dot;
+	Uint32 crc;
+	int i;
+
+	strncpy(path, imagefile, sizeof(path));
+	path[sizeof(path) - 1] = '\0';
+	File_MakeAbsoluteName(path);
+	crc32_reset(&crc);
+	for (i = 0; path[i]; i++)
+		crc32_add_byte(&crc, path[i]);
+
+	base = strrchr(imagefile, PATHSEP);
+	base = base ? base + 1 : imagefile;
+	dot = strrchr(base, '.');
+	if (!dot || dot == base)
+		dot = base + strlen(base);
+	if (snprintf(name, sizeof(name), "%.*s-%08x%s", (int)(dot - base),
+	             base, crc, dot) >= (int)sizeof(name))
+		return -E2BIG;
+
+	return File_MakePathBuf(buf, buflen, ConfigureParams.HardDisk.szImageOverlayDir, name, ext);
+}
+
+
+/*-----------------------------------------------------------------------*/
+/**
+ * Store / fetch big endian values in the overlay header
+ */
+static void DiskOverlay_PutBE(Uint8 *p, Uint64 val, int bytes)
+{
+	while (bytes--)
+	{
+		p[bytes] = val & 0xff;
+		val >>= 8;
+	}
+}
+static Uint64 DiskOverlay_GetBE(const Uint8 *p, int bytes)
+{
+	Uint64 val = 0;
+
+	while (bytes--)
+		val = (val << 8) | *p++;
+	return val;
+}
+
+static inline bool DiskOverlay_IsSet(DISK_OVERLAY *ov, Uint64 block)
+{
+	return ov->bitmap[block >> 3] & (1 << (block & 7));
+}
+
+/**
+ * Find next run of blocks stored in the overlay, starting from 'block'
+ * and ending before 'end'.  Return run length, or zero if there are
+ * no more overlay blocks in the range.
+ */
+static Uint64 DiskOverlay_NextRun(DISK_OVERLAY *ov, Uint64 *block, Uint64 end)
+{
+	Uint64 start;
+
+	for (start = *block; start < end; start++)
+	{
+		/* skip quickly over unmodified areas */
+		if ((start & 7) == 0 && start + 8 <= end && !ov->bitmap[start >> 3])
+		{
+			start += 7;
+			continue;
+		}
+		if (DiskOverlay_IsSet(ov, start))
+			break;
+	}
+	*block = start;
+	while (start < end && DiskOverlay_IsSet(ov, start))
+		start++;
+	return start - *block;
+}
+
+/**
+ * Write overlay header and the whole block bitmap
+ */
+static bool DiskOverlay_WriteHeader(DISK_OVERLAY *ov)
+{
+	Uint8 header[OVERLAY_HEADER_SIZE];
+
+	memset(header, 0, sizeof(header));
+	memcpy(header, OVERLAY_MAGIC, 8);
+	DiskOverlay_PutBE(header + 8, ov->blockSize, 4);
+	DiskOverlay_PutBE(header + 16, ov->nBlocks * ov->blockSize, 8);
+
+	if (fseeko(ov->fp, 0, SEEK_SET) != 0
+	    || fwrite(header, sizeof(header), 1, ov->fp) != 1
+	    || fwrite(ov->bitmap, ov->bitmapBytes, 1, ov->fp) != 1
+	    || fflush(ov->fp) != 0)
+	{
+		perror("DiskOverlay_WriteHeader");
+		return false;
+	}
+	return true;
+}
+
+/**
+ * Read header and block bitmap of an existing overlay file.
+ * Return false if it is not an overlay for an image of our size.
+ */
+static bool DiskOverlay_ReadHeader(DISK_OVERLAY *ov)
+{
+	Uint8 header[OVERLAY_HEADER_SIZE];
+	Uint64 i;
+
+	if (fread(header, sizeof(header), 1, ov->fp) != 1
+	    || memcmp(header, OVERLAY_MAGIC, 8) != 0
+	    || DiskOverlay_GetBE(header + 8, 4) != ov->blockSize
+	    || DiskOverlay_GetBE(header + 16, 8) != ov->nBlocks * ov->blockSize
+	    || fread(ov->bitmap, ov->bitmapBytes, 1, ov->fp) != 1)
+	{
+		return false;
+	}
+	ov->nUsed = 0;
+	for (i = 0; i < ov->nBlocks; i++)
+	{
+		if (DiskOverlay_IsSet(ov, i))
+			ov->nUsed++;
+	}
+	return true;
+}
+
+static void DiskOverlay_Free(DISK_OVERLAY *ov)
+{
+	free(ov->basefile);
+	free(ov->bitmap);
+	free(ov);
+}
+
+
+/*-----------------------------------------------------------------------*/
+/**
+ * Open (or create) overlay for the given base image.  'base' is the
+ * read-only base image file, which is used to drop stale stdio buffers
+ * after merging the overlay back to the image.
+ * Return overlay, or NULL on error.
+ */
+DISK_OVERLAY *DiskOverlay_Open(FILE *base, const char *basefile, off_t size, int blockSize)
+{
+	DISK_OVERLAY *ov;
+	int slot;
+
+	for (slot = 0; slot < OVERLAY_MAX && Overlays[slot]; slot++)
+		;
+	if (slot == OVERLAY_MAX)
+	{
+		Log_Printf(LOG_ERROR, "Too many disk image overlays in use!\n");
+		return NULL;
+	}
+
+	ov = calloc(1, sizeof(DISK_OVERLAY));
+	if (!ov)
+	{
+		perror("DiskOverlay_Open");
+		return NULL;
+	}
+	ov->base = base;
+	ov->blockSize = blockSize;
+	ov->nBlocks = size / blockSize;
+	ov->bitmapBytes = (ov->nBlocks + 7) / 8;
+	ov->dataOffset = (OVERLAY_HEADER_SIZE + ov->bitmapBytes + OVERLAY_ALIGN - 1)
+	                 & ~(off_t)(OVERLAY_ALIGN - 1);
+	ov->bitmap = calloc(1, ov->bitmapBytes);
+	ov->basefile = strdup(basefile);
+	if (!ov->bitmap || !ov->basefile)
+	{
+		perror("DiskOverlay_Open");
+		DiskOverlay_Free(ov);
+		return NULL;
+	}
+	if (DiskOverlay_FileName(ov->filename, sizeof(ov->filename), basefile, "ovl") != 0)
+	{
+		Log_Printf(LOG_ERROR, "Overlay file name for '%s' is too long!\n", basefile);
+		DiskOverlay_Free(ov);
+		return NULL;
+	}
+
+	ov->fp = fopen(ov->filename, "rb+");
+	if (ov->fp && !DiskOverlay_ReadHeader(ov))
+	{
+		Log_Printf(LOG_WARN, "Overlay '%s' does not match image '%s', discarding it.\n",
+		           ov->filename, basefile);
+		fclose(ov->fp);
+		ov->fp = NULL;
+	}
+	if (!ov->fp)
+	{
+		memset(ov->bitmap, 0, ov->bitmapBytes);
+		ov->nUsed = 0;
+		ov->fp = fopen(ov->filename, "wb+");
+		if (!ov->fp || !DiskOverlay_WriteHeader(ov))
+		{
+			Log_AlertDlg(LOG_ERROR, "Cannot create disk image overlay\n'%s'!",
+			             ov->filename);
+			if (ov->fp)
+				fclose(ov->fp);
+			DiskOverlay_Free(ov);
+			return NULL;
+		}
+	}
+	if (!File_Lock(ov->fp))
+	{
+		Log_AlertDlg(LOG_ERROR, "Locking disk image overlay failed\n'%s'!",
+		             ov->filename);
+		fclose(ov->fp);
+		DiskOverlay_Free(ov);
+		return NULL;
+	}
+
+	Overlays[slot] = ov;
+	Log_Printf(LOG_INFO, "Using overlay '%s' (%"PRIu64" modified blocks) for '%s'\n",
+	           ov->filename, ov->nUsed, basefile);
+	return ov;
+}
+
+/**
+ * Flush and close the overlay
+ */
+void DiskOverlay_Close(DISK_OVERLAY *ov)
+{
+	int i;
+
+	if (!ov)
+		return;
+	for (i = 0; i < OVERLAY_MAX; i++)
+	{
+		if (Overlays[i] == ov)
+			Overlays[i] = NULL;
+	}
+	fflush(ov->fp);
+	File_UnLock(ov->fp);
+	fclose(ov->fp);
+	DiskOverlay_Free(ov);
+}
+
+
+/*-----------------------------------------------------------------------*/
+/**
+ * Return true if any of the given blocks is stored in the overlay,
+ * i.e. the base image data can not be used as-is for them.
+ */
+bool DiskOverlay_HasBlocks(DISK_OVERLAY *ov, Uint64 block, int count)
+{
+	if (!ov || !ov->nUsed)
+		return false;
+	return DiskOverlay_NextRun(ov, &block, block + count) != 0;
+}
+
+/**
+ * Replace the blocks in 'buf' (which has been read from the base image)
+ * with the blocks stored in the overlay.  Return false on error.
+ */
+bool DiskOverlay_Read(DISK_OVERLAY *ov, Uint64 block, int count, Uint8 *buf)
+{
+	Uint64 start = block, end = block + count, len;
+
+	if (!ov || !ov->nUsed)
+		return true;
+
+	while ((len = DiskOverlay_NextRun(ov, &start, end)) != 0)
+	{
+		if (fseeko(ov->fp, ov->dataOffset + (off_t)start * ov->blockSize, SEEK_SET) != 0
+		    || fread(buf + (start - block) * ov->blockSize, ov->blockSize, len, ov->fp) != len)
+		{
+			perror("DiskOverlay_Read");
+			return false;
+		}
+		start += len;
+	}
+	return true;
+}
+
+/**
+ * Store given blocks to the overlay.  Return false on error.
+ */
+bool DiskOverlay_Write(DISK_OVERLAY *ov, Uint64 block, int count, const Uint8 *buf)
+{
+	Uint64 i, first, last;
+
+	if (count <= 0)
+		return true;
+	if (block + count > ov->nBlocks)
+		return false;
+
+	if (fseeko(ov->fp, ov->dataOffset + (off_t)block * ov->blockSize, SEEK_SET) != 0
+	    || fwrite(buf, ov->blockSize, count, ov->fp) != (size_t)count)
+	{
+		perror("DiskOverlay_Write");
+		return false;
+	}
+
+	for (i = block; i < block + count; i++)
+	{
+		if (!DiskOverlay_IsSet(ov, i))
+		{
+			ov->bitmap[i >> 3] |= 1 << (i & 7);
+			ov->nUsed++;
+		}
+	}
+
+	/* Data first, then the changed part of the bitmap */
+	first = block >> 3;
+	last = (block + count - 1) >> 3;
+	if (fseeko(ov->fp, OVERLAY_HEADER_SIZE + first, SEEK_SET) != 0
+	    || fwrite(&ov->bitmap[first], last - first + 1, 1, ov->fp) != 1)
+	{
+		perror("DiskOverlay_Write");
+		return false;
+	}
+	return true;
+}
+
+/**
+ * Flush overlay file writes
+ */
+void DiskOverlay_Sync(DISK_OVERLAY *ov)
+{
+	if (ov)
+		fflush(ov->fp);
+}
+
+
+/*-----------------------------------------------------------------------*/
+/**
+ * Remove all blocks from the overlay
+ */
+static bool DiskOverlay_Clear(DISK_OVERLAY *ov)
+{
+	memset(ov->bitmap, 0, ov->bitmapBytes);
+	ov->nUsed = 0;
+	if (!DiskOverlay_WriteHeader(ov))
+		return false;
+	/* give the space back to the host */
+	if (ftruncate(fileno(ov->fp), ov->dataOffset) != 0)
+		perror("DiskOverlay_Clear");
+	return true;
+}
+
+/**
+ * Write the overlay blocks to the base image and clear the overlay
+ */
+static bool DiskOverlay_Merge(DISK_OVERLAY *ov)
+{
+	Uint64 start = 0, len, n;
+	Uint8 *buf;
+	FILE *fp;
+	bool ok = true;
+
+	if (!ov->nUsed)
+		return true;
+
+	fp = fopen(ov->basefile, "rb+");
+	if (!fp || !File_Lock(fp))
+	{
+		Log_Printf(LOG_ERROR, "Cannot open '%s' for writing, overlay not merged.\n",
+		           ov->basefile);
+		if (fp)
+			fclose(fp);
+		return false;
+	}
+	buf = malloc(OVERLAY_COPY_BLOCKS * ov->blockSize);
+	if (!buf)
+	{
+		perror("DiskOverlay_Merge");
+		File_UnLock(fp);
+		fclose(fp);
+		return false;
+	}
+
+	while (ok && (len = DiskOverlay_NextRun(ov, &start, ov->nBlocks)) != 0)
+	{
+		for (; len; start += n, len -= n)
+		{
+			n = len < OVERLAY_COPY_BLOCKS ? len : OVERLAY_COPY_BLOCKS;
+			if (fseeko(ov->fp, ov->dataOffset + (off_t)start * ov->blockSize, SEEK_SET) != 0
+			    || fread(buf, ov->blockSize, n, ov->fp) != n
+			    || fseeko(fp, (off_t)start * ov->blockSize, SEEK_SET) != 0
+			    || fwrite(buf, ov->blockSize, n, fp) != n)
+			{
+				perror("DiskOverlay_Merge");
+				ok = false;
+				break;
+			}
+		}
+	}
+	free(buf);
+
+	if (fflush(fp) != 0)
+		ok = false;
+	File_UnLock(fp);
+	fclose(fp);
+
+	/* drop stale data from the base image stdio buffers */
+	if (ov->base)
+		fseeko(ov->base, 0, SEEK_SET);
+
+	if (!ok)
+	{
+		Log_Printf(LOG_ERROR, "Merging overlay '%s' to '%s' failed!\n",
+		           ov->filename, ov->basefile);
+		return false;
+	}
+	Log_Printf(LOG_INFO, "Merged %"PRIu64" blocks from '%s' to '%s'.\n",
+	           ov->nUsed, ov->filename, ov->basefile);
+	return DiskOverlay_Clear(ov);
+}
+
+/**
+ * Merge all open overlays to their base images.
+ * Return number of overlays that could not be merged.
+ */
+int DiskOverlay_MergeAll(void)
+{
+	int i, failed = 0;
+
+	for (i = 0; i < OVERLAY_MAX; i++)
+	{
+		if (Overlays[i] && !DiskOverlay_Merge(Overlays[i]))
+			failed++;
+	}
+	return failed;
+}
+
+/**
+ * Throw away contents of all open overlays.
+ * Return number of overlays that could not be cleared.
+ */
+int DiskOverlay_DiscardAll(void)
+{
+	int i, failed = 0;
+
+	for (i = 0; i < OVERLAY_MAX; i++)
+	{
+		if (!Overlays[i])
+			continue;
+		if (DiskOverlay_Clear(Overlays[i]))
+			Log_Printf(LOG_INFO, "Discarded overlay '%s'.\n", Overlays[i]->filename);
+		else
+			failed++;
+	}
+	return failed;
+}
+
+/**
+ * Show open overlays and how much they contain
+ */
+void DiskOverlay_Info(FILE *fp, Uint32 dummy)
+{
+	DISK_OVERLAY *ov;
+	int i, count = 0;
+
+	for (i = 0; i < OVERLAY_MAX; i++)
+	{
+		if (!(ov = Overlays[i]))
+			continue;
+		fprintf(fp, "%s:\n- base image: %s\n- modified: %"PRIu64"/%"PRIu64" blocks of %u bytes\n",
+		        ov->filename, ov->basefile, ov->nUsed, ov->nBlocks, ov->blockSize);
+		count++;
+	}
+	if (!count)
+		fprintf(fp, "No disk image overlays in use.\n");
+}
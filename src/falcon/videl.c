@@ -961,6 +961,10 @@ bool VIDEL_renderScreen(void)
 		return false;
 	}
 
+	/* Lines that didn't change are not converted again, so restore */
+	/* the area potentially left under the overlay led */
+	Statusbar_OverlayRestore(sdlscrn);
+
 	if (!Screen_Lock())
 		return false;
 
@@ -990,6 +994,7 @@ bool VIDEL_renderScreen(void)
 	                  videl.upperBorderSize, videl.lowerBorderSize);
 
 	Screen_UnLock();
+	Statusbar_OverlayBackup(sdlscrn);
 	Screen_GenConvUpdate(Statusbar_Update(sdlscrn, false), false);
 
 	return true;
@@ -29,6 +29,7 @@ const char Floppy_fileid[] = "Hatari floppy.c";
 
 #include "main.h"
 #include "configuration.h"
+#include "diskOverlay.h"
 #include "file.h"
 #include "floppy.h"
 #include "gemdos.h"
@@ -523,6 +524,8 @@ bool Floppy_InsertDiskIntoDrive(int Drive)
 {
 	long	nImageBytes = 0;
 	char	*filename;
+	const char *loadname, *stxname;
+	char	overlay[FILENAME_MAX];
 	int	ImageType = FLOPPY_IMAGE_TYPE_NONE;
 
 	/* Eject disk, if one is inserted (doesn't inform user) */
@@ -540,17 +543,30 @@ bool Floppy_InsertDiskIntoDrive(int Drive)
 		return false;
 	}
 
+	/* Changes saved earlier to an overlay replace the image contents */
+	loadname = stxname = filename;
+	if (DiskOverlay_IsEnabled()
+	    && DiskOverlay_FileName(overlay, sizeof(overlay), filename, NULL) == 0)
+	{
+		stxname = overlay;
+		if (File_Exists(overlay))
+		{
+			Log_Printf(LOG_INFO, "Using floppy overlay '%s'.", overlay);
+			loadname = overlay;
+		}
+	}
+
 	/* Check disk image type and read the file: */
 	if (MSA_FileNameIsMSA(filename, true))
-		EmulationDrives[Drive].pBuffer = MSA_ReadDisk(Drive, filename, &nImageBytes, &ImageType);
+		EmulationDrives[Drive].pBuffer = MSA_ReadDisk(Drive, loadname, &nImageBytes, &ImageType);
 	else if (ST_FileNameIsST(filename, true))
-		EmulationDrives[Drive].pBuffer = ST_ReadDisk(Drive, filename, &nImageBytes, &ImageType);
+		EmulationDrives[Drive].pBuffer = ST_ReadDisk(Drive, loadname, &nImageBytes, &ImageType);
 	else if (DIM_FileNameIsDIM(filename, true))
-		EmulationDrives[Drive].pBuffer = DIM_ReadDisk(Drive, filename, &nImageBytes, &ImageType);
+		EmulationDrives[Drive].pBuffer = DIM_ReadDisk(Drive, loadname, &nImageBytes, &ImageType);
 	else if (IPF_FileNameIsIPF(filename, true))
-		EmulationDrives[Drive].pBuffer = IPF_ReadDisk(Drive, filename, &nImageBytes, &ImageType);
+		EmulationDrives[Drive].pBuffer = IPF_ReadDisk(Drive, loadname, &nImageBytes, &ImageType);
 	else if (STX_FileNameIsSTX(filename, true))
-		EmulationDrives[Drive].pBuffer = STX_ReadDisk(Drive, filename, &nImageBytes, &ImageType);
+		EmulationDrives[Drive].pBuffer = STX_ReadDisk(Drive, loadname, &nImageBytes, &ImageType);
 	else if (ZIP_FileNameIsZIP(filename))
 	{
 		const char *zippath = ConfigureParams.DiskImage.szDiskZipPath[Drive];
@@ -578,7 +594,8 @@ bool Floppy_InsertDiskIntoDrive(int Drive)
 	/* For STX, call specific function to handle the inserted image */
 	else if ( ImageType == FLOPPY_IMAGE_TYPE_STX )
 	{
-		if ( STX_Insert ( Drive , filename , EmulationDrives[Drive].pBuffer , nImageBytes ) == false )
+		/* STX changes are kept in a separate file, which can be in the overlay dir */
+		if ( STX_Insert ( Drive , stxname , EmulationDrives[Drive].pBuffer , nImageBytes ) == false )
 		{
 			free ( EmulationDrives[Drive].pBuffer );
 			EmulationDrives[Drive].pBuffer = NULL;
@@ -615,10 +632,39 @@ bool Floppy_InsertDiskIntoDrive(int Drive)
 }
 
 
+/*-----------------------------------------------------------------------*/
+/**
+ * Save contents of the disk in given drive to the given file,
+ * in the format matching the file name extension.
+ * Return true on success.
+ */
+static bool Floppy_SaveImage(int Drive, const char *psFileName)
+{
+	Uint8 *pBuffer = EmulationDrives[Drive].pBuffer;
+	int nImageBytes = EmulationDrives[Drive].nImageBytes;
+
+	/* Save as .MSA, .ST, .DIM, .IPF or .STX image? */
+	if (MSA_FileNameIsMSA(psFileName, true))
+		return MSA_WriteDisk(Drive, psFileName, pBuffer, nImageBytes);
+	else if (ST_FileNameIsST(psFileName, true))
+		return ST_WriteDisk(Drive, psFileName, pBuffer, nImageBytes);
+	else if (DIM_FileNameIsDIM(psFileName, true))
+		return DIM_WriteDisk(Drive, psFileName, pBuffer, nImageBytes);
+	else if (IPF_FileNameIsIPF(psFileName, true))
+		return IPF_WriteDisk(Drive, psFileName, pBuffer, nImageBytes);
+	else if (STX_FileNameIsSTX(psFileName, true))
+		return STX_WriteDisk(Drive, psFileName, pBuffer, nImageBytes);
+	else if (ZIP_FileNameIsZIP(psFileName))
+		return ZIP_WriteDisk(Drive, psFileName, pBuffer, nImageBytes);
+	return false;
+}
+
+
 /*-----------------------------------------------------------------------*/
 /**
  * Eject disk from floppy drive, save contents back to PCs hard-drive if
- * they have been changed.
+ * they have been changed.  With disk image overlays, contents are saved
+ * to the overlay directory instead of the original image file.
  * Return true if there was something to eject.
  */
 bool Floppy_EjectDiskFromDrive(int Drive)
@@ -629,7 +675,8 @@ bool Floppy_EjectDiskFromDrive(int Drive)
 	if (EmulationDrives[Drive].bDiskInserted)
 	{
 		bool bSaved = false;
-		char *psFileName = EmulationDrives[Drive].sFileName;
+		const char *psFileName = EmulationDrives[Drive].sFileName;
+		char overlay[FILENAME_MAX];
 
 		/* OK, has contents changed? If so, need to save */
 		if (EmulationDrives[Drive].bContentsChanged)
@@ -637,19 +684,10 @@ bool Floppy_EjectDiskFromDrive(int Drive)
 			/* Is OK to save image (if boot-sector is bad, don't allow a save) */
 			if (EmulationDrives[Drive].bOKToSave)
 			{
-				/* Save as .MSA, .ST, .DIM, .IPF or .STX image? */
-				if (MSA_FileNameIsMSA(psFileName, true))
-					bSaved = MSA_WriteDisk(Drive, psFileName, EmulationDrives[Drive].pBuffer, EmulationDrives[Drive].nImageBytes);
-				else if (ST_FileNameIsST(psFileName, true))
-					bSaved = ST_WriteDisk(Drive, psFileName, EmulationDrives[Drive].pBuffer, EmulationDrives[Drive].nImageBytes);
-				else if (DIM_FileNameIsDIM(psFileName, true))
-					bSaved = DIM_WriteDisk(Drive, psFileName, EmulationDrives[Drive].pBuffer, EmulationDrives[Drive].nImageBytes);
-				else if (IPF_FileNameIsIPF(psFileName, true))
-					bSaved = IPF_WriteDisk(Drive, psFileName, EmulationDrives[Drive].pBuffer, EmulationDrives[Drive].nImageBytes);
-				else if (STX_FileNameIsSTX(psFileName, true))
-					bSaved = STX_WriteDisk(Drive, psFileName, EmulationDrives[Drive].pBuffer, EmulationDrives[Drive].nImageBytes);
-				else if (ZIP_FileNameIsZIP(psFileName))
-					bSaved = ZIP_WriteDisk(Drive, psFileName, EmulationDrives[Drive].pBuffer, EmulationDrives[Drive].nImageBytes);
+				if (DiskOverlay_IsEnabled()
+				    && DiskOverlay_FileName(overlay, sizeof(overlay), psFileName, NULL) == 0)
+					psFileName = overlay;
+				bSaved = Floppy_SaveImage(Drive, psFileName);
 				if (bSaved)
 					Log_Printf(LOG_INFO, "Updated the contents of floppy image '%s'.", psFileName);
 				else
@@ -693,6 +731,66 @@ bool Floppy_EjectDiskFromDrive(int Drive)
 }
 
 
+/*-----------------------------------------------------------------------*/
+/**
+ * Merge the overlays of the inserted floppy disks back to their images,
+ * or discard them and re-insert the unmodified images.
+ * Return number of drives for which this failed.
+ */
+int Floppy_MergeOverlays(bool bMerge)
+{
+	char overlay[FILENAME_MAX], savefile[FILENAME_MAX];
+	const char *psFileName;
+	int Drive, failed = 0;
+
+	if (!DiskOverlay_IsEnabled())
+		return 0;
+
+	for (Drive = 0; Drive < MAX_FLOPPYDRIVES; Drive++)
+	{
+		psFileName = EmulationDrives[Drive].sFileName;
+		if (!EmulationDrives[Drive].bDiskInserted
+		    || DiskOverlay_FileName(overlay, sizeof(overlay), psFileName, NULL) != 0)
+			continue;
+		/* STX changes are in a separate file */
+		if (EmulationDrives[Drive].ImageType == FLOPPY_IMAGE_TYPE_STX)
+		{
+			if (!STX_FileNameToSave(overlay, savefile))
+				continue;
+		}
+		else
+			strcpy(savefile, overlay);
+
+		if (!EmulationDrives[Drive].bContentsChanged && !File_Exists(savefile))
+			continue;
+
+		/* Drive buffer has the overlay contents and any later changes */
+		if (bMerge)
+		{
+			if (!EmulationDrives[Drive].bOKToSave || !Floppy_SaveImage(Drive, psFileName))
+			{
+				Log_Printf(LOG_WARN, "Merging floppy overlay to '%s' failed.", psFileName);
+				failed++;
+				continue;
+			}
+			Log_Printf(LOG_INFO, "Merged floppy overlay to '%s'.", psFileName);
+		}
+		EmulationDrives[Drive].bContentsChanged = false;
+		if (File_Exists(savefile) && remove(savefile) != 0)
+		{
+			perror("Floppy_MergeOverlays");
+			failed++;
+		}
+		if (!bMerge)
+		{
+			Log_Printf(LOG_INFO, "Discarded floppy overlay '%s'.", savefile);
+			Floppy_InsertDiskIntoDrive(Drive);
+		}
+	}
+	return failed;
+}
+
+
 /*-----------------------------------------------------------------------*/
 /**
  * Eject all disk image from floppy drives - call when quit.
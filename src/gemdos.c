@@ -130,12 +130,21 @@ static struct {
 	Uint32 Basepage;
 } ForcedHandles[5]; /* (standard) handles aliased to emulated handles */
 
+/* Last stdio operation done on a file handle. Written data is kept in
+ * the stdio buffer until the handle is flushed, and switching between
+ * reading and writing requires a flush or a seek in between.
+ */
+#define FH_OP_NONE	0
+#define FH_OP_READ	1
+#define FH_OP_WRITE	2
+
 typedef struct
 {
 	bool bUsed;
 	char szMode[4];     /* enough for all used fopen() modes: rb/rb+/wb+ */
 	Uint32 Basepage;
 	FILE *FileHandle;
+	int LastOp;         /* FH_OP_xxx */
 	/* TODO: host path might not fit into this */
 	char szActualName[MAX_GEMDOS_PATH];        /* used by F_DATIME (0x57) */
 } FILE_HANDLE;
@@ -146,12 +155,33 @@ typedef struct
 	Uint32 addr;                        /* ST-RAM DTA address for matching reused entries */
 	int  nentries;                      /* number of entries in fs directory */
 	int  centry;                        /* current entry # */
-	struct dirent **found;              /* legal files */
+	char **found;                       /* legal files */
 	char path[MAX_GEMDOS_PATH];                /* sfirst path */
 } INTERNAL_DTA;
 
+/* Cache of host directories contents, so that matching each component of
+ * a TOS path (and Fsfirst) doesn't need to read the host directory again.
+ * An entry is valid as long as the directory's modification time doesn't
+ * change, and it's also invalidated by our own create/delete/rename calls.
+ */
+#define DIR_CACHE_SIZE 32
+typedef struct
+{
+	char *path;                         /* host directory, NULL if unused */
+	dev_t dev;
+	ino_t ino;
+	time_t mtime;                       /* directory modification time when read */
+	bool stable;                        /* false if read during the second it was modified */
+	int count;                          /* number of entries */
+	char **names;                       /* host names, in readdir() order */
+	char **sorted;                      /* same names in alphasort() order, or NULL */
+	Uint32 lastuse;
+} DIR_CACHE;
+
 static FILE_HANDLE  FileHandles[MAX_FILE_HANDLES];
 static INTERNAL_DTA *InternalDTAs;
+static DIR_CACHE DirCache[DIR_CACHE_SIZE];
+static Uint32 DirCacheUse;  /* Counter to find the least recently used cache entry */
 static int DTACount;        /* Current DTA cache size */
 static Uint16 DTAIndex;     /* Circular index into above */
 static Uint16 CurrentDrive; /* Current drive (0=A,1=B,2=C etc...) */
@@ -201,6 +231,59 @@ static void GemDOS_DateTime2Tos(time_t t, DATETIME *DateTime, const char *fname)
 		| (((x->tm_year-80 > 0) ? x->tm_year-80 : 0) << 9);
 }
 
+/*-----------------------------------------------------------------------*/
+/**
+ * Drop the data stdio has read ahead for other handles to the same
+ * host file as given internal file handle, after it has been written
+ * to, so that their next read sees the new file contents
+ */
+static void GemDOS_DropStaleReads(int i)
+{
+	struct stat written, filestat;
+	int j;
+
+	if (fstat(fileno(FileHandles[i].FileHandle), &written) != 0)
+		return;
+
+	for (j = 0; j < ARRAY_SIZE(FileHandles); j++)
+	{
+		if (j == i || !FileHandles[j].bUsed ||
+		    FileHandles[j].LastOp != FH_OP_READ)
+			continue;
+		if (fstat(fileno(FileHandles[j].FileHandle), &filestat) != 0 ||
+		    filestat.st_dev != written.st_dev ||
+		    filestat.st_ino != written.st_ino)
+			continue;
+		/* seeking to current position discards read-ahead buffer */
+		fseeko(FileHandles[j].FileHandle, 0, SEEK_CUR);
+		FileHandles[j].LastOp = FH_OP_NONE;
+	}
+}
+
+/**
+ * Write data buffered for given internal file handle to the host file
+ */
+static void GemDOS_FlushFileHandle(int i)
+{
+	if (!FileHandles[i].bUsed || FileHandles[i].LastOp != FH_OP_WRITE)
+		return;
+	fflush(FileHandles[i].FileHandle);
+	FileHandles[i].LastOp = FH_OP_NONE;
+	GemDOS_DropStaleReads(i);
+}
+
+/**
+ * Write data buffered for all file handles to the host files, so that
+ * they're up to date before accessing the host file system by name
+ */
+static void GemDOS_FlushAllFileHandles(void)
+{
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(FileHandles); i++)
+		GemDOS_FlushFileHandle(i);
+}
+
 /*-----------------------------------------------------------------------*/
 /**
  * Populate a DATETIME structure with file info.  Handle needs to be
@@ -234,7 +317,7 @@ static bool GemDOS_SetFileInformation(int Handle, DATETIME *DateTime)
 	/* make sure Hatari itself doesn't need to write/modify
 	 * the file after it's modification time is changed.
 	 */
-	fflush(FileHandles[Handle].FileHandle);
+	GemDOS_FlushFileHandle(Handle);
 
 	/* use host modification times instead of Atari ones? */
 	if (ConfigureParams.HardDisk.bGemdosHostTime)
@@ -298,7 +381,7 @@ static Uint8 GemDOS_ConvertAttribute(mode_t mode)
  * Populate the DTA buffer with file info.
  * @return   DTA_OK if entry is ok, DTA_SKIP if it should be skipped, DTA_ERR on errors
  */
-static dta_ret_t PopulateDTA(char *path, struct dirent *file, DTA *pDTA, Uint32 DTA_Gemdos)
+static dta_ret_t PopulateDTA(char *path, const char *name, DTA *pDTA, Uint32 DTA_Gemdos)
 {
 	/* TODO: host file path can be longer than MAX_GEMDOS_PATH */
 	char tempstr[MAX_GEMDOS_PATH];
@@ -307,7 +390,7 @@ static dta_ret_t PopulateDTA(char *path, struct dirent *file, DTA *pDTA, Uint32
 	int nFileAttr, nAttrMask;
 
 	if (snprintf(tempstr, sizeof(tempstr), "%s%c%s",
-	             path, PATHSEP, file->d_name) >= (int)sizeof(tempstr))
+	             path, PATHSEP, name) >= (int)sizeof(tempstr))
 	{
 		Log_Printf(LOG_ERROR, "PopulateDTA: path is too long.\n");
 		return DTA_ERR;
@@ -336,10 +419,10 @@ static dta_ret_t PopulateDTA(char *path, struct dirent *file, DTA *pDTA, Uint32
 	M68000_Flush_Data_Cache(DTA_Gemdos, sizeof(DTA));
 
 	/* convert to atari-style uppercase */
-	Str_Filename2TOSname(file->d_name, pDTA->dta_name);
+	Str_Filename2TOSname(name, pDTA->dta_name);
 #if DEBUG_PATTERN_MATCH
 	fprintf(stderr, "DEBUG: GEMDOS: host: %s -> GEMDOS: %s\n",
-		file->d_name, pDTA->dta_name);
+		name, pDTA->dta_name);
 #endif
 	do_put_mem_long(pDTA->dta_size, filestat.st_size);
 	do_put_mem_word(pDTA->dta_time, DateTime.timeword);
@@ -505,9 +588,13 @@ static const char* fsfirst_dirmask(const char *string)
 static void GemDOS_CloseFileHandle(int i)
 {
 	if (FileHandles[i].bUsed)
+	{
+		GemDOS_FlushFileHandle(i);
 		fclose(FileHandles[i].FileHandle);
+	}
 	FileHandles[i].FileHandle = NULL;
 	FileHandles[i].Basepage = 0;
+	FileHandles[i].LastOp = FH_OP_NONE;
 	FileHandles[i].bUsed = false;
 }
 
@@ -568,6 +655,209 @@ static void GemDOS_InitCurPaths(void)
 	}
 }
 
+/*-----------------------------------------------------------------------*/
+/**
+ * Free given host directory cache entry.
+ */
+static void GemDOS_DirCacheFree(DIR_CACHE *dc)
+{
+	int i;
+
+	for (i = 0; i < dc->count; i++)
+		free(dc->names[i]);
+	free(dc->names);
+	free(dc->sorted);
+	free(dc->path);
+	memset(dc, 0, sizeof(*dc));
+}
+
+/**
+ * Free all host directory cache entries.
+ */
+static void GemDOS_DirCacheClear(void)
+{
+	int i;
+
+	for (i = 0; i < DIR_CACHE_SIZE; i++)
+		GemDOS_DirCacheFree(&DirCache[i]);
+	DirCacheUse = 0;
+}
+
+/**
+ * Return length of given host path without its trailing path separators,
+ * so that "dir" and "dir/" use the same cache entry.
+ */
+static int GemDOS_DirCachePathLen(const char *path)
+{
+	int len = strlen(path);
+
+	while (len > 1 && path[len-1] == PATHSEP)
+		len--;
+	return len;
+}
+
+/**
+ * Return true if cache entry is for given host path of given length
+ */
+static bool GemDOS_DirCacheMatch(DIR_CACHE *dc, const char *path, int len)
+{
+	return dc->path && strncmp(dc->path, path, len) == 0 && dc->path[len] == '\0';
+}
+
+/**
+ * Invalidate the cached contents of the directory containing given host
+ * file/directory (and of that directory itself) after it was created,
+ * deleted or renamed by the emulated program.
+ */
+static void GemDOS_DirCacheInvalidate(const char *path)
+{
+	int len = GemDOS_DirCachePathLen(path);
+	int parentlen = len;
+	int i;
+
+	/* find parent directory */
+	while (parentlen > 0 && path[parentlen-1] != PATHSEP)
+		parentlen--;
+	while (parentlen > 1 && path[parentlen-1] == PATHSEP)
+		parentlen--;
+
+	for (i = 0; i < DIR_CACHE_SIZE; i++)
+	{
+		if (GemDOS_DirCacheMatch(&DirCache[i], path, len)
+		    || (parentlen > 0 && GemDOS_DirCacheMatch(&DirCache[i], path, parentlen)))
+			GemDOS_DirCacheFree(&DirCache[i]);
+	}
+}
+
+/**
+ * Return cached contents of given host directory, reading it if the
+ * cache entry is missing or out of date.
+ * Return NULL if the directory can't be read.
+ */
+static DIR_CACHE *GemDOS_DirCacheGet(const char *path)
+{
+	struct stat dirstat;
+	struct dirent *entry;
+	DIR_CACHE *dc = NULL;
+	DIR *dir;
+	int i, size;
+	int len = GemDOS_DirCachePathLen(path);
+	bool error = false;
+
+	for (i = 0; i < DIR_CACHE_SIZE; i++)
+	{
+		if (GemDOS_DirCacheMatch(&DirCache[i], path, len))
+		{
+			dc = &DirCache[i];
+			break;
+		}
+	}
+
+	if (stat(path, &dirstat) != 0 || !S_ISDIR(dirstat.st_mode))
+	{
+		if (dc)
+			GemDOS_DirCacheFree(dc);
+		return NULL;
+	}
+
+	if (dc)
+	{
+		if (dc->stable && dc->mtime == dirstat.st_mtime
+		    && dc->dev == dirstat.st_dev && dc->ino == dirstat.st_ino)
+		{
+			dc->lastuse = ++DirCacheUse;
+			return dc;
+		}
+		GemDOS_DirCacheFree(dc);
+	}
+	else
+	{
+		/* use a free entry, or the least recently used one */
+		dc = &DirCache[0];
+		for (i = 0; i < DIR_CACHE_SIZE && dc->path; i++)
+		{
+			if (!DirCache[i].path || DirCache[i].lastuse < dc->lastuse)
+				dc = &DirCache[i];
+		}
+		GemDOS_DirCacheFree(dc);
+	}
+
+	dir = opendir(path);
+	if (!dir)
+		return NULL;
+
+	dc->path = malloc(len + 1);
+	error = !dc->path;
+	if (dc->path)
+	{
+		memcpy(dc->path, path, len);
+		dc->path[len] = '\0';
+	}
+	size = 0;
+	while (!error && (entry = readdir(dir)))
+	{
+		char *d_name = entry->d_name;
+		Str_DecomposedToPrecomposedUtf8(d_name, d_name);   /* for OSX */
+		if (dc->count >= size)
+		{
+			char **names;
+			size = size ? 2 * size : 64;
+			names = realloc(dc->names, size * sizeof(char *));
+			if (!names)
+			{
+				error = true;
+				break;
+			}
+			dc->names = names;
+		}
+		dc->names[dc->count] = strdup(d_name);
+		if (!dc->names[dc->count])
+		{
+			error = true;
+			break;
+		}
+		dc->count++;
+	}
+	closedir(dir);
+
+	if (error)
+	{
+		perror("GemDOS_DirCacheGet");
+		GemDOS_DirCacheFree(dc);
+		return NULL;
+	}
+
+	dc->dev = dirstat.st_dev;
+	dc->ino = dirstat.st_ino;
+	dc->mtime = dirstat.st_mtime;
+	/* Host changes done during the same second as the last one wouldn't
+	 * change the modification time, so such an entry is not reused */
+	dc->stable = time(NULL) > dirstat.st_mtime;
+	dc->lastuse = ++DirCacheUse;
+	return dc;
+}
+
+static int DirCache_CompareNames(const void *n1, const void *n2)
+{
+	return strcoll(*(char * const *)n1, *(char * const *)n2);
+}
+
+/**
+ * Return names of cached directory in alphasort() order, or NULL on error
+ */
+static char **GemDOS_DirCacheSorted(DIR_CACHE *dc)
+{
+	if (!dc->sorted && dc->count > 0)
+	{
+		dc->sorted = malloc(dc->count * sizeof(char *));
+		if (!dc->sorted)
+			return NULL;
+		memcpy(dc->sorted, dc->names, dc->count * sizeof(char *));
+		qsort(dc->sorted, dc->count, sizeof(char *), DirCache_CompareNames);
+	}
+	return dc->sorted;
+}
+
 /*-----------------------------------------------------------------------*/
 /**
  * Reset GemDOS file system
@@ -576,6 +866,7 @@ void GemDOS_Reset(void)
 {
 	GemDOS_Init();
 	GemDOS_InitCurPaths();
+	GemDOS_DirCacheClear();
 
 	/* Reset */
 	act_pd = 0;
@@ -846,6 +1137,7 @@ static void save_file_handle_info(FILE_HANDLE *handle)
 	MemorySnapShot_Store(&handle->szActualName, sizeof(handle->szActualName));
 	if (handle->bUsed)
 	{
+		GemDOS_FlushFileHandle(handle - FileHandles);
 		offset = ftello(handle->FileHandle);
 		stat(handle->szActualName, &fstat);
 		mtime = fstat.st_mtime; /* modification time */
@@ -903,6 +1195,7 @@ static void restore_file_handle_info(int i, FILE_HANDLE *handle)
 			   i, handle->szActualName);
 	}
 	fp = fopen(handle->szActualName, handle->szMode);
+	handle->LastOp = FH_OP_NONE;
 	if (fp == NULL || fseeko(fp, offset, SEEK_SET) != 0)
 	{
 		handle->bUsed = false;
@@ -1150,16 +1443,16 @@ static int GemDOS_FileName2HardDriveID(char *pszFileName)
 static char* match_host_dir_entry(const char *path, const char *name, bool pattern)
 {
 #define MAX_UTF8_NAME_LEN (3*(8+1+3)+1) /* UTF-8 can have up to 3 bytes per character */
-	struct dirent *entry;
+	DIR_CACHE *dc;
 	char *match = NULL;
-	DIR *dir;
 	char nameHost[MAX_UTF8_NAME_LEN];
+	int i;
 
 	Str_AtariToHost(name, nameHost, MAX_UTF8_NAME_LEN, INVALID_CHAR);
 	name = nameHost;
 	
-	dir = opendir(path);
-	if (!dir)
+	dc = GemDOS_DirCacheGet(path);
+	if (!dc)
 		return NULL;
 
 #if DEBUG_PATTERN_MATCH
@@ -1167,31 +1460,26 @@ static char* match_host_dir_entry(const char *path, const char *name, bool patte
 #endif
 	if (pattern)
 	{
-		while ((entry = readdir(dir)))
+		for (i = 0; i < dc->count; i++)
 		{
-			char *d_name = entry->d_name;
-			Str_DecomposedToPrecomposedUtf8(d_name, d_name);   /* for OSX */
-			if (fsfirst_match(name, d_name))
+			if (fsfirst_match(name, dc->names[i]))
 			{
-				match = strdup(d_name);
+				match = strdup(dc->names[i]);
 				break;
 			}
 		}
 	}
 	else
 	{
-		while ((entry = readdir(dir)))
+		for (i = 0; i < dc->count; i++)
 		{
-			char *d_name = entry->d_name;
-			Str_DecomposedToPrecomposedUtf8(d_name, d_name);   /* for OSX */
-			if (strcasecmp(name, d_name) == 0)
+			if (strcasecmp(name, dc->names[i]) == 0)
 			{
-				match = strdup(d_name);
+				match = strdup(dc->names[i]);
 				break;
 			}
 		}
 	}
-	closedir(dir);
 #if DEBUG_PATTERN_MATCH
 	fprintf(stderr, "-> '%s'\n", match);
 #endif
@@ -1421,6 +1709,10 @@ void GemDOS_CreateHardDriveFileName(int Drive, const char *pszFileName,
 	 * destination string (it always null terminates unlike strncpy()) */
 	*pszDestName = 0;
 
+	/* host file is going to be accessed by name, so data written
+	 * through the file handles needs to be there */
+	GemDOS_FlushAllFileHandles();
+
 	/* Is it a valid hard drive? */
 	assert(GemDOS_IsDriveEmulated(Drive));
 
@@ -1783,6 +2075,7 @@ static bool GemDOS_MkDir(Uint32 Params)
 	GemDOS_CreateHardDriveFileName(Drive, pDirName, psDirPath, FILENAME_MAX);
 	
 	/* Attempt to make directory */
+	GemDOS_DirCacheInvalidate(psDirPath);
 	if (mkdir(psDirPath, 0755) == 0)
 		Regs[REG_D0] = GEMDOS_EOK;
 	else
@@ -1841,6 +2134,7 @@ static bool GemDOS_RmDir(Uint32 Params)
 	GemDOS_CreateHardDriveFileName(Drive, pDirName, psDirPath, FILENAME_MAX);
 
 	/* Attempt to remove directory */
+	GemDOS_DirCacheInvalidate(psDirPath);
 	if (rmdir(psDirPath) == 0)
 		Regs[REG_D0] = GEMDOS_EOK;
 	else
@@ -2025,6 +2319,7 @@ static bool GemDOS_Create(Uint32 Params)
 	}
 	
 	/* truncate and open for reading & writing */
+	GemDOS_DirCacheInvalidate(szActualFileName);
 	FileHandles[Index].FileHandle = fopen(szActualFileName, "wb+");
 
 	if (FileHandles[Index].FileHandle != NULL)
@@ -2282,6 +2577,8 @@ static bool GemDOS_Read(Uint32 Params)
 	Uint32 Addr;
 	Uint32 Size;
 	int Handle;
+	FILE *fp;
+	struct stat filestat;
 
 	/* Read details from stack */
 	Handle = STMemory_ReadWord(Params);
@@ -2307,21 +2604,22 @@ static bool GemDOS_Read(Uint32 Params)
 		return true;
 	}
 	
-	/* To quick check to see where our file pointer is and how large the file is */
-	CurrentPos = ftello(FileHandles[Handle].FileHandle);
-	if (CurrentPos == -1L
-	    || fseeko(FileHandles[Handle].FileHandle, 0, SEEK_END) != 0)
-	{
-		Regs[REG_D0] = GEMDOS_E_SEEK;
-		return true;
-	}
-	FileSize = ftello(FileHandles[Handle].FileHandle);
-	if (FileSize == -1L
-	    || fseeko(FileHandles[Handle].FileHandle, CurrentPos, SEEK_SET) != 0)
+	/* Data written through any handle must be flushed before reading
+	 * (file may be open through several handles), and before checking
+	 * the file size */
+	fp = FileHandles[Handle].FileHandle;
+	GemDOS_FlushAllFileHandles();
+
+	/* To quick check to see where our file pointer is and how large the file is.
+	 * Don't seek to the end of file for this, as it would discard the data
+	 * already read ahead by stdio for the next small Fread() calls. */
+	CurrentPos = ftello(fp);
+	if (CurrentPos == -1L || fstat(fileno(fp), &filestat) != 0)
 	{
 		Regs[REG_D0] = GEMDOS_E_SEEK;
 		return true;
 	}
+	FileSize = filestat.st_size;
 
 	nBytesLeft = FileSize-CurrentPos;
 
@@ -2350,15 +2648,16 @@ static bool GemDOS_Read(Uint32 Params)
 
 	/* And read data in */
 	pBuffer = (char *)STMemory_STAddrToPointer(Addr);
-	nBytesRead = fread(pBuffer, 1, Size, FileHandles[Handle].FileHandle);
-	
-	if (ferror(FileHandles[Handle].FileHandle))
+	nBytesRead = fread(pBuffer, 1, Size, fp);
+	FileHandles[Handle].LastOp = FH_OP_READ;
+
+	if (ferror(fp))
 	{
 		int errnum = errno;
 		Log_Printf(LOG_WARN, "GEMDOS failed to read from '%s': %s\n",
 			   FileHandles[Handle].szActualName, strerror(errno));
 		Regs[REG_D0] = errno2gemdos(errnum, ERROR_FILE);
-		clearerr(FileHandles[Handle].FileHandle);
+		clearerr(fp);
 	}
 	else
 		/* Return number of bytes read */
@@ -2421,6 +2720,10 @@ static bool GemDOS_Write(Uint32 Params)
 		return true;
 	}
 
+	/* Switching from reading to writing requires a seek in between */
+	if (fh_idx >= 0 && FileHandles[fh_idx].LastOp == FH_OP_READ)
+		fseeko(fp, 0, SEEK_CUR);
+
 	pBuffer = (char *)STMemory_STAddrToPointer(Addr);
 	nBytesWritten = fwrite(pBuffer, 1, Size, fp);
 	if (fh_idx >= 0 && ferror(fp))
@@ -2430,10 +2733,18 @@ static bool GemDOS_Write(Uint32 Params)
 			   FileHandles[fh_idx].szActualName);
 		Regs[REG_D0] = errno2gemdos(errnum, ERROR_FILE);
 		clearerr(fp);
+		FileHandles[fh_idx].LastOp = FH_OP_NONE;
 	}
 	else
 	{
-		fflush(fp);
+		/* Data written to files is kept in the stdio buffer, so that
+		 * small writes are coalesced.  It's flushed on Fclose(),
+		 * Fseek(), Fread(), Pterm(), snapshots and before any GEMDOS
+		 * call accessing host files by name */
+		if (fh_idx >= 0)
+			FileHandles[fh_idx].LastOp = FH_OP_WRITE;
+		else
+			fflush(fp);
 		Regs[REG_D0] = nBytesWritten;      /* OK */
 	}
 	return true;
@@ -2490,6 +2801,7 @@ static bool GemDOS_FDelete(Uint32 Params)
 	GemDOS_CreateHardDriveFileName(Drive, pszFileName, psActualFileName, FILENAME_MAX);
 
 	/* Now delete file?? */
+	GemDOS_DirCacheInvalidate(psActualFileName);
 	if (unlink(psActualFileName) == 0)
 		Regs[REG_D0] = GEMDOS_EOK;          /* OK */
 	else
@@ -2512,6 +2824,7 @@ static bool GemDOS_LSeek(Uint32 Params)
 	long nFileSize;
 	long nOldPos, nDestPos;
 	FILE *fhndl;
+	struct stat filestat;
 
 	/* Read details from stack */
 	Offset = (Sint32)STMemory_ReadLong(Params);
@@ -2529,17 +2842,19 @@ static bool GemDOS_LSeek(Uint32 Params)
 	}
 
 	fhndl = FileHandles[Handle].FileHandle;
+	GemDOS_FlushFileHandle(Handle);
 
 	/* Save old position in file */
 	nOldPos = ftell(fhndl);
 
-	/* Determine the size of the file */
-	if (fseek(fhndl, 0L, SEEK_END) != 0 || nOldPos < 0)
+	/* Determine the size of the file (without seeking to its end,
+	 * which would discard the data read ahead by stdio) */
+	if (nOldPos < 0 || fstat(fileno(fhndl), &filestat) != 0)
 	{
 		Regs[REG_D0] = GEMDOS_E_SEEK;
 		return true;
 	}
-	nFileSize = ftell(fhndl);
+	nFileSize = filestat.st_size;
 
 	switch (Mode)
 	{
@@ -2554,6 +2869,7 @@ static bool GemDOS_LSeek(Uint32 Params)
 		/* Restore old position and return error */
 		if (fseek(fhndl, nOldPos, SEEK_SET) != 0)
 			perror("GemDOS_LSeek");
+		FileHandles[Handle].LastOp = FH_OP_NONE;
 		Regs[REG_D0] = GEMDOS_ERANGE;
 		return true;
 	}
@@ -2561,6 +2877,7 @@ static bool GemDOS_LSeek(Uint32 Params)
 	/* Seek to new position and return offset from start of file */
 	if (fseek(fhndl, nDestPos, SEEK_SET) != 0)
 		perror("GemDOS_LSeek");
+	FileHandles[Handle].LastOp = FH_OP_NONE;
 	Regs[REG_D0] = ftell(fhndl);
 
 	return true;
@@ -2887,7 +3204,7 @@ static int GemDOS_Pexec(Uint32 Params)
  */
 static bool GemDOS_SNext(void)
 {
-	struct dirent **temp;
+	char **temp;
 	int ret;
 	DTA *pDTA;
 	Uint32 DTA_Gemdos;
@@ -2973,10 +3290,10 @@ static bool GemDOS_SFirst(Uint32 Params)
 	char szActualFileName[MAX_GEMDOS_PATH];
 	char *pszFileName;
 	const char *dirmask;
-	struct dirent **files;
+	char **files, **sorted;
+	DIR_CACHE *dc;
 	int Drive;
-	DIR *fsdir;
-	int i, j, count;
+	int i, j;
 	DTA *pDTA;
 	Uint32 DTA_Gemdos;
 	Uint16 useidx;
@@ -3059,20 +3376,20 @@ static bool GemDOS_SFirst(Uint32 Params)
 	 * TODO: host path may not fit into InternalDTA
 	 */
 	fsfirst_dirname(szActualFileName, InternalDTAs[useidx].path);
-	fsdir = opendir(InternalDTAs[useidx].path);
+	dc = GemDOS_DirCacheGet(InternalDTAs[useidx].path);
 
-	if (fsdir == NULL)
+	if (dc == NULL)
 	{
 		Regs[REG_D0] = GEMDOS_EPTHNF;        /* Path not found */
 		return true;
 	}
-	/* close directory */
-	closedir(fsdir);
 
-	count = scandir(InternalDTAs[useidx].path, &files, 0, alphasort);
-	/* File (directory actually) not found */
-	if (count < 0)
+	/* directory entries sorted like scandir(..., alphasort) does */
+	sorted = GemDOS_DirCacheSorted(dc);
+	files = malloc((dc->count + 1) * sizeof(char *));
+	if ((!sorted && dc->count > 0) || !files)
 	{
+		free(files);
 		Regs[REG_D0] = GEMDOS_EFILNF;
 		return true;
 	}
@@ -3081,21 +3398,15 @@ static bool GemDOS_SFirst(Uint32 Params)
 	dirmask = fsfirst_dirmask(szActualFileName);/* directory mask part */
 	InternalDTAs[useidx].found = files;       /* get files */
 
-	/* count & copy the entries that match our mask and discard the rest */
+	/* count & copy the entries that match our mask */
 	j = 0;
-	for (i=0; i < count; i++)
+	for (i=0; i < dc->count; i++)
 	{
-		char *d_name = files[i]->d_name;
-		Str_DecomposedToPrecomposedUtf8(d_name, d_name);   /* for OSX */
-		if (fsfirst_match(dirmask, d_name))
-		{
-			InternalDTAs[useidx].found[j] = files[i];
-			j++;
-		}
-		else
+		if (fsfirst_match(dirmask, sorted[i]))
 		{
-			free(files[i]);
-			files[i] = NULL;
+			files[j] = strdup(sorted[i]);
+			if (files[j])
+				j++;
 		}
 	}
 	InternalDTAs[useidx].nentries = j; /* set number of legal entries */
@@ -3196,6 +3507,8 @@ static bool GemDOS_Rename(Uint32 Params)
 		              szOldActualFileName, sizeof(szOldActualFileName));
 
 	/* Rename files */
+	GemDOS_DirCacheInvalidate(szOldActualFileName);
+	GemDOS_DirCacheInvalidate(szNewActualFileName);
 	if (rename(szOldActualFileName,szNewActualFileName) == 0)
 		Regs[REG_D0] = GEMDOS_EOK;
 	else
@@ -3881,7 +4194,7 @@ void GemDOS_Info(FILE *fp, Uint32 bShowOpcodes)
 		for (j = 0; j < entries; j++)
 		{
 			fprintf(fp, "  - %d: %s%s\n",
-				j, InternalDTAs[i].found[j]->d_name,
+				j, InternalDTAs[i].found[j],
 				j == centry ? " *" : "");
 		}
 		fprintf(fp, "  Fsnext entry = %d.\n", centry);
@@ -4228,7 +4541,7 @@ void GemDOS_Boot(void)
 	 */
 	if (!GEMDOS_EMU_ON &&
 	    !INF_Overriding(AUTOSTART_INTERCEPT) &&
-	    !LOG_TRACE_LEVEL(TRACE_OS_GEMDOS|TRACE_OS_BASE))
+	    !(LogTraceFlags & (TRACE_OS_GEMDOS|TRACE_OS_BASE)))
 		return;
 
 	/* Get the address of the p_run variable that points to the actual basepage */
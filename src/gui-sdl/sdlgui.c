@@ -1397,6 +1397,12 @@ int SDLGui_DoDialogExt(SGOBJ *dlg, bool (*isEventOut)(SDL_EventType), SDL_Event
 				}
 				break;
 
+			 case SDL_RENDER_TARGETS_RESET:
+			 case SDL_RENDER_DEVICE_RESET:
+				Screen_SetTextureFullUpdate(sdlEvent.type == SDL_RENDER_DEVICE_RESET);
+				SDL_UpdateRect(pSdlGuiScrn, 0, 0, 0, 0);
+				break;
+
 			 default:
 				retbutton = SDLGUI_UNKNOWNEVENT;
 				break;
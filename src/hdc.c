@@ -9,11 +9,15 @@
 const char HDC_fileid[] = "Hatari hdc.c";
 
 #include <errno.h>
+#include <SDL.h>
 #include <SDL_endian.h>
 
 #include "main.h"
 #include "configuration.h"
+#include "cycles.h"
+#include "cycInt.h"
 #include "debugui.h"
+#include "diskOverlay.h"
 #include "file.h"
 #include "fdc.h"
 #include "hdc.h"
@@ -26,6 +30,10 @@ const char HDC_fileid[] = "Hatari hdc.c";
 #include "tos.h"
 #include "statusbar.h"
 
+#if HAVE_MMAP
+#include <sys/mman.h>
+#endif
+
 
 /*
   ACSI emulation: 
@@ -36,9 +44,11 @@ const char HDC_fileid[] = "Hatari hdc.c";
   operation interrupts the current operation. The DRQ status can
   be polled non-destructively in GPIP.
 
-  (For simplicity, the operation is finished immediately,
-  this is a potential bug, but I doubt it is significant,
-  we just appear to have a very fast hard drive.)
+  (For simplicity, other commands are finished immediately, we
+  just appear to have a very fast hard drive.  READ and WRITE
+  commands complete after an emulated transfer time, while the
+  host I/O runs in a separate thread meanwhile, so that a slow
+  host disk does not stall the emulation.)
 
   The ACSI command set is a subset of the SCSI standard.
   (for details, see the X3T9.2 SCSI draft documents
@@ -58,6 +68,18 @@ static SCSI_CTRLR AcsiBus;
 int nAcsiPartitions;
 bool bAcsiEmuOn;
 
+/* Disk I/O thread and its job queue */
+#define HDC_IO_QUEUE_SIZE 4
+static SDL_Thread *pIoThread;
+static SDL_mutex *pIoMutex;
+static SDL_cond *pIoQueued;
+static SDL_cond *pIoDone;
+static HDC_IO_JOB *IoQueue[HDC_IO_QUEUE_SIZE];
+static int nIoQueueHead;
+static int nIoQueueCount;
+static bool bIoQuit;
+static bool bIoThreadFailed;
+
 /* Our dummy INQUIRY response data */
 static unsigned char inquiry_bytes[] =
 {
@@ -147,6 +169,7 @@ static Uint8 *HDC_PrepRespBuf(SCSI_CTRLR *ctr, int size)
 		ctr->buffer_size = size;
 		ctr->buffer = realloc(ctr->buffer, size);
 	}
+	ctr->data = ctr->buffer;
 
 	return ctr->buffer;
 }
@@ -528,6 +551,11 @@ static void HDC_Cmd_WriteSector(SCSI_CTRLR *ctr)
 		ctr->status = HD_STATUS_ERROR;
 		dev->nLastError = HD_REQSENS_INVADDR;
 	}
+	else if (dev->image_map && dev->nLastBlockAddr + HDC_GetCount(ctr) > dev->hdSize)
+	{
+		ctr->status = HD_STATUS_ERROR;
+		dev->nLastError = HD_REQSENS_NOSECTOR;
+	}
 	else
 	{
 		ctr->data_len = HDC_GetCount(ctr) * dev->blockSize;
@@ -535,6 +563,10 @@ static void HDC_Cmd_WriteSector(SCSI_CTRLR *ctr)
 		{
 			HDC_PrepRespBuf(ctr, ctr->data_len);
 			ctr->dmawrite_to_fh = dev->image_file;
+			/* with a writable mapping, data goes directly to the image */
+			if (dev->image_map && dev->image_map_writable)
+				ctr->dmawrite_to_map = dev->image_map + (size_t)dev->nLastBlockAddr * dev->blockSize;
+			ctr->io_cycles = HDC_IO_CYCLES(ctr->data_len);
 			ctr->status = HD_STATUS_OK;
 			dev->nLastError = HD_REQSENS_OK;
 		}
@@ -552,41 +584,90 @@ static void HDC_Cmd_WriteSector(SCSI_CTRLR *ctr)
 }
 
 
+/**
+ * I/O thread job: read the sectors of the current READ command to the
+ * response buffer, or just fault in the image mapping pages which the
+ * DMA is going to transfer directly from.
+ */
+static int HDC_IoReadSectors(void *arg)
+{
+	SCSI_CTRLR *ctr = arg;
+	SCSI_DEV *dev = ctr->io_dev;
+	int count = ctr->io_len / dev->blockSize;
+	const volatile Uint8 *map = ctr->io_map;
+	int i;
+
+	if (!ctr->io_buf)
+	{
+		for (i = 0; i < ctr->io_len; i += 4096)
+			(void)map[i];
+		return HD_REQSENS_OK;
+	}
+
+	if (ctr->io_map)
+		memcpy(ctr->io_buf, ctr->io_map, ctr->io_len);
+	else if (fread(ctr->io_buf, dev->blockSize, count, dev->image_file) != (size_t)count)
+		return HD_REQSENS_NOSECTOR;
+
+	/* overlay blocks replace the base image ones */
+	if (!DiskOverlay_Read(dev->overlay, dev->nLastBlockAddr, count, ctr->io_buf))
+		return HD_REQSENS_NOSECTOR;
+	return HD_REQSENS_OK;
+}
+
+
 /**
  * Read a sector off our disk - (implied seek)
  */
 static void HDC_Cmd_ReadSector(SCSI_CTRLR *ctr)
 {
 	SCSI_DEV *dev = &ctr->devs[ctr->target];
-	Uint8 *buf;
-	int n;
+	int count;
 
 	dev->nLastBlockAddr = HDC_GetLBA(ctr);
+	count = HDC_GetCount(ctr);
 
 	LOG_TRACE(TRACE_SCSI_CMD, "HDC: READ SECTOR (%s) with LBA 0x%x",
 	          HDC_CmdInfoStr(ctr), dev->nLastBlockAddr);
 
 	/* seek to the position */
-	if (dev->nLastBlockAddr >= dev->hdSize ||
-	    fseeko(dev->image_file, (off_t)dev->nLastBlockAddr * dev->blockSize, SEEK_SET) != 0)
+	if (dev->nLastBlockAddr >= dev->hdSize || (!dev->image_map &&
+	    fseeko(dev->image_file, (off_t)dev->nLastBlockAddr * dev->blockSize, SEEK_SET) != 0))
 	{
 		ctr->status = HD_STATUS_ERROR;
 		dev->nLastError = HD_REQSENS_INVADDR;
 	}
+	else if (dev->image_map && dev->nLastBlockAddr + count > dev->hdSize)
+	{
+		ctr->status = HD_STATUS_ERROR;
+		dev->nLastError = HD_REQSENS_NOSECTOR;
+	}
 	else
 	{
-		buf = HDC_PrepRespBuf(ctr, dev->blockSize * HDC_GetCount(ctr));
-		n = fread(buf, dev->blockSize, HDC_GetCount(ctr), dev->image_file);
-		if (n == HDC_GetCount(ctr))
+		ctr->io_dev = dev;
+		ctr->io_len = dev->blockSize * count;
+		ctr->io_map = NULL;
+		if (dev->image_map)
+			ctr->io_map = dev->image_map + (size_t)dev->nLastBlockAddr * dev->blockSize;
+
+		if (ctr->io_map && !DiskOverlay_HasBlocks(dev->overlay, dev->nLastBlockAddr, count))
 		{
-			ctr->status = HD_STATUS_OK;
-			dev->nLastError = HD_REQSENS_OK;
+			/* No copy needed, DMA transfers directly from the mapping */
+			ctr->data = ctr->io_map;
+			ctr->data_len = ctr->io_len;
+			ctr->offset = 0;
+			ctr->io_buf = NULL;
 		}
 		else
 		{
-			ctr->status = HD_STATUS_ERROR;
-			dev->nLastError = HD_REQSENS_NOSECTOR;
+			ctr->io_buf = HDC_PrepRespBuf(ctr, ctr->io_len);
 		}
+		/* the data is ready when HDC_CompleteIo() returns */
+		ctr->io_cycles = HDC_IO_CYCLES(ctr->io_len);
+		HDC_IoStart(&ctr->io, HDC_IoReadSectors, ctr);
+
+		ctr->status = HD_STATUS_OK;
+		dev->nLastError = HD_REQSENS_OK;
 	}
 	LOG_TRACE(TRACE_SCSI_CMD, " -> %s (%d)\n",
 		  ctr->status == HD_STATUS_OK ? "OK" : "ERROR",
@@ -613,7 +694,13 @@ static void HDC_EmulateCommandPacket(SCSI_CTRLR *ctr)
 {
 	SCSI_DEV *dev = &ctr->devs[ctr->target];
 
+	/* previous command's I/O must be done before buffers are reused */
+	HDC_CompleteIo(ctr);
+
 	ctr->data_len = 0;
+	ctr->data = ctr->buffer;
+	ctr->dmawrite_to_map = NULL;
+	ctr->io_cycles = 0;
 
 	switch (ctr->opcode)
 	{
@@ -875,6 +962,273 @@ off_t HDC_CheckAndGetSize(const char *hdtype, const char *filename, unsigned lon
 	return filesize;
 }
 
+/**
+ * Map the whole image file into memory so that sectors can be transferred
+ * without seeking and copying through stdio buffers.
+ * Return pointer to the mapping, or NULL if mapping is not possible,
+ * in which case callers fall back to normal file I/O.
+ */
+Uint8 *HDC_MapImage(FILE *fp, off_t size, bool writable)
+{
+#if HAVE_MMAP
+	void *map;
+
+	if (size <= 0 || (Uint64)size > SIZE_MAX)
+		return NULL;
+
+	fflush(fp);
+	map = mmap(NULL, (size_t)size, writable ? PROT_READ | PROT_WRITE : PROT_READ,
+	           MAP_SHARED, fileno(fp), 0);
+	if (map == MAP_FAILED)
+	{
+		Log_Printf(LOG_WARN, "Mapping HD image failed (%s), using file I/O instead.\n",
+		           strerror(errno));
+		return NULL;
+	}
+	return map;
+#else
+	return NULL;
+#endif
+}
+
+/**
+ * Write modified pages of an image mapping back to the file
+ */
+void HDC_SyncImage(Uint8 *map, off_t size)
+{
+#if HAVE_MMAP
+	if (map && msync(map, (size_t)size, MS_SYNC) != 0)
+		perror("HDC_SyncImage");
+#endif
+}
+
+/**
+ * Sync and remove an image mapping
+ */
+void HDC_UnmapImage(Uint8 *map, off_t size)
+{
+#if HAVE_MMAP
+	if (!map)
+		return;
+	HDC_SyncImage(map, size);
+	munmap(map, (size_t)size);
+#endif
+}
+
+/**
+ * I/O thread job: write data of the current WRITE command to the disk
+ * image overlay, through the image mapping or to the image file.
+ */
+static int HDC_IoWriteSectors(void *arg)
+{
+	SCSI_CTRLR *ctr = arg;
+	SCSI_DEV *dev = ctr->io_dev;
+
+	if (dev->overlay)
+	{
+		if (!DiskOverlay_Write(dev->overlay, dev->nLastBlockAddr,
+		                       ctr->io_len / dev->blockSize, ctr->io_buf))
+			return HD_REQSENS_WRITEERR;
+	}
+	else if (ctr->io_map)
+	{
+		memcpy(ctr->io_map, ctr->io_buf, ctr->io_len);
+	}
+	else if (fwrite(ctr->io_buf, 1, ctr->io_len, dev->image_file) != (size_t)ctr->io_len)
+	{
+		return HD_REQSENS_WRITEERR;
+	}
+	return HD_REQSENS_OK;
+}
+
+/**
+ * Start writing data of the current WRITE command to the disk image
+ * in the I/O thread.  HDC_CompleteIo() tells whether it succeeded.
+ */
+void HDC_WriteImageData(SCSI_CTRLR *ctr, const Uint8 *src, int len)
+{
+	if (src != ctr->buffer)
+		memcpy(ctr->buffer, src, len);
+	ctr->io_dev = &ctr->devs[ctr->target];
+	ctr->io_buf = ctr->buffer;
+	ctr->io_map = ctr->dmawrite_to_map;
+	ctr->io_len = len;
+	ctr->dmawrite_to_map = NULL;
+	HDC_IoStart(&ctr->io, HDC_IoWriteSectors, ctr);
+}
+
+/**
+ * Wait until the host I/O of the current READ/WRITE command is done,
+ * and set the command status accordingly.
+ * Return false if the I/O failed.
+ */
+bool HDC_CompleteIo(SCSI_CTRLR *ctr)
+{
+	int err = HDC_IoFinish(&ctr->io);
+
+	if (err == HD_REQSENS_OK)
+		return true;
+
+	Log_Printf(LOG_ERROR, "HDC: %s image I/O failed at LBA 0x%x.\n",
+	           ctr->typestr, ctr->io_dev->nLastBlockAddr);
+	ctr->status = HD_STATUS_ERROR;
+	ctr->io_dev->nLastError = err;
+	return false;
+}
+
+
+/*---------------------------------------------------------------------*/
+/**
+ * Disk I/O thread: run queued jobs in order until asked to quit.
+ */
+static int HDC_IoThread(void *unused)
+{
+	HDC_IO_JOB *job;
+	int result;
+
+	SDL_LockMutex(pIoMutex);
+	for (;;)
+	{
+		while (nIoQueueCount == 0 && !bIoQuit)
+			SDL_CondWait(pIoQueued, pIoMutex);
+		if (nIoQueueCount == 0)
+			break;
+		job = IoQueue[nIoQueueHead];
+
+		SDL_UnlockMutex(pIoMutex);
+		result = job->func(job->arg);
+		SDL_LockMutex(pIoMutex);
+
+		job->result = result;
+		job->pending = false;
+		nIoQueueHead = (nIoQueueHead + 1) % HDC_IO_QUEUE_SIZE;
+		nIoQueueCount--;
+		SDL_CondBroadcast(pIoDone);
+	}
+	SDL_UnlockMutex(pIoMutex);
+	return 0;
+}
+
+/**
+ * Create the disk I/O thread on first use.
+ * Return false if that fails (it's tried only once).
+ */
+static bool HDC_IoInitThread(void)
+{
+	if (pIoThread)
+		return true;
+	if (bIoThreadFailed)
+		return false;
+
+	pIoMutex = SDL_CreateMutex();
+	pIoQueued = SDL_CreateCond();
+	pIoDone = SDL_CreateCond();
+	if (pIoMutex && pIoQueued && pIoDone)
+	{
+		bIoQuit = false;
+		pIoThread = SDL_CreateThread(HDC_IoThread, "Hatari disk I/O", NULL);
+	}
+	if (!pIoThread)
+	{
+		Log_Printf(LOG_WARN, "HDC: Could not create disk I/O thread, doing I/O synchronously: %s\n",
+		           SDL_GetError());
+		HDC_IoUnInit();
+		bIoThreadFailed = true;
+		return false;
+	}
+	return true;
+}
+
+/**
+ * Queue a job for the disk I/O thread.  A previous run of the same
+ * job is waited for first.  Without the thread, the job is run here.
+ */
+void HDC_IoStart(HDC_IO_JOB *job, int (*func)(void *arg), void *arg)
+{
+	HDC_IoFinish(job);
+
+	if (!HDC_IoInitThread())
+	{
+		job->result = func(arg);
+		return;
+	}
+
+	SDL_LockMutex(pIoMutex);
+	while (nIoQueueCount == HDC_IO_QUEUE_SIZE)
+		SDL_CondWait(pIoDone, pIoMutex);
+	job->func = func;
+	job->arg = arg;
+	job->pending = true;
+	IoQueue[(nIoQueueHead + nIoQueueCount) % HDC_IO_QUEUE_SIZE] = job;
+	nIoQueueCount++;
+	SDL_CondSignal(pIoQueued);
+	SDL_UnlockMutex(pIoMutex);
+}
+
+/**
+ * Wait until the given job is done (blocks only if the host I/O
+ * hasn't finished yet).  Return its result, which is then cleared.
+ */
+int HDC_IoFinish(HDC_IO_JOB *job)
+{
+	int result;
+
+	if (pIoThread)
+	{
+		SDL_LockMutex(pIoMutex);
+		while (job->pending)
+			SDL_CondWait(pIoDone, pIoMutex);
+		SDL_UnlockMutex(pIoMutex);
+	}
+	result = job->result;
+	job->result = 0;
+	return result;
+}
+
+/**
+ * Wait until all queued jobs are done
+ */
+void HDC_IoWaitAll(void)
+{
+	if (!pIoThread)
+		return;
+	SDL_LockMutex(pIoMutex);
+	while (nIoQueueCount)
+		SDL_CondWait(pIoDone, pIoMutex);
+	SDL_UnlockMutex(pIoMutex);
+}
+
+/**
+ * Let the disk I/O thread finish its queue and exit
+ */
+void HDC_IoUnInit(void)
+{
+	if (pIoThread)
+	{
+		SDL_LockMutex(pIoMutex);
+		bIoQuit = true;
+		SDL_CondSignal(pIoQueued);
+		SDL_UnlockMutex(pIoMutex);
+		SDL_WaitThread(pIoThread, NULL);
+		pIoThread = NULL;
+	}
+	if (pIoDone)
+	{
+		SDL_DestroyCond(pIoDone);
+		pIoDone = NULL;
+	}
+	if (pIoQueued)
+	{
+		SDL_DestroyCond(pIoQueued);
+		pIoQueued = NULL;
+	}
+	if (pIoMutex)
+	{
+		SDL_DestroyMutex(pIoMutex);
+		pIoMutex = NULL;
+	}
+}
+
 /**
  * Open a disk image file
  */
@@ -882,6 +1236,8 @@ int HDC_InitDevice(const char *hdtype, SCSI_DEV *dev, char *filename, unsigned l
 {
 	off_t filesize;
 	FILE *fp;
+	DISK_OVERLAY *overlay = NULL;
+	bool writable = true;
 
 	dev->enabled = false;
 	Log_Printf(LOG_INFO, "Mounting %s HD image '%s'\n", hdtype, filename);
@@ -891,7 +1247,24 @@ int HDC_InitDevice(const char *hdtype, SCSI_DEV *dev, char *filename, unsigned l
 	if (filesize < 0)
 		return filesize;
 
-	if (!(fp = fopen(filename, "rb+")))
+	if (DiskOverlay_IsEnabled())
+	{
+		/* Base image is only read, writes go to the overlay */
+		if (!(fp = fopen(filename, "rb")))
+		{
+			Log_AlertDlg(LOG_ERROR, "Cannot open %s HD file for reading\n'%s'!\n",
+				     hdtype, filename);
+			return -ENOENT;
+		}
+		overlay = DiskOverlay_Open(fp, filename, filesize, blockSize);
+		if (!overlay)
+		{
+			fclose(fp);
+			return -EIO;
+		}
+		writable = false;
+	}
+	else if (!(fp = fopen(filename, "rb+")))
 	{
 		if (!(fp = fopen(filename, "rb")))
 		{
@@ -901,6 +1274,7 @@ int HDC_InitDevice(const char *hdtype, SCSI_DEV *dev, char *filename, unsigned l
 		}
 		Log_AlertDlg(LOG_WARN, "%s HD file is read-only, no writes will go through\n'%s'.\n",
 			     hdtype, filename);
+		writable = false;
 	}
 	else if (!File_Lock(fp))
 	{
@@ -913,11 +1287,29 @@ int HDC_InitDevice(const char *hdtype, SCSI_DEV *dev, char *filename, unsigned l
 	dev->blockSize = blockSize;
 	dev->hdSize = filesize / dev->blockSize;
 	dev->image_file = fp;
+	dev->image_map = HDC_MapImage(fp, filesize, writable);
+	dev->image_map_writable = writable;
+	dev->overlay = overlay;
 	dev->enabled = true;
 
 	return 0;
 }
 
+/**
+ * Close a disk image file
+ */
+void HDC_CloseDevice(SCSI_DEV *dev)
+{
+	HDC_UnmapImage(dev->image_map, (off_t)dev->hdSize * dev->blockSize);
+	dev->image_map = NULL;
+	DiskOverlay_Close(dev->overlay);
+	dev->overlay = NULL;
+	File_UnLock(dev->image_file);
+	fclose(dev->image_file);
+	dev->image_file = NULL;
+	dev->enabled = false;
+}
+
 /**
  * Open the disk image files, set partitions.
  */
@@ -964,14 +1356,15 @@ void HDC_UnInit(void)
 {
 	int i;
 
+	/* pending transfer is dropped, but its host I/O has to finish */
+	CycInt_RemovePendingInterrupt(INTERRUPT_HDC_ACSI);
+	HDC_IoFinish(&AcsiBus.io);
+
 	for (i = 0; bAcsiEmuOn && i < MAX_ACSI_DEVS; i++)
 	{
 		if (!AcsiBus.devs[i].enabled)
 			continue;
-		File_UnLock(AcsiBus.devs[i].image_file);
-		fclose(AcsiBus.devs[i].image_file);
-		AcsiBus.devs[i].image_file = NULL;
-		AcsiBus.devs[i].enabled = false;
+		HDC_CloseDevice(&AcsiBus.devs[i]);
 	}
 	free(AcsiBus.buffer);
 	AcsiBus.buffer = NULL;
@@ -1072,20 +1465,29 @@ bool HDC_WriteCommandPacket(SCSI_CTRLR *ctr, Uint8 b)
 
 /*---------------------------------------------------------------------*/
 
-static void Acsi_DmaTransfer(void)
+/**
+ * Transfer the data of the current command, if DMA is set up for it.
+ * Unless the command completion interrupt is still pending, wait for
+ * the host I/O and raise the IRQ.  When called from the interrupt
+ * handler (bInHandler), the handler raises the IRQ itself.
+ * Return true if the host I/O was completed here.
+ */
+static bool Acsi_DmaTransfer(bool bInHandler)
 {
 	Uint32 nDmaAddr = FDC_GetDMAAddress();
 	Uint16 nDmaMode = FDC_DMA_GetMode();
+	bool bCompletePending = CycInt_InterruptActive(INTERRUPT_HDC_ACSI);
+	bool bCompleted = false;
 
 	/* Don't do anything if no DMA to ACSI bus or nothing to transfer */
 	if ((nDmaMode & 0xc0) != 0x00 || AcsiBus.data_len == 0)
-		return;
+		return false;
 
 	if ((AcsiBus.dmawrite_to_fh && (nDmaMode & 0x100) == 0)
 	    || (!AcsiBus.dmawrite_to_fh && (nDmaMode & 0x100) != 0))
 	{
 		Log_Printf(LOG_WARN, "DMA direction does not match SCSI command!\n");
-		return;
+		return false;
 	}
 
 	if (AcsiBus.dmawrite_to_fh)
@@ -1094,11 +1496,12 @@ static void Acsi_DmaTransfer(void)
 		if (STMemory_CheckAreaType(nDmaAddr, AcsiBus.data_len, ABFLAG_RAM | ABFLAG_ROM))
 		{
 #ifndef DISALLOW_HDC_WRITE
-			int wlen = fwrite(&STRam[nDmaAddr], 1, AcsiBus.data_len, AcsiBus.dmawrite_to_fh);
-			if (wlen != AcsiBus.data_len)
+			/* the host write runs until the command completes */
+			HDC_WriteImageData(&AcsiBus, &STRam[nDmaAddr], AcsiBus.data_len);
+			if (!bCompletePending)
 			{
-				Log_Printf(LOG_ERROR, "Could not write all bytes to ACSI HD image.\n");
-				AcsiBus.status = HD_STATUS_ERROR;
+				HDC_CompleteIo(&AcsiBus);
+				bCompleted = true;
 			}
 #endif
 		}
@@ -1109,16 +1512,50 @@ static void Acsi_DmaTransfer(void)
 			AcsiBus.bDmaError = true;
 		}
 		AcsiBus.dmawrite_to_fh = NULL;
+		AcsiBus.dmawrite_to_map = NULL;
 	}
-	else if (!STMemory_SafeCopy(nDmaAddr, AcsiBus.buffer, AcsiBus.data_len, "ACSI DMA"))
+	else if (bCompletePending)
 	{
-		AcsiBus.bDmaError = true;
-		AcsiBus.status = HD_STATUS_ERROR;
+		/* read data is transferred once the host read is done */
+		return false;
+	}
+	else
+	{
+		bCompleted = true;
+		if (!HDC_CompleteIo(&AcsiBus))
+		{
+			AcsiBus.data_len = 0;
+		}
+		else if (!STMemory_SafeCopy(nDmaAddr, AcsiBus.data, AcsiBus.data_len, "ACSI DMA"))
+		{
+			AcsiBus.bDmaError = true;
+			AcsiBus.status = HD_STATUS_ERROR;
+		}
 	}
 
 	FDC_WriteDMAAddress(nDmaAddr + AcsiBus.data_len);
 	AcsiBus.data_len = 0;
 
+	if (bCompletePending || bInHandler)
+		return bCompleted;
+	FDC_SetDMAStatus(AcsiBus.bDmaError);	/* Mark DMA error */
+	FDC_SetIRQ(FDC_IRQ_SOURCE_HDC);
+	return bCompleted;
+}
+
+/**
+ * Called when the emulated transfer time of a READ or WRITE command
+ * has passed: wait for the host I/O if it is still running, transfer
+ * the read data and raise the command completion interrupt.
+ */
+void HDC_InterruptHandler_Acsi(void)
+{
+	CycInt_AcknowledgeInterrupt();
+
+	/* if DMA isn't set up yet, the data is transferred later */
+	if (!Acsi_DmaTransfer(true) && !HDC_CompleteIo(&AcsiBus))
+		AcsiBus.data_len = 0;
+
 	FDC_SetDMAStatus(AcsiBus.bDmaError);	/* Mark DMA error */
 	FDC_SetIRQ(FDC_IRQ_SOURCE_HDC);
 }
@@ -1134,6 +1571,9 @@ static void Acsi_WriteCommandByte(int addr, Uint8 byte)
 	 * on this behavior). */
 	if ((addr & 2) == 0 && AcsiBus.byteCount != 1)
 	{
+		/* a new command aborts the transfer of the previous one */
+		CycInt_RemovePendingInterrupt(INTERRUPT_HDC_ACSI);
+
 		AcsiBus.byteCount = 0;
 		AcsiBus.target = ((byte & 0xE0) >> 5);
 		/* Only process the first byte if it is not
@@ -1154,7 +1594,13 @@ static void Acsi_WriteCommandByte(int addr, Uint8 byte)
 		bool bDidCmd = HDC_WriteCommandPacket(&AcsiBus, byte);
 		if (bDidCmd && AcsiBus.status == HD_STATUS_OK && AcsiBus.data_len)
 		{
-			Acsi_DmaTransfer();
+			/* READ/WRITE raise the IRQ when the emulated transfer is done */
+			if (AcsiBus.io_cycles)
+				CycInt_AddRelativeInterrupt(AcsiBus.io_cycles, INT_CPU_CYCLE,
+				                            INTERRUPT_HDC_ACSI);
+			Acsi_DmaTransfer(false);
+			if (AcsiBus.io_cycles)
+				return;
 		}
 	}
 
@@ -1201,5 +1647,5 @@ void HDC_DmaTransfer(void)
 	if (Config_IsMachineFalcon())
 		Ncr5380_DmaTransfer_Falcon();
 	else if (bAcsiEmuOn)
-		Acsi_DmaTransfer();
+		Acsi_DmaTransfer(false);
 }
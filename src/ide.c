@@ -17,9 +17,12 @@
 
 #include "main.h"
 #include "configuration.h"
+#include "cycles.h"
+#include "cycInt.h"
 #include "file.h"
 #include "ide.h"
-#include "hdc.h" /* for partition counting */
+#include "diskOverlay.h"
+#include "hdc.h" /* for partition counting and image mapping */
 #include "m68000.h"
 #include "mfp.h"
 #include "stMemory.h"
@@ -84,9 +87,15 @@ typedef struct IDEState
 	uint8_t *data_end;
 	uint8_t *io_buffer;
 	int media_changed;
+	/* sector I/O done in the disk I/O thread */
+	HDC_IO_JOB io;
+	int64_t io_sector;
+	int io_nsectors;
+	EndTransferFunc *io_done;
 } IDEState;
 
 static IDEState ide_state[2];
+static IDEState *ide_io_state;	/* drive waiting for I/O completion */
 
 static void ide_ioport_write(IDEState *ide_if, uint32_t addr, uint32_t val);
 static uint32_t ide_ioport_read(IDEState *ide_if, uint32_t addr1);
@@ -395,6 +404,8 @@ struct BlockDriverState {
     void *change_opaque;
 
     FILE *fhndl;
+    uint8_t *map;  /* mapping of the image file, or NULL */
+    DISK_OVERLAY *overlay;  /* copy-on-write overlay, or NULL */
     off_t file_size;
     int media_changed;
     int byteswap;
@@ -519,18 +530,31 @@ static int bdrv_read(BlockDriverState *bs, int64_t sector_num,
 
 	len = nb_sectors * bs->sector_size;
 
-	if (fseeko(bs->fhndl, sector_num * bs->sector_size, SEEK_SET) != 0)
+	if (bs->map)
+	{
+		off_t offset = (off_t)sector_num * bs->sector_size;
+		ret = 0;
+		if (offset >= 0 && offset + len <= bs->file_size)
+		{
+			memcpy(buf, bs->map + offset, len);
+			ret = len;
+		}
+	}
+	else if (fseeko(bs->fhndl, sector_num * bs->sector_size, SEEK_SET) != 0)
 	{
 		perror("bdrv_read");
 		return -errno;
 	}
-	ret = fread(buf, 1, len, bs->fhndl);
+	else
+		ret = fread(buf, 1, len, bs->fhndl);
 	if (ret != len)
 	{
 		Log_Printf(LOG_ERROR, "IDE: bdrv_read error (%d != %d length) at sector %lu!\n",
 		           ret, len, (unsigned long)sector_num);
 		return -EINVAL;
 	}
+	if (!DiskOverlay_Read(bs->overlay, sector_num, nb_sectors, buf))
+		return -EIO;
 
 	bs->rd_bytes += (unsigned) len;
 	bs->rd_ops ++;
@@ -568,6 +592,61 @@ static int bdrv_write(BlockDriverState *bs, int64_t sector_num,
 
 	len = nb_sectors * bs->sector_size;
 
+	if (bs->overlay)
+	{
+		const uint8_t *data = buf;
+		buf16 = NULL;
+		if (bs->byteswap)
+		{
+			buf16 = malloc(len);
+			if (!buf16)
+				return -ENOMEM;
+			for (idx = 0; idx < len; idx += 2)
+			{
+				buf16[idx / 2] = SDL_Swap16(*(const uint16_t *)&buf[idx]);
+			}
+			data = (const uint8_t *)buf16;
+		}
+		ret = DiskOverlay_Write(bs->overlay, sector_num, nb_sectors, data);
+		free(buf16);
+		if (!ret)
+		{
+			Log_Printf(LOG_ERROR, "IDE: bdrv_write overlay error at sector %lu!\n",
+			           (unsigned long)sector_num);
+			return -EIO;
+		}
+		bs->wr_bytes += (unsigned) len;
+		bs->wr_ops ++;
+		return 0;
+	}
+
+	if (bs->map)
+	{
+		off_t offset = (off_t)sector_num * bs->sector_size;
+		uint8_t *dst = bs->map + offset;
+		if (offset < 0 || offset + len > bs->file_size)
+		{
+			Log_Printf(LOG_ERROR, "IDE: bdrv_write beyond image end at sector %lu!\n",
+			           (unsigned long)sector_num);
+			return -EINVAL;
+		}
+		if (!bs->byteswap)
+		{
+			memcpy(dst, buf, len);
+		}
+		else
+		{
+			for (idx = 0; idx < len; idx += 2)
+			{
+				dst[idx] = buf[idx + 1];
+				dst[idx + 1] = buf[idx];
+			}
+		}
+		bs->wr_bytes += (unsigned) len;
+		bs->wr_ops ++;
+		return 0;
+	}
+
 	if (fseeko(bs->fhndl, sector_num * bs->sector_size, SEEK_SET) != 0)
 	{
 		perror("bdrv_write");
@@ -620,8 +699,26 @@ static int bdrv_open(BlockDriverState *bs, const char *filename, unsigned long b
 		return -1;
 	}
 
-	bs->fhndl = fopen(filename, "rb+");
-	if (!bs->fhndl) {
+	if (DiskOverlay_IsEnabled())
+	{
+		/* Base image is only read, writes go to the overlay */
+		bs->fhndl = fopen(filename, "rb");
+		if (!bs->fhndl)
+		{
+			perror("bdrv_open");
+			Log_AlertDlg(LOG_ERROR, "Cannot open IDE HD for reading\n'%s'.\n", filename);
+			return -1;
+		}
+		bs->overlay = DiskOverlay_Open(bs->fhndl, filename, bs->file_size, blockSize);
+		if (!bs->overlay)
+		{
+			fclose(bs->fhndl);
+			bs->fhndl = NULL;
+			return -1;
+		}
+	}
+	else if (!(bs->fhndl = fopen(filename, "rb+")))
+	{
 		/* Maybe the file is read-only? */
 		bs->fhndl = fopen(filename, "rb");
 		if (!bs->fhndl)
@@ -642,6 +739,8 @@ static int bdrv_open(BlockDriverState *bs, const char *filename, unsigned long b
 		return -1;
 	}
 
+	bs->map = HDC_MapImage(bs->fhndl, bs->file_size, !bs->read_only && !bs->overlay);
+
 	/* call the change callback */
 	bs->media_changed = 1;
 	if (bs->change_cb)
@@ -652,11 +751,20 @@ static int bdrv_open(BlockDriverState *bs, const char *filename, unsigned long b
 
 static void bdrv_flush(BlockDriverState *bs)
 {
-	fflush(bs->fhndl);
+	if (bs->overlay)
+		DiskOverlay_Sync(bs->overlay);
+	else if (bs->map)
+		HDC_SyncImage(bs->map, bs->file_size);
+	else
+		fflush(bs->fhndl);
 }
 
 static void bdrv_close(BlockDriverState *bs)
 {
+	HDC_UnmapImage(bs->map, bs->file_size);
+	bs->map = NULL;
+	DiskOverlay_Close(bs->overlay);
+	bs->overlay = NULL;
 	File_UnLock(bs->fhndl);
 	fclose(bs->fhndl);
 	bs->fhndl = NULL;
@@ -1221,10 +1329,82 @@ static void ide_set_sector(IDEState *s, int64_t sector_num)
 	}
 }
 
+static void ide_sector_read(IDEState *s);
+static void ide_sector_write(IDEState *s);
+
+/* disk I/O thread jobs for the sector transfers */
+static int ide_io_read(void *opaque)
+{
+	IDEState *s = opaque;
+	return bdrv_read(s->bs, s->io_sector, s->io_buffer, s->io_nsectors);
+}
+
+static int ide_io_write(void *opaque)
+{
+	IDEState *s = opaque;
+	return bdrv_write(s->bs, s->io_sector, s->io_buffer, s->io_nsectors);
+}
+
+static void ide_io_complete(void)
+{
+	IDEState *s = ide_io_state;
+
+	ide_io_state = NULL;
+	s->status &= ~BUSY_STAT;
+	s->io_done(s);
+}
+
+/* Start sector I/O in the disk I/O thread.  The drive stays busy
+ * until the emulated transfer time has passed, then done() is called. */
+static void ide_io_start(IDEState *s, int (*func)(void *), EndTransferFunc *done)
+{
+	if (ide_io_state)
+	{
+		CycInt_RemovePendingInterrupt(INTERRUPT_IDE);
+		ide_io_complete();
+	}
+
+	s->status |= BUSY_STAT;
+	s->status &= ~DRQ_STAT;
+	/* no PIO data transfer while busy */
+	s->data_ptr = NULL;
+	s->data_end = NULL;
+	s->io_done = done;
+	ide_io_state = s;
+	HDC_IoStart(&s->io, func, s);
+	CycInt_AddRelativeInterrupt(HDC_IO_CYCLES(s->io_nsectors * s->bs->sector_size),
+	                            INT_CPU_CYCLE, INTERRUPT_IDE);
+}
+
+/**
+ * Called when the emulated sector transfer time has passed.
+ * Waits for the host I/O if it hasn't finished yet.
+ */
+void Ide_InterruptHandler(void)
+{
+	CycInt_AcknowledgeInterrupt();
+	if (ide_io_state)
+		ide_io_complete();
+}
+
+static void ide_sector_read_done(IDEState *s)
+{
+	if (HDC_IoFinish(&s->io) != 0)
+	{
+		ide_abort_command(s);
+		ide_set_irq(s);
+		return;
+	}
+	ide_transfer_start(s, s->io_buffer, s->bs->sector_size * s->io_nsectors, ide_sector_read);
+	ide_set_irq(s);
+	ide_set_sector(s, s->io_sector + s->io_nsectors);
+	s->nsector -= s->io_nsectors;
+}
+
 static void ide_sector_read(IDEState *s)
 {
 	int64_t sector_num;
-	int ret, n;
+	int n;
 
 	s->status = READY_STAT | SEEK_STAT;
 	s->error = 0; /* not needed by IDE spec, but needed by Windows */
@@ -1241,41 +1421,24 @@ static void ide_sector_read(IDEState *s)
 
 		if (n > s->req_nb_sectors)
 			n = s->req_nb_sectors;
-		ret = bdrv_read(s->bs, sector_num, s->io_buffer, n);
-		if (ret != 0)
-		{
-			ide_abort_command(s);
-			ide_set_irq(s);
-			return;
-		}
-		ide_transfer_start(s, s->io_buffer, s->bs->sector_size * n, ide_sector_read);
-		ide_set_irq(s);
-		ide_set_sector(s, sector_num + n);
-		s->nsector -= n;
+		s->io_sector = sector_num;
+		s->io_nsectors = n;
+		ide_io_start(s, ide_io_read, ide_sector_read_done);
 	}
 }
 
 
-static void ide_sector_write(IDEState *s)
+static void ide_sector_write_done(IDEState *s)
 {
-	int64_t sector_num;
-	int ret, n, n1;
-
-	s->status = READY_STAT | SEEK_STAT;
-	sector_num = ide_get_sector(s);
-	LOG_TRACE(TRACE_IDE, "IDE: write sector=%"PRId64"\n", sector_num);
+	int n1;
 
-	n = s->nsector;
-	if (n > s->req_nb_sectors)
-		n = s->req_nb_sectors;
-	ret = bdrv_write(s->bs, sector_num, s->io_buffer, n);
-	if (ret != 0)
+	if (HDC_IoFinish(&s->io) != 0)
 	{
 		ide_abort_command(s);
 		ide_set_irq(s);
 		return;
 	}
-	s->nsector -= n;
+	s->nsector -= s->io_nsectors;
 	if (s->nsector == 0)
 	{
 		/* no more sectors to write */
@@ -1288,11 +1451,26 @@ static void ide_sector_write(IDEState *s)
 			n1 = s->req_nb_sectors;
 		ide_transfer_start(s, s->io_buffer, s->bs->sector_size * n1, ide_sector_write);
 	}
-	ide_set_sector(s, sector_num + n);
+	ide_set_sector(s, s->io_sector + s->io_nsectors);
 
 	ide_set_irq(s);
 }
 
+static void ide_sector_write(IDEState *s)
+{
+	int n;
+
+	s->status = READY_STAT | SEEK_STAT;
+	s->io_sector = ide_get_sector(s);
+	LOG_TRACE(TRACE_IDE, "IDE: write sector=%"PRId64"\n", s->io_sector);
+
+	n = s->nsector;
+	if (n > s->req_nb_sectors)
+		n = s->req_nb_sectors;
+	s->io_nsectors = n;
+	ide_io_start(s, ide_io_write, ide_sector_write_done);
+}
+
 
 static void ide_atapi_cmd_ok(IDEState *s)
 {
@@ -2743,6 +2921,12 @@ void Ide_UnInit(void)
 {
 	int i;
 
+	/* drop pending completion, but let the host I/O finish */
+	CycInt_RemovePendingInterrupt(INTERRUPT_IDE);
+	ide_io_state = NULL;
+	for (i = 0; i < 2; i++)
+		HDC_IoFinish(&ide_state[i].io);
+
 	for (i = 0; i < 2; i++)
 	{
 		if (hd_table[i])
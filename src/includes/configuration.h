@@ -16,6 +16,7 @@ typedef struct
 {
   char sLogFileName[FILENAME_MAX];
   char sTraceFileName[FILENAME_MAX];
+  char sTraceBinFileName[FILENAME_MAX];	/* binary trace events, or empty */
   int nTextLogLevel;
   int nAlertDlgLogLevel;
   bool bConfirmQuit;
@@ -236,7 +237,9 @@ typedef struct
   bool bFilenameConversion;
   bool bGemdosHostTime;
   bool bBootFromHardDisk;
+  bool bUseImageOverlays;
   char szHardDiskDirectories[MAX_HARDDRIVES][FILENAME_MAX];
+  char szImageOverlayDir[FILENAME_MAX];
 } CNF_HARDDISK;
 
 /* SCSI/ACSI/IDE configuration */
@@ -390,6 +393,7 @@ typedef struct
   bool bPatchTimerD;
   bool bFastBoot;                 /* Enable to patch TOS for fast boot */
   bool bFastForward;
+  bool bSkipSpinLoops;            /* Skip CPU loops waiting for an interrupt */
   bool bAddressSpace24;           /* true if using a 24-bit address bus */
   VIDEOTIMINGMODE VideoTimingMode;
 
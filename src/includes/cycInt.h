@@ -34,6 +34,9 @@ typedef enum
   INTERRUPT_FDC,
   INTERRUPT_BLITTER,
   INTERRUPT_MIDI,
+  INTERRUPT_HDC_ACSI,
+  INTERRUPT_IDE,
+  INTERRUPT_PROFILE_SAMPLE,
 
   MAX_INTERRUPTS
 } interrupt_id;
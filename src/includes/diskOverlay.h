@@ -0,0 +1,25 @@
+/*
+  Hatari - diskOverlay.h
+
+  This file is distributed under the GNU General Public License, version 2
+  or at your option any later version. Read the file gpl.txt for details.
+*/
+
+#ifndef HATARI_DISKOVERLAY_H
+#define HATARI_DISKOVERLAY_H
+
+typedef struct disk_overlay DISK_OVERLAY;
+
+extern bool DiskOverlay_IsEnabled(void);
+extern int DiskOverlay_FileName(char *buf, size_t buflen, const char *imagefile, const char *ext);
+extern DISK_OVERLAY *DiskOverlay_Open(FILE *base, const char *basefile, off_t size, int blockSize);
+extern void DiskOverlay_Close(DISK_OVERLAY *ov);
+extern bool DiskOverlay_HasBlocks(DISK_OVERLAY *ov, Uint64 block, int count);
+extern bool DiskOverlay_Read(DISK_OVERLAY *ov, Uint64 block, int count, Uint8 *buf);
+extern bool DiskOverlay_Write(DISK_OVERLAY *ov, Uint64 block, int count, const Uint8 *buf);
+extern void DiskOverlay_Sync(DISK_OVERLAY *ov);
+extern int DiskOverlay_MergeAll(void);
+extern int DiskOverlay_DiscardAll(void);
+extern void DiskOverlay_Info(FILE *fp, Uint32 dummy);
+
+#endif /* HATARI_DISKOVERLAY_H */
@@ -49,12 +49,29 @@
 #define HD_REQSENS_INVARG   0x24              /* Invalid argument */
 #define HD_REQSENS_INVLUN   0x25              /* Invalid LUN */
 
+/* Emulated duration of a READ/WRITE data transfer, in CPU cycles */
+#define HDC_IO_CYCLES_BASE  1024
+#define HDC_IO_CYCLES(len)  (HDC_IO_CYCLES_BASE + 2 * (len))
+
+/**
+ * Host I/O job, run by the disk I/O thread
+ */
+typedef struct {
+	int (*func)(void *arg);     /* Does the I/O, returns 0 on success */
+	void *arg;
+	int result;
+	bool pending;               /* Queued or still running */
+} HDC_IO_JOB;
+
 /**
  * Information about a ACSI/SCSI drive
  */
 typedef struct scsi_data {
 	bool enabled;
 	FILE *image_file;
+	Uint8 *image_map;           /* Mapping of the image file, or NULL */
+	bool image_map_writable;
+	struct disk_overlay *overlay; /* Copy-on-write overlay, or NULL */
 	Uint32 nLastBlockAddr;      /* The specified sector number */
 	bool bSetLastBlockAddr;
 	Uint8 nLastError;
@@ -82,7 +99,15 @@ typedef struct {
 	int buffer_size;
 	int data_len;
 	int offset;                 /* Current offset into data buffer */
+	Uint8 *data;                /* Data buffer: response buffer or image mapping */
 	FILE *dmawrite_to_fh;
+	Uint8 *dmawrite_to_map;     /* Image mapping destination for writes, or NULL */
+	HDC_IO_JOB io;              /* Host I/O of the current READ/WRITE command */
+	SCSI_DEV *io_dev;
+	Uint8 *io_buf;              /* Buffer for the host I/O, NULL to only prefetch the mapping */
+	Uint8 *io_map;              /* Image mapping position, or NULL */
+	int io_len;
+	int io_cycles;              /* Emulated transfer time, 0 if command completes at once */
 	SCSI_DEV devs[8];
 } SCSI_CTRLR;
 
@@ -96,6 +121,17 @@ extern bool bAcsiEmuOn;
 extern bool HDC_Init(void);
 extern void HDC_UnInit(void);
 extern int HDC_InitDevice(const char *hdtype, SCSI_DEV *dev, char *filename, unsigned long blockSize);
+extern void HDC_CloseDevice(SCSI_DEV *dev);
+extern Uint8 *HDC_MapImage(FILE *fp, off_t size, bool writable);
+extern void HDC_SyncImage(Uint8 *map, off_t size);
+extern void HDC_UnmapImage(Uint8 *map, off_t size);
+extern void HDC_WriteImageData(SCSI_CTRLR *ctr, const Uint8 *src, int len);
+extern bool HDC_CompleteIo(SCSI_CTRLR *ctr);
+extern void HDC_IoStart(HDC_IO_JOB *job, int (*func)(void *arg), void *arg);
+extern int HDC_IoFinish(HDC_IO_JOB *job);
+extern void HDC_IoWaitAll(void);
+extern void HDC_IoUnInit(void);
+extern void HDC_InterruptHandler_Acsi(void);
 extern void HDC_ResetCommandStatus(void);
 extern short int HDC_ReadCommandByte(int addr);
 extern void HDC_WriteCommandByte(int addr, Uint8 byte);
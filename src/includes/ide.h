@@ -15,6 +15,7 @@ extern int nIDEPartitions;
 extern void Ide_Init(void);
 extern void Ide_UnInit(void);
 extern bool Ide_IsAvailable(void);
+extern void Ide_InterruptHandler(void);
 extern uae_u32 REGPARAM3 Ide_Mem_bget(uaecptr addr);
 extern uae_u32 REGPARAM3 Ide_Mem_wget(uaecptr addr);
 extern uae_u32 REGPARAM3 Ide_Mem_lget(uaecptr addr);
@@ -120,6 +120,12 @@ typedef struct {
 	Uint32 TimerCClockCycles;
 	Uint32 TimerDClockCycles;
 
+	/* Timers in delay mode whose interrupt is disabled in IERA/IERB are "parked" : */
+	/* no CycInt event is used, the counter is computed from the next underflow's time */
+	Uint8	TimerParked;				/* bit 0-3 set when timer A-D is parked */
+	Uint64	TimerParked_Cycles[ 4 ];		/* CycInt internal cycles of the next underflow */
+	Uint32	TimerParked_Period[ 4 ];		/* CycInt internal cycles between 2 underflows */
+
 	Uint8	PatchTimerD_Done;			/* 0=false 1=true */
 	Uint8	PatchTimerD_TDDR_old;			/* Value of TDDR before forcing it to PATCH_TIMER_TDDR_FAKE */
 
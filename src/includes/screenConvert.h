@@ -7,6 +7,8 @@
 
 void Screen_RemapPalette(void);
 void Screen_SetPaletteColor(Uint8 idx, Uint8 red, Uint8 green, Uint8 blue);
+void ScreenConv_SetFullUpdate(void);
+void ScreenConv_ClipUpdateRect(SDL_Rect *rect);
 void ScreenConv_MemorySnapShot_Capture(bool bSave);
 
 void Screen_GenConvert(uint32_t vaddr, void *fvram, int vw, int vh,
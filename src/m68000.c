@@ -884,6 +884,8 @@ void M68000_MMU_Info(FILE *fp, Uint32 flags)
 		fprintf(fp, "TC:\t0x%08x\n", tc_030);
 		fprintf(fp, "TT0:\t0x%08x\n", tt0_030);
 		fprintf(fp, "TT1:\t0x%08x\n", tt1_030);
+		if (ConfigureParams.System.nCpuLevel == 3)
+			mmu030_show_atc_stats(fp);
 	}
 	else	/* 68040 / 68060 mode */
 	{
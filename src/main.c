@@ -329,6 +329,8 @@ void Main_WaitOnVbl(void)
 	{
 		/* show VBLs/s */
 		Main_PauseEmulation(true);
+		/* exit() skips Exit680x0(), write opcode counts (if enabled) here */
+		dump_counts();
 		exit(0);
 	}
 
@@ -639,6 +641,7 @@ void Main_EventHandler(void)
 				Screen_SetTextureScale(sdlscrn->w, sdlscrn->h,
 						       event.window.data1,
 						       event.window.data2, false);
+				Screen_SetTextureFullUpdate(false);
 				SDL_UpdateRect(sdlscrn, 0, 0, 0, 0);
 				break;
 				/* mouse & keyboard focus */
@@ -654,6 +657,15 @@ void Main_EventHandler(void)
 			bContinueProcessing = true;
 			break;
 
+		 case SDL_RENDER_TARGETS_RESET:
+		 case SDL_RENDER_DEVICE_RESET:
+			/* window texture content (or the texture) got lost */
+			Log_Printf(LOG_DEBUG, "SDL2 renderer reset event: 0x%x\n", event.type);
+			Screen_SetTextureFullUpdate(event.type == SDL_RENDER_DEVICE_RESET);
+			SDL_UpdateRect(sdlscrn, 0, 0, 0, 0);
+			bContinueProcessing = true;
+			break;
+
 		 default:
 			/* don't let unknown events delay event processing */
 			bContinueProcessing = true;
@@ -797,6 +809,7 @@ static void Main_UnInit(void)
 	NvRam_UnInit();
 	GemDOS_UnInitDrives();
 	Ide_UnInit();
+	HDC_IoUnInit();
 	Joy_UnInit();
 	if (Sound_AreWeRecording())
 		Sound_EndRecording();
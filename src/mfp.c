@@ -139,6 +139,7 @@
 const char MFP_fileid[] = "Hatari mfp.c";
 
 #include <stdint.h>		/* Needed for UINT64_MAX */
+#include <inttypes.h>
 #include "main.h"
 #include "configuration.h"
 #include "dmaSnd.h"
@@ -313,6 +314,15 @@ Input -----/             |         ------------------------              |
     In that case, the TT's specific MFP (accessible between $FFFA81 and $FFFAAF) has the highest priority
     and the "normal" MFP (accessible between $FFFA01 and $FFFA2F) has the lowest priority
 
+  - A timer in delay mode whose interrupt is disabled in IERA/IERB can't change the pending bits when it
+    expires, but it would still require one CycInt event per underflow to restart its counter (TOS keeps
+    timer D running at a very high rate for the RS232 baud rate, with its interrupt disabled).
+    Such timers are "parked" : we remove their CycInt event and only keep the time of their next underflow
+    and their period, which is enough to compute the content of the data register when it's read.
+    As soon as the interrupt is enabled again in IERA/IERB, a new CycInt event is added at the time of the
+    next underflow. Note that a timer whose interrupt is only masked in IMRA/IMRB can't be parked, because
+    it still sets its pending bit in IPRA/IPRB when it expires.
+
   - Each MFP has 8 GPIP bits used to connect signals from external devices/ports :
 
     Main MFP :
@@ -386,6 +396,13 @@ static const Uint16 MFPDiv[] =
 //#define MFP_CYCLE_TO_REG(cyc,ctrl)	( cyc / MFPDiv[ ctrl&0x7 ] )
 
 
+/* Timer number (0-3 for timer A-D) of a timer's CycInt handler. This requires */
+/* that INTERRUPT_MFP_xxx_TIMERA-D are consecutive in the interrupt_id enum */
+#define	MFP_TIMER_NR(Handler)		( ( (Handler) - INTERRUPT_MFP_MAIN_TIMERA ) & 3 )
+
+/* Interrupt number associated to each timer */
+static const Sint16 MFP_TimerNrToIntNumber[] = { MFP_INT_TIMER_A , MFP_INT_TIMER_B , MFP_INT_TIMER_C , MFP_INT_TIMER_D };
+
 /* Interrupt number associated to each line of the GPIP */
 static const int MFP_GPIP_LineToIntNumber[] = { MFP_INT_GPIP0 , MFP_INT_GPIP1 , MFP_INT_GPIP2 , MFP_INT_GPIP3,
 	MFP_INT_GPIP4 , MFP_INT_GPIP5 , MFP_INT_GPIP6 , MFP_INT_GPIP7 };
@@ -412,6 +429,15 @@ static Uint8	MFP_Main_Compute_GPIP7 ( void );
 static void	MFP_GPIP_ReadByte_Main ( MFP_STRUCT *pMFP );
 static void	MFP_GPIP_ReadByte_TT ( MFP_STRUCT *pMFP );
 
+static bool	MFP_Timer_CanPark ( MFP_STRUCT *pMFP , interrupt_id Handler );
+static void	MFP_Timer_UpdateParkedCycles ( MFP_STRUCT *pMFP , int TimerNr , Uint64 Now );
+static void	MFP_Timer_AddInterrupt ( MFP_STRUCT *pMFP , interrupt_id Handler , Uint32 TimerClockCycles , int CycleOffset );
+static void	MFP_Timer_RemoveInterrupt ( MFP_STRUCT *pMFP , interrupt_id Handler );
+static void	MFP_Timer_UnparkEnabled ( MFP_STRUCT *pMFP );
+static bool	MFP_Timer_IsActive ( MFP_STRUCT *pMFP , interrupt_id Handler );
+static int	MFP_Timer_FindCyclesRemaining ( MFP_STRUCT *pMFP , interrupt_id Handler );
+static void	MFP_Timer_SetParkedData ( MFP_STRUCT *pMFP , int TimerNr , Uint8 TimerControl , Uint16 TimerData );
+
 
 
 /*-----------------------------------------------------------------------*/
@@ -543,6 +569,13 @@ static void	MFP_Reset ( MFP_STRUCT *pMFP )
 	pMFP->TimerCClockCycles = 0;
 	pMFP->TimerDClockCycles = 0;
 
+	pMFP->TimerParked = 0;
+	for ( i=0 ; i<4 ; i++ )
+	{
+		pMFP->TimerParked_Cycles[ i ] = 0;
+		pMFP->TimerParked_Period[ i ] = 0;
+	}
+
 	pMFP->PatchTimerD_Done = 0;
 
 	/* Clear input on timers A and B */
@@ -607,6 +640,13 @@ void	MFP_MemorySnapShot_Capture ( bool bSave )
 		MemorySnapShot_Store(&(pMFP->TimerCClockCycles), sizeof(pMFP->TimerCClockCycles));
 		MemorySnapShot_Store(&(pMFP->TimerDClockCycles), sizeof(pMFP->TimerDClockCycles));
 
+		MemorySnapShot_Store(&(pMFP->TimerParked), sizeof(pMFP->TimerParked));
+		for ( i=0 ; i<4 ; i++ )
+		{
+			MemorySnapShot_Store(&(pMFP->TimerParked_Cycles[ i ]), sizeof(pMFP->TimerParked_Cycles[ i ]));
+			MemorySnapShot_Store(&(pMFP->TimerParked_Period[ i ]), sizeof(pMFP->TimerParked_Period[ i ]));
+		}
+
 		MemorySnapShot_Store(&(pMFP->PatchTimerD_Done), sizeof(pMFP->PatchTimerD_Done));
 		MemorySnapShot_Store(&(pMFP->PatchTimerD_TDDR_old), sizeof(pMFP->PatchTimerD_TDDR_old));
 
@@ -1307,6 +1347,178 @@ void	MFP_TimerB_EventCount ( MFP_STRUCT *pMFP , int Delayed_Cycles )
 }
 
 
+/*-----------------------------------------------------------------------*/
+/**
+ * Return true if a timer can be parked, ie it doesn't need a CycInt event
+ * on each underflow because its interrupt is disabled in IERA/IERB.
+ * Main MFP's timer D can't be parked when RS232 is enabled, because its
+ * handler is also used to poll the RS232 input.
+ */
+static bool	MFP_Timer_CanPark ( MFP_STRUCT *pMFP , interrupt_id Handler )
+{
+	Uint8	*pEnableReg;
+	Uint8	Bit;
+
+	Bit = MFP_ConvertIntNumber ( pMFP , MFP_TimerNrToIntNumber[ MFP_TIMER_NR ( Handler ) ] , &pEnableReg , NULL , NULL , NULL );
+	if ( *pEnableReg & Bit )
+		return false;
+
+	if ( ( Handler == INTERRUPT_MFP_MAIN_TIMERD ) && ConfigureParams.RS232.bEnableRS232 )
+		return false;
+
+	return true;
+}
+
+
+/*-----------------------------------------------------------------------*/
+/**
+ * For a parked timer, skip all the underflows that happened before 'Now'
+ * (in CycInt internal cycles), so that the next underflow is always > Now.
+ * This is equivalent to what CycInt_Process would do if the timer's
+ * event was still in the CycInt list.
+ */
+static void	MFP_Timer_UpdateParkedCycles ( MFP_STRUCT *pMFP , int TimerNr , Uint64 Now )
+{
+	Uint64	Period = pMFP->TimerParked_Period[ TimerNr ];
+
+	if ( pMFP->TimerParked_Cycles[ TimerNr ] <= Now )
+		pMFP->TimerParked_Cycles[ TimerNr ] += ( ( Now - pMFP->TimerParked_Cycles[ TimerNr ] ) / Period + 1 ) * Period;
+}
+
+
+/*-----------------------------------------------------------------------*/
+/**
+ * Start the next period of a timer in delay mode. If the timer's interrupt
+ * is disabled, we park the timer instead of adding a CycInt event.
+ * Parameters are the same as for CycInt_AddRelativeInterruptWithOffset()
+ */
+static void	MFP_Timer_AddInterrupt ( MFP_STRUCT *pMFP , interrupt_id Handler , Uint32 TimerClockCycles , int CycleOffset )
+{
+	int	TimerNr = MFP_TIMER_NR ( Handler );
+
+	if ( !MFP_Timer_CanPark ( pMFP , Handler ) )
+	{
+		CycInt_AddRelativeInterruptWithOffset ( TimerClockCycles , INT_MFP_CYCLE , Handler , CycleOffset );
+		return;
+	}
+
+	/* Same computation as in CycInt_AddRelativeInterruptWithOffset */
+	pMFP->TimerParked |= ( 1 << TimerNr );
+	pMFP->TimerParked_Period[ TimerNr ] = INT_CONVERT_TO_INTERNAL ( (Sint64)TimerClockCycles , INT_MFP_CYCLE );
+	pMFP->TimerParked_Cycles[ TimerNr ] = INT_CONVERT_TO_INTERNAL ( Cycles_GetClockCounterImmediate() , INT_CPU_CYCLE )
+		+ pMFP->TimerParked_Period[ TimerNr ] + CycleOffset;
+
+	LOG_TRACE(TRACE_MFP_START , "mfp%s park timer handler=%d timer_cyc=%d next_cyc=%"PRIu64" pc=%x\n" ,
+		pMFP->NameSuffix , Handler , TimerClockCycles , pMFP->TimerParked_Cycles[ TimerNr ] , M68000_GetPC() );
+}
+
+
+/*-----------------------------------------------------------------------*/
+/**
+ * Stop a timer, whether it's parked or using a CycInt event
+ */
+static void	MFP_Timer_RemoveInterrupt ( MFP_STRUCT *pMFP , interrupt_id Handler )
+{
+	pMFP->TimerParked &= ~( 1 << MFP_TIMER_NR ( Handler ) );
+	CycInt_RemovePendingInterrupt ( Handler );
+}
+
+
+/*-----------------------------------------------------------------------*/
+/**
+ * Check all parked timers after IERA/IERB changed : if a timer's interrupt
+ * is enabled again, add a new CycInt event at the time of its next underflow
+ */
+static void	MFP_Timer_UnparkEnabled ( MFP_STRUCT *pMFP )
+{
+	interrupt_id	Handler;
+	int		TimerNr;
+	Uint64		Now;
+
+	if ( pMFP->TimerParked == 0 )
+		return;
+
+	Now = INT_CONVERT_TO_INTERNAL ( Cycles_GetClockCounterImmediate() , INT_CPU_CYCLE );
+
+	for ( TimerNr=0 ; TimerNr<4 ; TimerNr++ )
+	{
+		if ( ( pMFP->TimerParked & ( 1 << TimerNr ) ) == 0 )
+			continue;
+
+		Handler = ( pMFP == pMFP_Main ? INTERRUPT_MFP_MAIN_TIMERA : INTERRUPT_MFP_TT_TIMERA ) + TimerNr;
+		if ( MFP_Timer_CanPark ( pMFP , Handler ) )
+			continue;
+
+		MFP_Timer_UpdateParkedCycles ( pMFP , TimerNr , Now );
+		pMFP->TimerParked &= ~( 1 << TimerNr );
+		CycInt_AddRelativeInterruptWithOffset ( 0 , INT_CPU_CYCLE , Handler , (int)( pMFP->TimerParked_Cycles[ TimerNr ] - Now ) );
+
+		LOG_TRACE(TRACE_MFP_START , "mfp%s unpark timer handler=%d next_cyc=%"PRIu64" pc=%x\n" ,
+			pMFP->NameSuffix , Handler , pMFP->TimerParked_Cycles[ TimerNr ] , M68000_GetPC() );
+	}
+}
+
+
+/*-----------------------------------------------------------------------*/
+/**
+ * Return true if a timer is running in delay mode (parked or not)
+ */
+static bool	MFP_Timer_IsActive ( MFP_STRUCT *pMFP , interrupt_id Handler )
+{
+	if ( pMFP->TimerParked & ( 1 << MFP_TIMER_NR ( Handler ) ) )
+		return true;
+
+	return CycInt_InterruptActive ( Handler );
+}
+
+
+/*-----------------------------------------------------------------------*/
+/**
+ * Return the number of MFP cycles before the next underflow of a timer
+ * (parked or not)
+ */
+static int	MFP_Timer_FindCyclesRemaining ( MFP_STRUCT *pMFP , interrupt_id Handler )
+{
+	int	TimerNr = MFP_TIMER_NR ( Handler );
+	Uint64	Now;
+
+	if ( ( pMFP->TimerParked & ( 1 << TimerNr ) ) == 0 )
+		return CycInt_FindCyclesRemaining ( Handler , INT_MFP_CYCLE );
+
+	Now = INT_CONVERT_TO_INTERNAL ( Cycles_GetClockCounterImmediate() , INT_CPU_CYCLE );
+	MFP_Timer_UpdateParkedCycles ( pMFP , TimerNr , Now );
+
+	return INT_CONVERT_FROM_INTERNAL ( (Sint64)( pMFP->TimerParked_Cycles[ TimerNr ] - Now ) , INT_MFP_CYCLE );
+}
+
+
+/*-----------------------------------------------------------------------*/
+/**
+ * Handle a write to the data register of a parked timer. As for a timer
+ * using a CycInt event, the current period is not changed and the new data
+ * is used from the next underflow : we skip the underflows that already
+ * happened to get the time of the next one, and then store the new period.
+ */
+static void	MFP_Timer_SetParkedData ( MFP_STRUCT *pMFP , int TimerNr , Uint8 TimerControl , Uint16 TimerData )
+{
+	Uint64	Now;
+
+	if ( ( pMFP->TimerParked & ( 1 << TimerNr ) ) == 0 )
+		return;
+
+	Now = INT_CONVERT_TO_INTERNAL ( Cycles_GetClockCounterImmediate() , INT_CPU_CYCLE );
+	MFP_Timer_UpdateParkedCycles ( pMFP , TimerNr , Now );
+
+	if ( TimerData == 0 )			/* Data=0 is actually Data=256 */
+		TimerData = 256;
+	pMFP->TimerParked_Period[ TimerNr ] = INT_CONVERT_TO_INTERNAL ( (Sint64)MFP_REG_TO_CYCLES ( TimerData , TimerControl ) , INT_MFP_CYCLE );
+
+	LOG_TRACE(TRACE_MFP_WRITE , "mfp%s parked timer %d data=%d next_cyc=%"PRIu64" period=%u pc=%x\n" ,
+		pMFP->NameSuffix , TimerNr , TimerData , pMFP->TimerParked_Cycles[ TimerNr ] ,
+		pMFP->TimerParked_Period[ TimerNr ] , M68000_GetPC() );
+}
+
+
 /*-----------------------------------------------------------------------*/
 /**
  * Start Timer A or B - EventCount mode is done in HBL handler to time correctly
@@ -1366,13 +1578,13 @@ static Uint32 MFP_StartTimer_AB ( MFP_STRUCT *pMFP , Uint8 TimerControl, Uint16
 
 		/* And add to our internal interrupt list, if timer cycles is zero
 		 * then timer is stopped */
-		CycInt_RemovePendingInterrupt(Handler);
+		MFP_Timer_RemoveInterrupt ( pMFP , Handler );
 		if (TimerClockCycles)
 		{
 			/* Start timer from now? If not continue timer using PendingCycleOver */
 			if (bFirstTimer)
 			{
-				CycInt_AddRelativeInterrupt(TimerClockCycles, INT_MFP_CYCLE, Handler);
+				MFP_Timer_AddInterrupt ( pMFP , Handler , TimerClockCycles , 0 );
 			}
 			else
 			{
@@ -1382,7 +1594,7 @@ static Uint32 MFP_StartTimer_AB ( MFP_STRUCT *pMFP , Uint8 TimerControl, Uint16
 				if ( (Sint64)PendingCyclesOver > TimerClockCyclesInternal )
 					PendingCyclesOver = PendingCyclesOver % TimerClockCyclesInternal;
 
-				CycInt_AddRelativeInterruptWithOffset(TimerClockCycles, INT_MFP_CYCLE, Handler, -PendingCyclesOver);
+				MFP_Timer_AddInterrupt ( pMFP , Handler , TimerClockCycles , -PendingCyclesOver );
 			}
 		}
 
@@ -1405,13 +1617,16 @@ static Uint32 MFP_StartTimer_AB ( MFP_STRUCT *pMFP , Uint8 TimerControl, Uint16
 	else if (TimerControl == 8 )				/* event count mode */
 	{
 		/* Make sure no outstanding interrupts in list if channel is disabled */
-		CycInt_RemovePendingInterrupt(Handler);
+		MFP_Timer_RemoveInterrupt ( pMFP , Handler );
 
 		if ( ( Handler == INTERRUPT_MFP_MAIN_TIMERB )		/* we're starting timer B event count mode */
 		  || ( Handler == INTERRUPT_MFP_TT_TIMERB ) )
 		{
 			/* Store start cycle for handling interrupt in video.c */
 			TimerBEventCountCycleStart = Cycles_GetCounterOnWriteAccess(CYCLES_COUNTER_VIDEO);
+
+			/* EndLine interrupts are stopped when timer B is not in event count mode */
+			Video_RestartInterruptTimerB();
 		}
 
 		if (LOG_TRACE_LEVEL(TRACE_MFP_START))
@@ -1460,13 +1675,13 @@ static Uint32 MFP_StartTimer_CD (  MFP_STRUCT *pMFP , Uint8 TimerControl, Uint16
 
 		/* And add to our internal interrupt list, if timer cycles is zero
 		 * then timer is stopped */
-		CycInt_RemovePendingInterrupt(Handler);
+		MFP_Timer_RemoveInterrupt ( pMFP , Handler );
 		if (TimerClockCycles)
 		{
 			/* Start timer from now? If not continue timer using PendingCycleOver */
 			if (bFirstTimer)
 			{
-				CycInt_AddRelativeInterrupt(TimerClockCycles, INT_MFP_CYCLE, Handler);
+				MFP_Timer_AddInterrupt ( pMFP , Handler , TimerClockCycles , 0 );
 			}
 			else
 			{
@@ -1475,7 +1690,7 @@ static Uint32 MFP_StartTimer_CD (  MFP_STRUCT *pMFP , Uint8 TimerControl, Uint16
 				if ( (Sint64)PendingCyclesOver > TimerClockCyclesInternal )
 					PendingCyclesOver = PendingCyclesOver % TimerClockCyclesInternal;
 
-				CycInt_AddRelativeInterruptWithOffset(TimerClockCycles, INT_MFP_CYCLE, Handler, -PendingCyclesOver);
+				MFP_Timer_AddInterrupt ( pMFP , Handler , TimerClockCycles , -PendingCyclesOver );
 			}
 		}
 	}
@@ -1493,7 +1708,7 @@ static Uint32 MFP_StartTimer_CD (  MFP_STRUCT *pMFP , Uint8 TimerControl, Uint16
 		}
 
 		/* Make sure no outstanding interrupts in list if channel is disabled */
-		CycInt_RemovePendingInterrupt(Handler);
+		MFP_Timer_RemoveInterrupt ( pMFP , Handler );
 	}
 
 	return TimerClockCycles;
@@ -1508,10 +1723,10 @@ static Uint8	MFP_ReadTimer_AB ( MFP_STRUCT *pMFP , Uint8 TimerControl, Uint8 Mai
 {
 	/* Find TimerAB count, if no interrupt or not in delay mode assume
 	 * in Event Count mode so already up-to-date as kept by HBL */
-	if (CycInt_InterruptActive(Handler) && (TimerControl > 0) && (TimerControl <= 7))
+	if (MFP_Timer_IsActive(pMFP, Handler) && (TimerControl > 0) && (TimerControl <= 7))
 	{
 		/* Find cycles passed since last interrupt */
-		MainCounter = MFP_CYCLE_TO_REG ( CycInt_FindCyclesRemaining ( Handler, INT_MFP_CYCLE ), TimerControl );
+		MainCounter = MFP_CYCLE_TO_REG ( MFP_Timer_FindCyclesRemaining ( pMFP , Handler ), TimerControl );
 //fprintf ( stderr , "mfp read AB count %d int_cyc=%d\n" , MainCounter , CycInt_FindCyclesRemaining ( Handler, INT_MFP_CYCLE ) );
 	}
 
@@ -1520,7 +1735,7 @@ static Uint8	MFP_ReadTimer_AB ( MFP_STRUCT *pMFP , Uint8 TimerControl, Uint8 Mai
 	/* if no write is made to the data reg before */
 	if ( TimerIsStopping )
 	{
-		if ( CycInt_FindCyclesRemaining ( Handler, INT_MFP_CYCLE ) < MFP_REG_TO_CYCLES ( 1 , TimerControl ) )
+		if ( MFP_Timer_FindCyclesRemaining ( pMFP , Handler ) < MFP_REG_TO_CYCLES ( 1 , TimerControl ) )
 		{
 			MainCounter = 0;			/* internal mfp counter becomes 0 (=256) */
 			LOG_TRACE(TRACE_MFP_READ , "mfp%s read AB handler=%d stopping timer while data reg between 1 and 0 : forcing data to 256\n" ,
@@ -1548,10 +1763,10 @@ static Uint8	MFP_ReadTimer_AB ( MFP_STRUCT *pMFP , Uint8 TimerControl, Uint8 Mai
 static Uint8	MFP_ReadTimer_CD ( MFP_STRUCT *pMFP , Uint8 TimerControl, Uint8 TimerData, Uint8 MainCounter, Uint32 TimerCycles, interrupt_id Handler, bool TimerIsStopping)
 {
 	/* Find TimerCD count. If timer is off, MainCounter already contains the latest value */
-	if (CycInt_InterruptActive(Handler))
+	if (MFP_Timer_IsActive(pMFP, Handler))
 	{
 		/* Find cycles passed since last interrupt */
-		MainCounter = MFP_CYCLE_TO_REG ( CycInt_FindCyclesRemaining ( Handler, INT_MFP_CYCLE ), TimerControl );
+		MainCounter = MFP_CYCLE_TO_REG ( MFP_Timer_FindCyclesRemaining ( pMFP , Handler ), TimerControl );
 //fprintf ( stderr , "mfp read CD count %d int_cyc=%d\n" , MainCounter , CycInt_FindCyclesRemaining ( Handler, INT_MFP_CYCLE ) );
 	}
 
@@ -1560,7 +1775,7 @@ static Uint8	MFP_ReadTimer_CD ( MFP_STRUCT *pMFP , Uint8 TimerControl, Uint8 Tim
 	/* if no write is made to the data reg before */
 	if ( TimerIsStopping )
 	{
-		if ( CycInt_FindCyclesRemaining ( Handler, INT_MFP_CYCLE ) < MFP_REG_TO_CYCLES ( 1 , TimerControl ) )
+		if ( MFP_Timer_FindCyclesRemaining ( pMFP , Handler ) < MFP_REG_TO_CYCLES ( 1 , TimerControl ) )
 		{
 			MainCounter = 0;			/* internal mfp counter becomes 0 (=256) */
 			LOG_TRACE(TRACE_MFP_READ , "mfp%s read CD handler=%d stopping timer while data reg between 1 and 0 : forcing data to 256\n" ,
@@ -2781,6 +2996,7 @@ void	MFP_EnableA_WriteByte ( void )
 
 	pMFP->IERA = IoMem[IoAccessCurrentAddress];
 	pMFP->IPRA &= pMFP->IERA;
+	MFP_Timer_UnparkEnabled ( pMFP );
 	MFP_UpdateIRQ ( pMFP , Cycles_GetClockCounterOnWriteAccess() );
 }
 
@@ -2813,6 +3029,7 @@ void	MFP_EnableB_WriteByte ( void )
 
 	pMFP->IERB = IoMem[IoAccessCurrentAddress];
 	pMFP->IPRB &= pMFP->IERB;
+	MFP_Timer_UnparkEnabled ( pMFP );
 	MFP_UpdateIRQ ( pMFP , Cycles_GetClockCounterOnWriteAccess() );
 }
 
@@ -3260,6 +3477,10 @@ void	MFP_TimerAData_WriteByte ( void )
 	{
 		pMFP->TA_MAINCOUNTER = pMFP->TADR;	/* Timer is off, store to main counter */
 	}
+	else						/* Timer is running, new data is used from next underflow */
+	{
+		MFP_Timer_SetParkedData ( pMFP , 0 , pMFP->TACR , pMFP->TADR );
+	}
 }
 
 /*-----------------------------------------------------------------------*/
@@ -3295,6 +3516,10 @@ void	MFP_TimerBData_WriteByte ( void )
 	{
 		pMFP->TB_MAINCOUNTER = pMFP->TBDR;	/* Timer is off, store to main counter */
 	}
+	else						/* Timer is running, new data is used from next underflow */
+	{
+		MFP_Timer_SetParkedData ( pMFP , 1 , pMFP->TBCR , pMFP->TBDR );
+	}
 }
 
 /*-----------------------------------------------------------------------*/
@@ -3330,6 +3555,10 @@ void	MFP_TimerCData_WriteByte ( void )
 	{
 		pMFP->TC_MAINCOUNTER = pMFP->TCDR;	/* Timer is off, store to main counter */
 	}
+	else						/* Timer is running, new data is used from next underflow */
+	{
+		MFP_Timer_SetParkedData ( pMFP , 2 , pMFP->TCDCR>>4 , pMFP->TCDR );
+	}
 }
 
 /*-----------------------------------------------------------------------*/
@@ -3384,6 +3613,10 @@ void	MFP_TimerDData_WriteByte ( void )
 	{
 		pMFP->TD_MAINCOUNTER = pMFP->TDDR;	/* Timer is off, store to main counter */
 	}
+	else						/* Timer is running, new data is used from next underflow */
+	{
+		MFP_Timer_SetParkedData ( pMFP , 3 , pMFP->TCDCR , pMFP->TDDR );
+	}
 }
 
 
@@ -3416,6 +3649,7 @@ static void MFP_Show(FILE *fp, MFP_STRUCT *mfp)
 	fprintf(fp, "IRQ signal:              0x%02x\n", mfp->IRQ);
 	fprintf(fp, "Input signal on Timer A: 0x%02x\n", mfp->TAI);
 	fprintf(fp, "Input signal on Timer B: 0x%02x\n", mfp->TBI);
+	fprintf(fp, "Parked timers (A-D):     0x%02x\n", mfp->TimerParked);
 }
 
 void MFP_Info(FILE *fp, Uint32 dummy)
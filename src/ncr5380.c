@@ -189,7 +189,10 @@ static int scsi_receive_data(struct scsi_data *sd, uae_u8 *b, bool next)
 		fprintf(stderr, "scsi_receive_data without length!\n");
 		return -1;
 	}
-	*b = ScsiBus.buffer[ScsiBus.offset];
+	/* wait for the host read of the sectors before the first byte */
+	if (ScsiBus.offset == 0)
+		HDC_CompleteIo(&ScsiBus);
+	*b = ScsiBus.data[ScsiBus.offset];
 	// fprintf(stderr,"scsi_receive_data %i <-> %i (%i)\n",
 	//         ScsiBus.offset, ScsiBus.data_len, next);
 	if (next) {
@@ -380,6 +383,7 @@ static uae_u8 raw_scsi_get_data_2(struct raw_scsi *rs, bool next, bool nodebug)
 		}
 		break;
 		case SCSI_SIGNAL_PHASE_STATUS:
+		HDC_CompleteIo(&ScsiBus);
 #if RAW_SCSI_DEBUG
 		if (!nodebug || next)
 			write_log(_T("raw_scsi: status byte read %02x. Next=%d\n"), ScsiBus.status, next);
@@ -575,14 +579,8 @@ static void raw_scsi_write_data(struct raw_scsi *rs, uae_u8 data)
 #endif
 			if (ScsiBus.dmawrite_to_fh)
 			{
-				int r;
-				r = fwrite(ScsiBus.buffer, 1, ScsiBus.data_len, ScsiBus.dmawrite_to_fh);
-				if (r != ScsiBus.data_len)
-				{
-					Log_Printf(LOG_ERROR, "Could not write bytes to HD image (%d/%d).\n",
-					           r, ScsiBus.data_len);
-					ScsiBus.status = HD_STATUS_ERROR;
-				}
+				/* host write runs until the status byte is read */
+				HDC_WriteImageData(&ScsiBus, ScsiBus.buffer, ScsiBus.data_len);
 				ScsiBus.dmawrite_to_fh = NULL;
 			}
 
@@ -1059,14 +1057,13 @@ void Ncr5380_UnInit(void)
 #if WITH_NCR5380
 	int i;
 
+	HDC_IoFinish(&ScsiBus.io);
+
 	for (i = 0; i < MAX_SCSI_DEVS; i++)
 	{
 		if (!ScsiBus.devs[i].enabled)
 			continue;
-		File_UnLock(ScsiBus.devs[i].image_file);
-		fclose(ScsiBus.devs[i].image_file);
-		ScsiBus.devs[i].image_file = NULL;
-		ScsiBus.devs[i].enabled = false;
+		HDC_CloseDevice(&ScsiBus.devs[i]);
 	}
 	free(ScsiBus.buffer);
 	ScsiBus.buffer = NULL;
@@ -150,6 +150,7 @@ enum {
 	OPT_IDEMASTERHDIMAGE,
 	OPT_IDESLAVEHDIMAGE,
 	OPT_IDEBYTESWAP,
+	OPT_DISKOVERLAY,
 
 	OPT_MEMSIZE,		/* memory options */
 	OPT_TT_RAM,
@@ -176,6 +177,7 @@ enum {
 	OPT_RTC_YEAR,
 	OPT_TIMERD,
 	OPT_FASTBOOT,
+	OPT_SPINLOOPS,
 
 	OPT_MICROPHONE,		/* sound options */
 	OPT_SOUND,
@@ -195,6 +197,7 @@ enum {
 	OPT_NATFEATS,
 	OPT_TRACE,
 	OPT_TRACEFILE,
+	OPT_TRACEBIN,
 	OPT_PARSE,
 	OPT_SAVECONFIG,
 	OPT_CONTROLSOCKET,
@@ -402,6 +405,8 @@ static const opt_t HatariOptions[] = {
 	  "<file>", "Emulate an IDE 1 (slave) harddrive with an image <file>" },
 	{ OPT_IDEBYTESWAP,   NULL, "--ide-swap",
 	  "<id>=<x>", "Set IDE (0/1) byte-swap option (off/on/auto)" },
+	{ OPT_DISKOVERLAY,   NULL, "--disk-overlay",
+	  "<dir>", "Write floppy/HD image changes to overlay files in <dir>" },
 
 	{ OPT_HEADER, NULL, NULL, NULL, "Memory" },
 	{ OPT_MEMSIZE,   "-s", "--memsize",
@@ -454,6 +459,8 @@ static const opt_t HatariOptions[] = {
 	  "<bool>", "Patch Timer-D (about doubles ST emulation speed)" },
 	{ OPT_FASTBOOT, NULL, "--fast-boot",
 	  "<bool>", "Patch TOS and memvalid system variables for faster boot" },
+	{ OPT_SPINLOOPS, NULL, "--skip-spinloops",
+	  "<bool>", "Skip CPU loops polling RAM until next event" },
 
 	{ OPT_HEADER, NULL, NULL, NULL, "Sound" },
 	{ OPT_MICROPHONE,   NULL, "--mic",
@@ -489,6 +496,8 @@ static const opt_t HatariOptions[] = {
 	  "<flags>", "Activate emulation tracing, see '--trace help'" },
 	{ OPT_TRACEFILE, NULL, "--trace-file",
 	  "<file>", "Save trace output to <file> (default=stderr)" },
+	{ OPT_TRACEBIN, NULL, "--trace-bin",
+	  "<file>", "Save trace events in binary form to <file>" },
 	{ OPT_PARSE, NULL, "--parse",
 	  "<file>", "Parse/execute debugger commands from <file>" },
 	{ OPT_SAVECONFIG, NULL, "--saveconfig",
@@ -1723,6 +1732,19 @@ bool Opt_ParseParameters(int argc, const char * const argv[])
 				return Opt_ShowError(OPT_IDEBYTESWAP, argv[i], "Invalid byte-swap setting");
 			break;
 
+		case OPT_DISKOVERLAY:
+			i += 1;
+			ok = Opt_StrCpy(OPT_DISKOVERLAY, false, ConfigureParams.HardDisk.szImageOverlayDir,
+					argv[i], sizeof(ConfigureParams.HardDisk.szImageOverlayDir),
+					&ConfigureParams.HardDisk.bUseImageOverlays);
+			if (ok && ConfigureParams.HardDisk.bUseImageOverlays &&
+			    !File_DirExists(ConfigureParams.HardDisk.szImageOverlayDir))
+			{
+				ConfigureParams.HardDisk.bUseImageOverlays = false;
+				return Opt_ShowError(OPT_DISKOVERLAY, argv[i], "Given directory doesn't exist");
+			}
+			break;
+
 			/* Memory options */
 		case OPT_MEMSIZE:
 			memsize = atoi(argv[++i]);
@@ -1937,6 +1959,10 @@ bool Opt_ParseParameters(int argc, const char * const argv[])
 			ok = Opt_Bool(argv[++i], OPT_FASTBOOT, &ConfigureParams.System.bFastBoot);
 			break;
 
+		case OPT_SPINLOOPS:
+			ok = Opt_Bool(argv[++i], OPT_SPINLOOPS, &ConfigureParams.System.bSkipSpinLoops);
+			break;
+
 		case OPT_DSP:
 			i += 1;
 			if (strcasecmp(argv[i], "none") == 0 || strcasecmp(argv[i], "off") == 0)
@@ -2193,6 +2219,13 @@ bool Opt_ParseParameters(int argc, const char * const argv[])
 					NULL);
 			break;
 
+		case OPT_TRACEBIN:
+			i += 1;
+			ok = Opt_StrCpy(OPT_TRACEBIN, false, ConfigureParams.Log.sTraceBinFileName,
+					argv[i], sizeof(ConfigureParams.Log.sTraceBinFileName),
+					NULL);
+			break;
+
 		case OPT_CONTROLSOCKET:
 			i += 1;
 			errstr = Control_SetSocket(argv[i]);
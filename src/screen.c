@@ -107,12 +107,85 @@ static SDL_Renderer *sdlRenderer;
 static SDL_Texture *sdlTexture;
 static bool bUseSdlRenderer;            /* true when using SDL2 renderer */
 static bool bIsSoftwareRenderer;
+static bool bTextureNeedsFullUpdate;    /* true when texture content is undefined */
+
+/**
+ * Upload the screen surface to the window texture. Like with the window
+ * surface, only the areas given in 'rects' are updated (the texture keeps
+ * its content for the other areas), except after the texture was created
+ * or its content was lost.
+ */
+static void Screen_UpdateTexture(SDL_Surface *screen, int numrects, SDL_Rect *rects)
+{
+	int i, x1, y1, x2, y2;
+	SDL_Rect bbox;
+
+	if (bTextureNeedsFullUpdate)
+	{
+		SDL_UpdateTexture(sdlTexture, NULL, screen->pixels, screen->pitch);
+		bTextureNeedsFullUpdate = false;
+		return;
+	}
+
+	/* Upload the bounding box of all the rects in one go */
+	x1 = screen->w; y1 = screen->h;
+	x2 = y2 = 0;
+	for (i = 0; i < numrects; i++)
+	{
+		if (rects[i].w <= 0 || rects[i].h <= 0)
+			continue;
+		if (rects[i].x < x1)
+			x1 = rects[i].x;
+		if (rects[i].y < y1)
+			y1 = rects[i].y;
+		if (rects[i].x + rects[i].w > x2)
+			x2 = rects[i].x + rects[i].w;
+		if (rects[i].y + rects[i].h > y2)
+			y2 = rects[i].y + rects[i].h;
+	}
+	if (x1 < 0)
+		x1 = 0;
+	if (y1 < 0)
+		y1 = 0;
+	if (x2 > screen->w)
+		x2 = screen->w;
+	if (y2 > screen->h)
+		y2 = screen->h;
+	if (x1 >= x2 || y1 >= y2)
+		return;				/* nothing changed */
+
+	bbox.x = x1;
+	bbox.y = y1;
+	bbox.w = x2 - x1;
+	bbox.h = y2 - y1;
+	SDL_UpdateTexture(sdlTexture, &bbox,
+	                  (Uint8 *)screen->pixels + y1 * screen->pitch
+	                  + x1 * screen->format->BytesPerPixel,
+	                  screen->pitch);
+}
+
+/**
+ * Upload whole screen surface to the window texture on next update,
+ * after its content got lost (window resize, renderer reset).  If the
+ * renderer device was reset, the texture itself needs to be re-created.
+ */
+void Screen_SetTextureFullUpdate(bool bRecreate)
+{
+	int win_width, win_height;
+
+	if (bRecreate && sdlWindow && sdlscrn)
+	{
+		SDL_GetWindowSize(sdlWindow, &win_width, &win_height);
+		Screen_SetTextureScale(sdlscrn->w, sdlscrn->h, win_width, win_height, true);
+	}
+	bTextureNeedsFullUpdate = true;
+}
 
 void SDL_UpdateRects(SDL_Surface *screen, int numrects, SDL_Rect *rects)
 {
 	if (bUseSdlRenderer)
 	{
-		SDL_UpdateTexture(sdlTexture, NULL, screen->pixels, screen->pitch);
+		Screen_UpdateTexture(screen, numrects, rects);
 		/* Need to clear the renderer context for certain accelerated cards */
 		if (!bIsSoftwareRenderer)
 			SDL_RenderClear(sdlRenderer);
@@ -372,6 +445,7 @@ void Screen_SetTextureScale(int width, int height, int win_width, int win_height
 		sdlTexture = SDL_CreateTexture(sdlRenderer, pfmt,
 					       SDL_TEXTUREACCESS_STREAMING,
 					       width, height);
+		bTextureNeedsFullUpdate = true;
 		if (!sdlTexture)
 		{
 			fprintf(stderr, "ERROR: Failed to create %dx%d@%d texture!\n",
@@ -822,6 +896,7 @@ void Screen_SetFullUpdate(void)
 {
 	/* Update frame buffers */
 	FrameBuffer.bFullUpdate = true;
+	ScreenConv_SetFullUpdate();
 }
 
 
@@ -831,6 +906,7 @@ void Screen_SetFullUpdate(void)
  */
 static void Screen_ClearScreen(void)
 {
+	ScreenConv_SetFullUpdate();
 	SDL_FillRect(sdlscrn, &STScreenRect, SDL_MapRGB(sdlscrn->format, 0, 0, 0));
 }
 
@@ -1455,9 +1531,15 @@ void Screen_GenConvUpdate(SDL_Rect *extra, bool forced)
 		return;
 
 	rects[0] = STScreenRect;
+	/* Only update the lines changed by the last conversion */
+	if (!forced)
+	{
+		ScreenConv_ClipUpdateRect(&rects[0]);
+		if (rects[0].h == 0)
+			count = 0;
+	}
 	if (extra) {
-		rects[1] = *extra;
-		count = 2;
+		rects[count++] = *extra;
 	}
 	SDL_UpdateRects(sdlscrn, count, rects);
 }
@@ -5,6 +5,7 @@
   or at your option any later version. Read the file gpl.txt for details.
 */
 
+#include <limits.h>
 #include <SDL_endian.h>
 #include "main.h"
 #include "configuration.h"
@@ -32,6 +33,30 @@ static bool bTTSampleHold = false;		/* TT special video mode */
 static int nSampleHoldIdx;
 static uint32_t nScreenBaseAddr;		/* address of screen in STRam */
 
+/* In hi-color mode, we keep a copy of the Atari lines converted during the */
+/* previous frame and we only convert the lines that changed since then */
+static struct
+{
+	Uint16 *lines;			/* copy of the previous frame's lines */
+	int size;			/* number of words allocated in 'lines' */
+	bool valid;			/* false if all the lines must be converted */
+	Uint8 *hvram;			/* host screen address used for the previous frame */
+	int pitch, bpp;
+	int vw, vh;
+	int leftBorder, upperBorder;
+	Uint32 border;			/* border color */
+	int dirty_y1, dirty_y2;		/* host lines changed by last conversion */
+	bool dirty_valid;		/* false if whole screen must be updated */
+} hicolor_cache;
+
+/* Hi-color word (as read from STRam, in big endian) to 32 bpp host color */
+static struct
+{
+	Uint32 native[0x10000];
+	bool valid;
+	Uint32 Rmask, Gmask, Bmask, Amask;
+} hicolor_table;
+
 
 /* TOS palette (bpp < 16) to SDL color mapping */
 static struct
@@ -60,6 +85,53 @@ void Screen_RemapPalette(void)
 	for(i = 0; i < 256; i++, native++, standard++) {
 		*native = SDL_MapRGB(fmt, standard->r, standard->g, standard->b);
 	}
+
+	/* Surface format could have changed */
+	hicolor_table.valid = false;
+	ScreenConv_SetFullUpdate();
+}
+
+/**
+ * Force a complete conversion of the screen on next frame (when the
+ * host screen was modified or could have been modified by something else)
+ */
+void ScreenConv_SetFullUpdate(void)
+{
+	hicolor_cache.valid = false;
+}
+
+/**
+ * Restrict the host screen area to update to the lines that were
+ * changed by the last conversion (if known). Only valid once : next
+ * calls will update the whole area until the next conversion.
+ */
+void ScreenConv_ClipUpdateRect(SDL_Rect *rect)
+{
+	int y1, y2;
+
+	if (!hicolor_cache.dirty_valid)
+		return;
+	hicolor_cache.dirty_valid = false;
+
+	y1 = hicolor_cache.dirty_y1 > rect->y ? hicolor_cache.dirty_y1 : rect->y;
+	y2 = hicolor_cache.dirty_y2 < rect->y + rect->h ? hicolor_cache.dirty_y2 : rect->y + rect->h;
+	if (y2 < y1)
+		y2 = y1;
+	rect->y = y1;
+	rect->h = y2 - y1;
+}
+
+/**
+ * Add host line 'hvram_line' to the lines changed by the current conversion
+ */
+static inline void ScreenConv_HiColorSetDirty(void *hvram_line)
+{
+	int y = ((Uint8 *)hvram_line - (Uint8 *)sdlscrn->pixels) / sdlscrn->pitch;
+
+	if (y < hicolor_cache.dirty_y1)
+		hicolor_cache.dirty_y1 = y;
+	if (y + 1 > hicolor_cache.dirty_y2)
+		hicolor_cache.dirty_y2 = y + 1;
 }
 
 void ScreenConv_MemorySnapShot_Capture(bool bSave)
@@ -470,6 +542,109 @@ static void ScreenConv_BitplaneTo32bppNoZoom(Uint16 *fvram_line, Uint8 *hvram,
 	}
 }
 
+/**
+ * Check that the lines of the previous frame can be compared with the
+ * lines of this frame (same size and same place on the host screen).
+ * Return false if the cache can't be used at all.
+ */
+static bool ScreenConv_HiColorCacheCheck(Uint8 *hvram, int vw, int vh,
+                                         int leftBorder, int upperBorder)
+{
+	int size = vw * vh;
+
+	/* If we can't tell which lines changed, the whole screen will be updated */
+	hicolor_cache.dirty_valid = false;
+	hicolor_cache.dirty_y1 = INT_MAX;
+	hicolor_cache.dirty_y2 = 0;
+
+	if (size > hicolor_cache.size)
+	{
+		Uint16 *lines = realloc(hicolor_cache.lines, size * sizeof(Uint16));
+		if (!lines)
+		{
+			free(hicolor_cache.lines);
+			hicolor_cache.lines = NULL;
+			hicolor_cache.size = 0;
+			hicolor_cache.valid = false;
+			return false;
+		}
+		hicolor_cache.lines = lines;
+		hicolor_cache.size = size;
+		hicolor_cache.valid = false;
+	}
+
+	if (hvram != hicolor_cache.hvram || sdlscrn->pitch != hicolor_cache.pitch
+	    || sdlscrn->format->BytesPerPixel != hicolor_cache.bpp
+	    || vw != hicolor_cache.vw || vh != hicolor_cache.vh
+	    || leftBorder != hicolor_cache.leftBorder
+	    || upperBorder != hicolor_cache.upperBorder
+	    || palette.native[0] != hicolor_cache.border)
+	{
+		hicolor_cache.hvram = hvram;
+		hicolor_cache.pitch = sdlscrn->pitch;
+		hicolor_cache.bpp = sdlscrn->format->BytesPerPixel;
+		hicolor_cache.vw = vw;
+		hicolor_cache.vh = vh;
+		hicolor_cache.leftBorder = leftBorder;
+		hicolor_cache.upperBorder = upperBorder;
+		hicolor_cache.border = palette.native[0];
+		hicolor_cache.valid = false;
+	}
+
+	return true;
+}
+
+/**
+ * Return true if line 'h' changed since previous frame and must be converted.
+ * The copy of the line is updated at the same time.
+ */
+static inline bool ScreenConv_HiColorLineChanged(bool use_cache, int h,
+                                                 Uint16 *fvram_line, int vw)
+{
+	Uint16 *copy_line;
+
+	if (!use_cache)
+		return true;
+
+	copy_line = hicolor_cache.lines + h * vw;
+	if (hicolor_cache.valid && memcmp(copy_line, fvram_line, vw << 1) == 0)
+		return false;
+
+	memcpy(copy_line, fvram_line, vw << 1);
+	return true;
+}
+
+/**
+ * Build the table to convert hi-color words to the host's 32 bpp format.
+ * The table is indexed by the word as read from STRam, so it also takes
+ * care of the endianness conversion.
+ */
+static void ScreenConv_HiColorUpdateTable(void)
+{
+	SDL_PixelFormat *fmt = sdlscrn->format;
+	Uint32 i;
+
+	if (hicolor_table.valid && hicolor_table.Rmask == fmt->Rmask
+	    && hicolor_table.Gmask == fmt->Gmask && hicolor_table.Bmask == fmt->Bmask
+	    && hicolor_table.Amask == fmt->Amask)
+		return;
+
+	for (i = 0; i < 0x10000; i++)
+	{
+		Uint16 srcword = SDL_SwapBE16(i);
+		Uint8 r = ((srcword >> 8) & 0xf8) | (srcword >> 13);
+		Uint8 g = ((srcword >> 3) & 0xfc) | ((srcword >> 9) & 0x3);
+		Uint8 b = (srcword << 3) | ((srcword >> 2) & 0x07);
+		hicolor_table.native[i] = SDL_MapRGB(fmt, r, g, b);
+	}
+
+	hicolor_table.Rmask = fmt->Rmask;
+	hicolor_table.Gmask = fmt->Gmask;
+	hicolor_table.Bmask = fmt->Bmask;
+	hicolor_table.Amask = fmt->Amask;
+	hicolor_table.valid = true;
+}
+
 static void ScreenConv_HiColorTo16bppNoZoom(Uint16 *fvram_line, Uint8 *hvram,
                                             int scrwidth, int scrheight,
                                             int vw, int vh, int vbpp,
@@ -481,6 +656,7 @@ static void ScreenConv_HiColorTo16bppNoZoom(Uint16 *fvram_line, Uint8 *hvram,
 	uint32_t nLineEndAddr = nScreenBaseAddr + nextline * 2;
 	int pitch = sdlscrn->pitch >> 1;
 	int h;
+	bool use_cache = ScreenConv_HiColorCacheCheck(hvram, vw, vh, leftBorder, upperBorder);
 
 	/* Render the upper border */
 	for (h = 0; h < upperBorder; h++)
@@ -502,6 +678,8 @@ static void ScreenConv_HiColorTo16bppNoZoom(Uint16 *fvram_line, Uint8 *hvram,
 		{
 			Screen_memset_uint16(hvram_line, palette.native[0], pitch);
 			hvram_line += pitch;
+			use_cache = false;
+			hicolor_cache.valid = false;
 			continue;
 		}
 
@@ -509,6 +687,14 @@ static void ScreenConv_HiColorTo16bppNoZoom(Uint16 *fvram_line, Uint8 *hvram,
 		Screen_memset_uint16(hvram_column, palette.native[0], leftBorder);
 		hvram_column += leftBorder;
 
+		/* Graphical area, only if it changed since previous frame */
+		if (!ScreenConv_HiColorLineChanged(use_cache, h, fvram_line, vw))
+		{
+			hvram_column += vw;
+		}
+		else
+		{
+			ScreenConv_HiColorSetDirty(hvram_line);
 #if SDL_BYTEORDER == SDL_BIG_ENDIAN
 		/* FIXME: here might be a runtime little/big video endian switch like:
 		 * if ( " videocard memory in Motorola endian format " false)
@@ -517,10 +703,10 @@ static void ScreenConv_HiColorTo16bppNoZoom(Uint16 *fvram_line, Uint8 *hvram,
 		hvram_column += vw;
 #else
 		fvram_column = fvram_line;
-		/* Graphical area */
 		for (w = 0; w < vw; w++)
 			*hvram_column ++ = SDL_SwapBE16(*fvram_column++);
 #endif /* SDL_BYTEORDER == SDL_BIG_ENDIAN */
+		}
 
 		/* Right border */
 		Screen_memset_uint16(hvram_column, palette.native[0], rightBorder);
@@ -536,6 +722,14 @@ static void ScreenConv_HiColorTo16bppNoZoom(Uint16 *fvram_line, Uint8 *hvram,
 		Screen_memset_uint16(hvram_line, palette.native[0], scrwidth);
 		hvram_line += pitch;
 	}
+
+	if (use_cache)
+	{
+		/* Borders are always drawn with the same color, only the */
+		/* graphical area's changed lines need to be updated */
+		hicolor_cache.dirty_valid = hicolor_cache.valid;
+		hicolor_cache.valid = true;
+	}
 }
 
 static void ScreenConv_HiColorTo32bppNoZoom(Uint16 *fvram_line, Uint8 *hvram,
@@ -549,6 +743,10 @@ static void ScreenConv_HiColorTo32bppNoZoom(Uint16 *fvram_line, Uint8 *hvram,
 	uint32_t nLineEndAddr = nScreenBaseAddr + nextline * 2;
 	int pitch = sdlscrn->pitch >> 2;
 	int h, w;
+	bool use_cache = ScreenConv_HiColorCacheCheck(hvram, vw, vh, leftBorder, upperBorder);
+	const Uint32 *native = hicolor_table.native;
+
+	ScreenConv_HiColorUpdateTable();
 
 	/* Render the upper border */
 	for (h = 0; h < upperBorder; h++)
@@ -567,6 +765,8 @@ static void ScreenConv_HiColorTo32bppNoZoom(Uint16 *fvram_line, Uint8 *hvram,
 		{
 			Screen_memset_uint32(hvram_line, palette.native[0], pitch);
 			hvram_line += pitch;
+			use_cache = false;
+			hicolor_cache.valid = false;
 			continue;
 		}
 
@@ -574,14 +774,16 @@ static void ScreenConv_HiColorTo32bppNoZoom(Uint16 *fvram_line, Uint8 *hvram,
 		Screen_memset_uint32(hvram_column, palette.native[0], leftBorder);
 		hvram_column += leftBorder;
 
-		/* Graphical area */
-		for (w = 0; w < vw; w++)
+		/* Graphical area, only if it changed since previous frame */
+		if (!ScreenConv_HiColorLineChanged(use_cache, h, fvram_line, vw))
+		{
+			hvram_column += vw;
+		}
+		else
 		{
-			Uint16 srcword = SDL_SwapBE16(*fvram_column++);
-			Uint8 r = ((srcword >> 8) & 0xf8) | (srcword >> 13);
-			Uint8 g = ((srcword >> 3) & 0xfc) | ((srcword >> 9) & 0x3);
-			Uint8 b = (srcword << 3) | ((srcword >> 2) & 0x07);
-			*hvram_column ++ = SDL_MapRGB(sdlscrn->format, r, g, b);
+			ScreenConv_HiColorSetDirty(hvram_line);
+			for (w = 0; w < vw; w++)
+				*hvram_column ++ = native[*fvram_column++];
 		}
 
 		/* Right border */
@@ -598,6 +800,14 @@ static void ScreenConv_HiColorTo32bppNoZoom(Uint16 *fvram_line, Uint8 *hvram,
 		Screen_memset_uint32(hvram_line, palette.native[0], scrwidth);
 		hvram_line += pitch;
 	}
+
+	if (use_cache)
+	{
+		/* Borders are always drawn with the same color, only the */
+		/* graphical area's changed lines need to be updated */
+		hicolor_cache.dirty_valid = hicolor_cache.valid;
+		hicolor_cache.valid = true;
+	}
 }
 
 static void Screen_ConvertWithoutZoom(Uint16 *fvram, int vw, int vh, int vbpp, int nextline,
@@ -668,6 +878,7 @@ static void Screen_ConvertWithoutZoom(Uint16 *fvram, int vw, int vh, int vbpp, i
 	/* render the graphic area */
 	if (vbpp < 16) {
 		/* Bitplanes modes */
+		ScreenConv_SetFullUpdate();
 		switch (nBytesPerPixel)
 		{
 		 case 2:
@@ -1141,8 +1352,10 @@ void Screen_GenConvert(uint32_t vaddr, void *fvram, int vw, int vh,
                        int upperBorderSize, int lowerBorderSize)
 {
 	nScreenBaseAddr = vaddr;
+	hicolor_cache.dirty_valid = false;
 
 	if (nScreenZoomX * nScreenZoomY != 1) {
+		ScreenConv_SetFullUpdate();
 		Screen_ConvertWithZoom(fvram, vw, vh, vbpp, nextline, hscroll,
 		                       leftBorderSize, rightBorderSize,
 		                       upperBorderSize, lowerBorderSize);
@@ -1159,6 +1372,10 @@ bool Screen_GenDraw(uint32_t vaddr, int vw, int vh, int vbpp, int nextline,
 {
 	int hscrolloffset;
 
+	/* Lines that didn't change are not converted again, so restore */
+	/* the area potentially left under the overlay led */
+	Statusbar_OverlayRestore(sdlscrn);
+
 	if (ConfigureParams.Screen.DisableVideo || !Screen_Lock())
 		return false;
 
@@ -1171,6 +1388,7 @@ bool Screen_GenDraw(uint32_t vaddr, int vw, int vh, int vbpp, int nextline,
 	                  leftBorder, rightBorder, upperBorder, lowerBorder);
 
 	Screen_UnLock();
+	Statusbar_OverlayBackup(sdlscrn);
 	Screen_GenConvUpdate(Statusbar_Update(sdlscrn, false), false);
 	return true;
 }
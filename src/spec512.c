@@ -17,6 +17,13 @@
   palette with each change. As the table is already ordered this makes things
   very simple. Speed is a problem, though, as the palette can change once every
   4 pixels - that's a lot of processing.
+
+  To limit this, the parts of a line that are not displayed (before the first
+  displayed pixel and after the last one) are not scanned 4 cycles at a time :
+  we directly jump from one palette change to the next one in the table.
+  In the displayed part, the converters check once per 16 pixels whether the
+  next palette change in the table falls within them. If not, the 16 pixels
+  are plotted with the current palette like in normal low/med res.
 */
 
 
@@ -103,6 +110,8 @@ static int CycleColourIndex;
 static int nScanLine, ScanLineCycleCount;
 static bool bIsSpec512Display;
 
+static void Spec512_UpdatePaletteUntil(int CycleEnd);
+
 #if SDL_BYTEORDER == SDL_BIG_ENDIAN
 static const int STRGBPalEndianTable[16] =
 {
@@ -278,9 +287,9 @@ void Spec512_ScanWholeLine(void)
 	/* Ready for next scan line */
 	nScanLine++;
 
-	/* Update palette entries until we reach start of displayed screen */
+	/* Read whole line of palettes and update 'STRGBPalette' */
 	ScanLineCycleCount = 0;
-	Spec512_EndScanLine();        /* Read whole line of palettes and update 'STRGBPalette' */
+	Spec512_EndScanLine();
 }
 
 
@@ -290,8 +299,8 @@ void Spec512_ScanWholeLine(void)
  */
 void Spec512_StartScanLine(void)
 {
-	int i;
 	int LineStartCycle;
+	int nSpans;
 
 	/* Store pointer to line of palette cycle writes */
 	pCyclePalette = &CyclePalettes[nScanLine*MAX_CYCLEPALETTES_PERLINE];
@@ -304,13 +313,16 @@ void Spec512_StartScanLine(void)
 		LineStartCycle = LINE_START_CYCLE_60;			/* The screen was 60 Hz */
 
 	/* Update palette entries until we reach start of displayed screen */
-	ScanLineCycleCount = 0;
-	for (i=0; i<((LineStartCycle-SCREENBYTES_LEFT*2)/4 + 7); i++)	/* [NP] '7' is required to align pixels and colors */
-		Spec512_UpdatePaletteSpan();              /* Update palette for this 4-cycle period */
-
+	/* [NP] '7' is required to align pixels and colors */
 	/* And skip for left border is not using overscan display to user */
-	for (i=0; i<(STScreenLeftSkipBytes/2); i++)   /* Eg, 16 bytes = 32 pixels or 8 palette periods */
-		Spec512_UpdatePaletteSpan();
+	/* (eg, 16 bytes = 32 pixels or 8 palette periods) */
+	nSpans = (LineStartCycle-SCREENBYTES_LEFT*2)/4 + 7;
+	if ( nSpans < 0 )
+		nSpans = 0;
+	nSpans += STScreenLeftSkipBytes/2;
+
+	ScanLineCycleCount = 0;
+	Spec512_UpdatePaletteUntil ( nSpans * 4 );
 }
 
 
@@ -324,8 +336,59 @@ void Spec512_EndScanLine(void)
 
 	CycleEnd >>= nCpuFreqShift;			/* Convert cycle position to 8 MHz equivalent */
 	/* Continue to reads palette until complete so have correct version for next line */
-	while (ScanLineCycleCount < CycleEnd)
-		Spec512_UpdatePaletteSpan();
+	Spec512_UpdatePaletteUntil ( ( CycleEnd + 3 ) & ~3 );
+}
+
+
+/*-----------------------------------------------------------------------*/
+/**
+ * Update 'STRGBPalette' with all the palette changes of the current line
+ * until cycle 'CycleEnd' (must be a multiple of 4). This gives the same
+ * result as calling Spec512_UpdatePaletteSpan() until ScanLineCycleCount
+ * reaches CycleEnd, but we directly go from one palette change to the next.
+ */
+static void Spec512_UpdatePaletteUntil(int CycleEnd)
+{
+	/* Entries are ordered and on different 4 cycles slots ; an entry that */
+	/* is not on a 4 cycles slot ahead of ScanLineCycleCount (or the '-1' */
+	/* terminator) will never be reached by Spec512_UpdatePaletteSpan() */
+	while ( ( pCyclePalette->LineCycles >= ScanLineCycleCount )
+		&& ( pCyclePalette->LineCycles < CycleEnd )
+		&& ( ( pCyclePalette->LineCycles & 3 ) == 0 ) )
+	{
+		ScanLineCycleCount = pCyclePalette->LineCycles + 4;
+
+#if SDL_BYTEORDER == SDL_BIG_ENDIAN
+		STRGBPalette[STRGBPalEndianTable[pCyclePalette->Index]] = ST2RGB[pCyclePalette->Colour];
+#else
+		STRGBPalette[pCyclePalette->Index] = ST2RGB[pCyclePalette->Colour];
+#endif
+		pCyclePalette += 1;
+	}
+
+	if ( ScanLineCycleCount < CycleEnd )
+		ScanLineCycleCount = CycleEnd;
+}
+
+
+/*-----------------------------------------------------------------------*/
+/**
+ * If none of the next 'nSpans' calls to Spec512_UpdatePaletteSpan() would
+ * update the palette, skip them and return true. Else return false and
+ * leave the spans to be updated one by one.
+ */
+bool Spec512_SkipPaletteSpans(int nSpans)
+{
+	int CycleEnd = ScanLineCycleCount + nSpans * 4;
+
+	/* Same check as in Spec512_UpdatePaletteUntil() */
+	if ( ( pCyclePalette->LineCycles >= ScanLineCycleCount )
+		&& ( pCyclePalette->LineCycles < CycleEnd )
+		&& ( ( pCyclePalette->LineCycles & 3 ) == 0 ) )
+		return false;
+
+	ScanLineCycleCount = CycleEnd;
+	return true;
 }
 
 
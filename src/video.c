@@ -717,6 +717,7 @@ static void	Video_ClearOnVBL(void);
 
 static void	Video_AddInterrupt ( int Line , int PosCycles , interrupt_id Handler );
 static void	Video_AddInterruptHBL ( int Line , int Pos );
+static bool	Video_TimerB_EventCountActive ( void );
 
 static void	Video_ColorReg_WriteWord(void);
 static void	Video_ColorReg_ReadWord(void);
@@ -3298,7 +3299,10 @@ if ( CycInt_From_Opcode )		/* TEMP : to update CYCLES_COUNTER_VIDEO during an op
 		return;
 
 	/* Generate new Endline, if need to - there are 313 HBLs per frame */
-	if (nHBL < nScanlinesPerFrame-1)
+	/* If no timer B is in event count mode, the EndLine interrupt has nothing to do, */
+	/* so we don't restart it ; Video_RestartInterruptTimerB() will restart it when */
+	/* a timer B is set to event count mode */
+	if ( ( nHBL < nScanlinesPerFrame-1 ) && Video_TimerB_EventCountActive() )
 	{
 		/* By default, next EndLine's int will be on line nHBL+1 at pos 376+24 or 372+24 */
 		if ( ( IoMem[0xfffa03] & ( 1 << 3 ) ) == 0 )		/* count end of line */
@@ -4459,6 +4463,48 @@ void Video_AddInterruptTimerB ( int LineVideo , int CycleVideo , int Pos )
 }
 
 
+/**
+ * Return true if timer B is in event count mode on the main MFP or on the TT MFP,
+ * which means EndLine interrupts are needed to count the DE signal's transitions
+ */
+static bool Video_TimerB_EventCountActive ( void )
+{
+	if ( pMFP_Main->TBCR == 8 )
+		return true;
+
+	if ( Config_IsMachineTT() && ( pMFP_TT->TBCR == 8 ) )
+		return true;
+
+	return false;
+}
+
+
+/**
+ * Restart the EndLine interrupt for timer B when a timer B is set to event
+ * count mode. The EndLine interrupt is not restarted on each line when no
+ * timer B is in event count mode (see Video_InterruptHandler_EndLine()),
+ * so we need to add it again on the current line (or the next one if
+ * the position was already reached).
+ */
+void Video_RestartInterruptTimerB ( void )
+{
+	int FrameCycles, HblCounterVideo, LineCycles;
+
+	if ( CycInt_InterruptActive ( INTERRUPT_VIDEO_ENDLINE ) )
+		return;					/* EndLine interrupt is still running */
+
+	Video_GetPosition ( &FrameCycles , &HblCounterVideo , &LineCycles );
+	if ( HblCounterVideo >= nScanlinesPerFrame )
+		return;					/* Video_StartInterrupts() will add it on next VBL */
+
+	LineTimerBPos = Video_TimerB_GetPos ( HblCounterVideo );
+	Video_AddInterruptTimerB ( HblCounterVideo , LineCycles , LineTimerBPos );
+
+	LOG_TRACE ( TRACE_VIDEO_HBL , "restart EndLine TB %d video_cyc=%d line_cyc=%d pos=%d\n" ,
+		nHBL , FrameCycles , LineCycles , LineTimerBPos );
+}
+
+
 /**
  * Add some video interrupts to handle the first HBL and the first Timer B
  * in a new VBL. Also add an interrupt to trigger the next VBL.
@@ -36,6 +36,8 @@ scsifile="$testdir"/scsi.img
 dd if=/dev/zero of="$scsifile" bs=512 count=1000 2> /dev/null
 idefile="$testdir"/ide.img
 dd if=/dev/zero of="$idefile" bs=512 count=1000 2> /dev/null
+overlaydir="$testdir"/overlay
+mkdir "$overlaydir"
 
 export HATARI_TEST=configfile
 export SDL_VIDEODRIVER=dummy
@@ -47,8 +49,10 @@ $hatari --log-level fatal --sound off --tos none --confirm-quit false \
 	--machine tt --cpulevel 4 --cpuclock 16 --vdi 1 --drive-led 0 \
 	--monitor tv --frameskips 3 --mousewarp off --statusbar FALSE \
 	--disasm uae --joy0 keys --keymap "$keymap" --crop 1 --fast-boot 1 \
+	--skip-spinloops on \
 	--protect-floppy auto --gemdos-case upper --acsi 3="$acsifile" \
 	--scsi 5="$scsifile" --ide-master "$idefile" --patch-tos off \
+	--disk-overlay "$overlaydir" \
 	--rs232-out "$testdir"/serial-out.txt --rs232-in /dev/null \
 	--printer /dev/zero --avi-fps 60 --memsize 0 --alert-level fatal \
 	--saveconfig >"$testdir/out.txt" 2>&1
@@ -70,6 +74,7 @@ grep "bConfirmQuit = FALSE" "$cfgfile" || exit 1
 grep "nModelType = 4" "$cfgfile" || exit 1
 grep "nCpuLevel = 4" "$cfgfile" || exit 1
 grep "nCpuFreq = 16" "$cfgfile" || exit 1
+grep "bSkipSpinLoops = TRUE" "$cfgfile" || exit 1
 grep "bUseExtVdiResolutions = TRUE" "$cfgfile" || exit 1
 grep "bShowDriveLed = FALSE" "$cfgfile" || exit 1
 grep "nMonitorType = 3" "$cfgfile" || exit 1
@@ -85,6 +90,8 @@ grep "nGemdosCase = 1" "$cfgfile" || exit 1
 grep "sDeviceFile3 = $acsifile" "$cfgfile" || exit 1
 grep "sDeviceFile5 = $scsifile" "$cfgfile" || exit 1
 grep "sDeviceFile0 = $idefile" "$cfgfile" || exit 1
+grep "bUseImageOverlays = TRUE" "$cfgfile" || exit 1
+grep "szImageOverlayDir = $overlaydir" "$cfgfile" || exit 1
 grep "bPatchTos = FALSE" "$cfgfile" || exit 1
 grep "bEnableRS232 = TRUE" "$cfgfile" || exit 1
 grep "szOutFileName = $testdir/serial-out.txt" "$cfgfile" || exit 1
@@ -0,0 +1,79 @@
+#!/bin/sh
+#
+# Script to compare CPU emulation speed of two Hatari builds, e.g.
+# before and after building it with the opcode counts / profile data
+# (see PGO_MODE and OPCODE_COUNTS_FILE in top level CMakeLists.txt).
+#
+# Give the same Hatari arguments that were used when collecting
+# the profile data, e.g. the same TOS, machine type and autostarted
+# program.  Test should be long enough for the speed to stabilize.
+
+if [ $# -lt 2 ] || [ "$1" = "-h" ] || [ "$1" = "--help" ]; then
+	echo "usage: ${0##*/} <hatari before> <hatari after> [VBLs] [other Hatari args, e.g. --tos <image>]"
+	exit 1
+fi
+
+before=$1
+after=$2
+shift 2
+for hatari in "$before" "$after"; do
+	if [ ! -x "$hatari" ]; then
+		echo "ERROR: '$hatari' is not a valid Hatari executable!"
+		exit 1
+	fi
+done
+
+vbls=2000
+if [ $# -gt 0 ] && [ "$1" -eq "$1" ] 2>/dev/null; then
+	vbls=$1
+	shift
+fi
+
+# how many times each binary is run, best result is used
+rounds=3
+
+testdir=$(mktemp -d)
+
+remove_temp() {
+  rm -rf "$testdir"
+}
+trap remove_temp EXIT
+
+export SDL_VIDEODRIVER=dummy
+export SDL_AUDIODRIVER=dummy
+
+# run given Hatari binary, output the emulation speed it reports on exit
+run_speed() {
+	HOME="$testdir" $1 --log-level info --sound off --benchmark \
+		--run-vbls $vbls $args \
+		2>&1 | sed -n 's/^.*SPEED: \([0-9.]*\) VBL\/s.*$/\1/p' | tail -1
+}
+
+# output best speed from $rounds runs of given Hatari binary
+best_speed() {
+	best=""
+	i=0
+	while [ $i -lt $rounds ]; do
+		speed=$(run_speed "$1")
+		if [ -z "$speed" ]; then
+			echo "ERROR: running '$1' failed, or it didn't report its speed!" 1>&2
+			return
+		fi
+		best=$(echo "$best $speed" | awk '{print ($1 > $2 ? $1 : $2)}')
+		i=$((i+1))
+	done
+	echo "$best"
+}
+
+args="$*"
+speed1=$(best_speed "$before")
+speed2=$(best_speed "$after")
+if [ -z "$speed1" ] || [ -z "$speed2" ]; then
+	exit 1
+fi
+
+printf "%-24s %10s\n" "Hatari build" "VBL/s"
+printf "%-24s %10s\n" "before" "$speed1"
+printf "%-24s %10s\n" "after" "$speed2"
+echo
+printf "Speedup: %.2fx\n" "$(echo "$speed1 $speed2" | awk '{print $2 / $1}')"
@@ -0,0 +1,72 @@
+#!/bin/sh
+#
+# Script to measure how much each of the per-instruction CPU debugging
+# features (profiling, history, breakpoints) slows down emulation.
+
+if [ $# -lt 1 ] || [ "$1" = "-h" ] || [ "$1" = "--help" ]; then
+	echo "usage: ${0##*/} <hatari> [VBLs] [other Hatari args, e.g. --tos <image>]"
+	exit 1
+fi
+
+hatari=$1
+shift
+if [ ! -x "$hatari" ]; then
+	echo "ERROR: first parameter must point to valid Hatari executable!"
+	exit 1
+fi
+
+vbls=1000
+if [ $# -gt 0 ] && [ "$1" -eq "$1" ] 2>/dev/null; then
+	vbls=$1
+	shift
+fi
+
+testdir=$(mktemp -d)
+
+remove_temp() {
+  rm -rf "$testdir"
+}
+trap remove_temp EXIT
+
+export SDL_VIDEODRIVER=dummy
+export SDL_AUDIODRIVER=dummy
+
+# run Hatari with debugger commands given as arguments,
+# output the emulation speed it reports on exit
+run_speed() {
+	printf "%s\n" "$@" > "$testdir/debug.ini"
+	HOME="$testdir" $hatari --log-level info --sound off --benchmark \
+		--run-vbls $vbls --parse "$testdir/debug.ini" $args \
+		2>&1 | sed -n 's/^.*SPEED: \([0-9.]*\) VBL\/s.*$/\1/p' | tail -1
+}
+
+args="$*"
+base=$(run_speed "")
+if [ -z "$base" ]; then
+	echo "ERROR: running Hatari failed, or it didn't report its speed!"
+	exit 1
+fi
+
+echo "Speed without debugging: $base VBL/s"
+echo
+printf "%-24s %10s %10s\n" "Debug feature" "VBL/s" "slowdown"
+
+# address which should never be reached
+nobreak="pc = \$fffffe"
+
+for feature in profile sample history breakpoint "profile+history" "all"; do
+	case $feature in
+		profile)	 speed=$(run_speed "profile on") ;;
+		sample)		 speed=$(run_speed "profile sample 1000") ;;
+		history)	 speed=$(run_speed "history cpu") ;;
+		breakpoint)	 speed=$(run_speed "b $nobreak") ;;
+		profile+history) speed=$(run_speed "profile on" "history cpu") ;;
+		all)		 speed=$(run_speed "profile on" "history cpu" "b $nobreak") ;;
+	esac
+	if [ -z "$speed" ]; then
+		printf "%-24s %10s\n" "$feature" "FAILED"
+		continue
+	fi
+	printf "%-24s %10s %9.2fx\n" "$feature" "$speed" \
+		"$(echo "$base $speed" | awk '{print $1 / $2}')"
+done
@@ -117,6 +117,8 @@ int main(int argc, const char *argv[])
 		"pc < $50000 && pc > $60000",
 		"pc > $50000 && pc < $54000",
 		"d0 = a0",
+		"pc = $58002",     /* PC address index */
+		"d0 = 4 && pc = $50000",
 		"a0 = pc :trace",  /* matches, but :trace should hide that */
 		"a0 = pc :3",      /* matches, but not yet */
 		NULL
@@ -127,6 +129,8 @@ int main(int argc, const char *argv[])
 		"pc > $50000 && pc < $60000",
 		"d0 = d1 :once :quiet",
 		"a0 = pc",	   /* tested alone */
+		"d0 = 4 && pc = $58000",
+		"pc = $58000",	   /* only PC address index */
 		NULL
 	};
 	const char *test;
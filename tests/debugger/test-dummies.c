@@ -7,6 +7,9 @@
 #include "log.h"
 Uint64 LogTraceFlags = 0;
 FILE *TraceFile;
+bool LogTraceBinary = false;
+int TraceBuf_Printf(const char *format, ...) { return 0; }
+bool Log_TracePointCheck(trace_point_t *point, Uint64 level) { return false; }
 
 /* fake Hatari configuration variables for number parsing */
 #include "configuration.h"
@@ -163,6 +166,17 @@ bool Profile_CpuStart(void) { return false; }
 void Profile_CpuUpdate(void) { }
 void Profile_CpuStop(void) { }
 
+/* fake full CPU history */
+#include "historycpu.h"
+bool HistoryCpu_Active;
+void HistoryCpu_Add(void) { }
+bool HistoryCpu_Enable(int megabytes, const char *filename) { return false; }
+bool HistoryCpu_Load(const char *filename) { return false; }
+void HistoryCpu_Disable(void) { }
+void HistoryCpu_Show(FILE *fp, Uint32 count) { }
+void HistoryCpu_ShowWriter(Uint32 addr) { }
+void HistoryCpu_InstallHooks(void) { }
+
 /* fake Hatari video variables */
 #include "screen.h"
 #include "video.h"
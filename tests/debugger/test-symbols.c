@@ -2,6 +2,7 @@
  * Code to test Hatari symbol/address (re-)loading in src/debug/symbols.c
  */
 #include <stdio.h>
+#include <string.h>
 #include <SDL_types.h>
 #include <stdbool.h>
 #include "debug_priv.h"
@@ -29,15 +30,39 @@ int main(int argc, const char *argv[])
 		0x14,
 		0x28,
 	};
+	/* expected TEXT symbols at or before given addresses */
+	Uint32 before_addr[] = {
+		0xdffffe,
+		0xe5d444,
+		0xe5d446,
+		0xe5d87e,
+		0xe8bc00,
+	};
+	const char *before_name[] = {
+		NULL,
+		"_vdi_v_gdp",
+		"_vdi_v_gdp",
+		"_vdi_v_gdp",
+		"__etext",
+	};
+	Uint32 before_match[] = {
+		0,
+		0xe5d444,
+		0xe5d444,
+		0xe5d444,
+		0xe8bb90,
+	};
 
 #define DO_CMD(cmd) Symbols_Command(ARRAY_SIZE(cmd), cmd)
 	char symbols[] = "symbols";
 	char fname[] = "data/os-header.sym";
+	char fetos[] = "data/etos1024k.sym";
 	char sname[] = "name";
 	char scode[] = "code";
 	char sdata[] = "data";
 	char sfree[] = "free";
 	char *cmd_load[] = { symbols, fname };
+	char *cmd_load_etos[] = { symbols, fetos };
 	char *cmd_free[] = { symbols, sfree };
 	char *cmd_show_byname[] = { symbols, sname };
 	char *cmd_show_bycode[] = { symbols, scode };
@@ -99,6 +124,31 @@ int main(int argc, const char *argv[])
 	}
 	tests += i;
 
+	/* larger symbol set, for which address page index is used */
+	DO_CMD(cmd_load_etos);
+	fprintf(stderr, "\nTEXT symbol lookups within / between address pages:\n");
+	for (i = 0; i < ARRAY_SIZE(before_addr); i++) {
+		addr = before_addr[i];
+		name = Symbols_GetBeforeCpuAddress(&addr);
+		if ((name == NULL) != (before_name[i] == NULL) ||
+		    (name && (strcmp(name, before_name[i]) != 0 || addr != before_match[i]))) {
+			fprintf(stderr, "*** Unexpected result for 0x%08x: %s (0x%08x) ***\n",
+				before_addr[i], name ? name : "(none)", addr);
+			errors++;
+		} else {
+			fprintf(stderr, "- 0x%08x: %s\n", before_addr[i], name ? name : "(none)");
+		}
+	}
+	tests += i;
+	if (Symbols_GetCpuAddress(SYMTYPE_TEXT, "_vdi_v_gdp", &addr) && addr == 0xe5d444 &&
+	    Symbols_GetCpuCodeIndex(addr) >= 0 && Symbols_GetCpuCodeIndex(0xe5d446) < 0) {
+		fprintf(stderr, "- '_vdi_v_gdp' <-> 0x%08x\n", addr);
+	} else {
+		fprintf(stderr, "*** Unexpected FAIL from '_vdi_v_gdp' ***\n");
+		errors++;
+	}
+	tests++;
+
 	DO_CMD(cmd_free);
 	if (errors) {
 		fprintf(stderr, "\n***Detected %d ERRORs in %d automated tests!***\n\n",
@@ -0,0 +1,160 @@
+; Test that data written through one GEMDOS file handle is seen when
+; reading the same file through another file handle, although Hatari's
+; GEMDOS HD emulation buffers the writes and reads ahead.
+; Assemble this code with TurboAss.
+
+	movea.l 4(SP),A5        ; Get pointer to basepage
+	move.l  $0C(A5),D0      ; Text segment length
+	add.l   $14(A5),D0      ; Data segment length
+	add.l   $1C(A5),D0      ; BSS segment length
+	add.l   #$0800,D0       ; Space for the stack
+
+	move.l  D0,D1
+	add.l   A5,D1
+	and.l   #-2,D1
+
+	movea.l D1,SP
+	move.l  D0,-(SP)
+	move.l  A5,-(SP)
+	clr.w   -(SP)
+	move.w  #$4A,-(SP)
+	trap    #1              ; Mshrink
+	lea     12(SP),SP
+
+	pea     title(PC)
+	move.w  #9,-(SP)
+	trap    #1              ; Cconws
+	addq.l  #6,SP
+
+	clr.w   -(SP)
+	pea     fname(PC)
+	move.w  #$3C,-(SP)
+	trap    #1              ; Fcreate
+	addq.l  #8,SP
+	move.w  D0,D6           ; D6 = write handle
+	bmi     fail
+
+	lea     data_a(PC),A4
+	bsr     write4
+	bsr     write4          ; "AAAAAAAA", still buffered
+
+	clr.w   -(SP)
+	pea     fname(PC)
+	move.w  #$3D,-(SP)
+	trap    #1              ; Fopen, read-only
+	addq.l  #8,SP
+	move.w  D0,D7           ; D7 = read handle
+	bmi     fail
+
+	move.l  data_a(PC),D5
+	bsr     readchk         ; host reads ahead rest of the file
+
+	clr.w   -(SP)
+	move.w  D6,-(SP)
+	move.l  #4,-(SP)
+	move.w  #$42,-(SP)
+	trap    #1              ; Fseek(4, D6, 0)
+	lea     10(SP),SP
+	cmp.l   #4,D0
+	bne     fail
+
+	lea     data_b(PC),A4
+	bsr     write4          ; overwrite "AAAA" already read ahead
+	move.l  data_b(PC),D5
+	bsr     readchk
+
+	lea     data_c(PC),A4
+	bsr     write4          ; append beyond the old end of file
+	move.l  data_c(PC),D5
+	bsr     readchk
+
+	move.w  D7,-(SP)
+	move.w  #$3E,-(SP)
+	trap    #1              ; Fclose
+	addq.l  #4,SP
+
+	move.w  D6,-(SP)
+	move.w  #$3E,-(SP)
+	trap    #1              ; Fclose
+	addq.l  #4,SP
+
+	pea     fname(PC)
+	move.w  #$41,-(SP)
+	trap    #1              ; Fdelete
+	addq.l  #6,SP
+
+	pea     msg_ok(PC)
+	move.w  #9,-(SP)
+	trap    #1              ; Cconws
+	addq.l  #6,SP
+
+	clr.w   -(SP)
+	trap    #1              ; Pterm0
+
+fail:
+	pea     msg_fail(PC)
+	move.w  #9,-(SP)
+	trap    #1              ; Cconws
+	addq.l  #6,SP
+
+	move.w  #1,-(SP)
+	move.w  #$4C,-(SP)
+	trap    #1              ; Pterm
+
+
+; Write 4 bytes from (A4) to handle D6
+write4:
+	move.l  A4,-(SP)
+	move.l  #4,-(SP)
+	move.w  D6,-(SP)
+	move.w  #$40,-(SP)
+	trap    #1              ; Fwrite
+	lea     12(SP),SP
+	cmp.l   #4,D0
+	bne     fail
+	rts
+
+; Read 4 bytes from handle D7 and check that they match D5
+readchk:
+	pea     buf(PC)
+	move.l  #4,-(SP)
+	move.w  D7,-(SP)
+	move.w  #$3F,-(SP)
+	trap    #1              ; Fread
+	lea     12(SP),SP
+	cmp.l   #4,D0
+	bne     fail
+	cmp.l   buf(PC),D5
+	bne     fail
+	rts
+
+
+	DATA
+
+data_a:
+	DC.B "AAAA"
+data_b:
+	DC.B "BBBB"
+data_c:
+	DC.B "CCCC"
+
+fname:
+	DC.B "SHAREDFH.DAT",0
+
+title:
+	DC.B "Test 'shared file'",9,": ",0
+
+msg_ok:
+	DC.B " OK",13,10,0
+
+msg_fail:
+	DC.B " FAILED",13,10,0
+
+	EVEN
+
+	BSS
+
+buf:
+	DS.L 1
+
+	END
@@ -0,0 +1,264 @@
+/*
+ * Hatari - trace2ascii.c
+ *
+ * This file is distributed under the GNU General Public License, version 2
+ * or at your option any later version. Read the file gpl.txt for details.
+ *
+ * Convert binary trace event file saved by Hatari "--trace-bin" option
+ * to the same text output that normal tracing produces.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "../../src/debug/tracebuf.h"
+#include "../../src/debug/tracebuf-common.c"
+
+#define MAX_FORMATS 0x10000
+
+static char *formats[MAX_FORMATS];
+
+static void usage(const char *name, const char *error)
+{
+	fprintf(stderr,
+		"\n"
+		"Usage: %s [options] <trace file>\n"
+		"\n"
+		"Convert binary trace event file saved with the Hatari\n"
+		"'--trace-bin' option to normal trace output text.\n"
+		"\n"
+		"Options:\n"
+		"\t-c\tprefix each event with its emulated cycle count\n"
+		"\n", name);
+	if (error)
+		fprintf(stderr, "ERROR: %s!\n", error);
+	exit(1);
+}
+
+/**
+ * Print a single printf conversion 'spec' with its '*' arguments
+ * 'stars' (count given in 'nstars') and value.
+ */
+#define PRINT_CONVERSION(value) \
+	switch (nstars) { \
+	case 0: printf(spec, value); break; \
+	case 1: printf(spec, stars[0], value); break; \
+	default: printf(spec, stars[0], stars[1], value); break; \
+	}
+
+/**
+ * Print one argument of given type from event data at *data,
+ * advance *data past it.  Return false if data runs out.
+ */
+static bool print_arg(const char *spec, int type, const int *stars, int nstars,
+                      const uint8_t **data, const uint8_t *end)
+{
+	int64_t val;
+	double dval;
+	uint32_t len;
+	char *str;
+
+	if (type == TRACEBUF_ARG_NONE)
+	{
+		printf("%%");
+		return true;
+	}
+	if (*data + 8 > end && !(type == TRACEBUF_ARG_STR && *data + 4 <= end))
+		return false;
+
+	if (type == TRACEBUF_ARG_STR)
+	{
+		memcpy(&len, *data, sizeof(len));
+		if (len == TRACEBUF_STR_NULL)
+		{
+			*data += TRACEBUF_ALIGN(sizeof(len));
+			str = NULL;
+			PRINT_CONVERSION(str);
+			return true;
+		}
+		if (*data + sizeof(len) + len > end)
+			return false;
+		str = malloc(len + 1);
+		if (!str)
+			return false;
+		memcpy(str, *data + sizeof(len), len);
+		str[len] = '\0';
+		*data += TRACEBUF_ALIGN(sizeof(len) + len);
+		PRINT_CONVERSION(str);
+		free(str);
+		return true;
+	}
+
+	memcpy(&val, *data, sizeof(val));
+	memcpy(&dval, *data, sizeof(dval));
+	*data += 8;
+	switch (type)
+	{
+	case TRACEBUF_ARG_INT:
+		PRINT_CONVERSION((int)val);
+		break;
+	case TRACEBUF_ARG_LONG:
+		PRINT_CONVERSION((long)val);
+		break;
+	case TRACEBUF_ARG_LLONG:
+		PRINT_CONVERSION((long long)val);
+		break;
+	case TRACEBUF_ARG_SIZE:
+		PRINT_CONVERSION((size_t)val);
+		break;
+	case TRACEBUF_ARG_INTMAX:
+		PRINT_CONVERSION((intmax_t)val);
+		break;
+	case TRACEBUF_ARG_PTRDIFF:
+		PRINT_CONVERSION((ptrdiff_t)val);
+		break;
+	case TRACEBUF_ARG_DOUBLE:
+		PRINT_CONVERSION(dval);
+		break;
+	case TRACEBUF_ARG_LDOUBLE:
+		PRINT_CONVERSION((long double)dval);
+		break;
+	case TRACEBUF_ARG_PTR:
+		PRINT_CONVERSION((void *)(uintptr_t)val);
+		break;
+	}
+	return true;
+}
+
+/**
+ * Print event using given format and its argument data.
+ * Return false if event data does not match the format.
+ */
+static bool print_event(const char *format, const uint8_t *data, const uint8_t *end)
+{
+	const char *conv, *next = format;
+	int args[3], nargs, stars[2], nstars, i;
+	char spec[64];
+
+	while ((conv = TraceBuf_NextConversion(next, &next, args, &nargs)))
+	{
+		fwrite(format, conv - format, 1, stdout);
+		format = next;
+		if (nargs == 0 && next[-1] != '%')
+		{
+			/* incomplete conversion at the end */
+			fputs(conv, stdout);
+			continue;
+		}
+		if (next - conv >= (int)sizeof(spec))
+			return false;
+		memcpy(spec, conv, next - conv);
+		spec[next - conv] = '\0';
+
+		nstars = 0;
+		for (i = 0; i + 1 < nargs; i++)
+		{
+			int64_t val;
+			if (data + 8 > end)
+				return false;
+			memcpy(&val, data, sizeof(val));
+			stars[nstars++] = val;
+			data += 8;
+		}
+		if (!print_arg(spec, nargs ? args[nargs-1] : TRACEBUF_ARG_NONE,
+		               stars, nstars, &data, end))
+			return false;
+	}
+	fputs(format, stdout);
+	return true;
+}
+
+int main(int argc, const char *argv[])
+{
+	tracebuf_rec_t hdr;
+	uint8_t *data = NULL;
+	size_t datasize = 0;
+	char magic[8];
+	uint32_t byteorder;
+	bool cycles = false, linestart = true;
+	const char *name = argv[0];
+	FILE *fp;
+	int i;
+
+	for (i = 1; i < argc && argv[i][0] == '-' && argv[i][1]; i++)
+	{
+		if (strcmp(argv[i], "-c") == 0)
+			cycles = true;
+		else
+			usage(name, "unknown option");
+	}
+	if (i != argc - 1)
+		usage(name, "trace file missing");
+
+	fp = fopen(argv[i], "rb");
+	if (!fp)
+		usage(name, "opening the trace file failed");
+	if (fread(magic, sizeof(magic), 1, fp) != 1 ||
+	    memcmp(magic, TRACEBUF_MAGIC, sizeof(magic)) != 0 ||
+	    fread(&byteorder, sizeof(byteorder), 1, fp) != 1)
+		usage(name, "not a Hatari binary trace file");
+	if (byteorder != TRACEBUF_BYTEORDER)
+		usage(name, "trace file is from a host with different byte order");
+
+	while (fread(&hdr, sizeof(hdr), 1, fp) == 1)
+	{
+		size_t size;
+
+		if (hdr.size < sizeof(hdr) || hdr.size % 8)
+		{
+			fprintf(stderr, "ERROR: invalid record size %u\n", hdr.size);
+			return 1;
+		}
+		size = hdr.size - sizeof(hdr);
+		if (size > datasize)
+		{
+			data = realloc(data, size);
+			if (!data)
+			{
+				perror("realloc");
+				return 1;
+			}
+			datasize = size;
+		}
+		if (size && fread(data, size, 1, fp) != 1)
+		{
+			fprintf(stderr, "ERROR: truncated trace file\n");
+			return 1;
+		}
+
+		if (hdr.type == TRACEBUF_REC_FORMAT)
+		{
+			if (!size || data[size-1] != '\0')
+			{
+				fprintf(stderr, "ERROR: invalid format record\n");
+				return 1;
+			}
+			free(formats[hdr.id]);
+			formats[hdr.id] = strdup((char *)data);
+			continue;
+		}
+		if (hdr.type != TRACEBUF_REC_EVENT || !formats[hdr.id])
+		{
+			fprintf(stderr, "ERROR: unknown record type %d / format %d\n",
+				hdr.type, hdr.id);
+			return 1;
+		}
+		/* events can also be partial lines */
+		if (cycles && linestart)
+			printf("[%" PRIu64 "] ", hdr.cycles);
+		if (!print_event(formats[hdr.id], data, data + size))
+		{
+			fprintf(stderr, "ERROR: event data does not match format %d\n", hdr.id);
+			return 1;
+		}
+		linestart = formats[hdr.id][0] &&
+			formats[hdr.id][strlen(formats[hdr.id]) - 1] == '\n';
+	}
+	fclose(fp);
+	free(data);
+	return 0;
+}